@@ -1,7 +1,9 @@
 #include <errno.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "bignum.h"
+#include "bignum_internal.h"
 
 int
 bigint_view(bigint *int_, int sign, uint32_t *digits, size_t ndigits)
@@ -97,6 +99,134 @@ bigint_copy(bigint *dst, bigint src)
 	return bigint_init(dst, src.sign, src.abs.digits, src.abs.ndigits);
 }
 
+/*
+ * 先頭に符号'+'か'-'を1つ付けてもよい点を除いてbignat_from_strnと同じ。
+ * "-0"は0になる。
+ */
+int
+bigint_from_strn(bigint *int_, const char *str, size_t len, int base)
+{
+	int sign = 1;
+
+	if (len > 0 && (str[0] == '+' || str[0] == '-')) {
+		sign = str[0] == '-' ? -1 : 1;
+		str++;
+		len--;
+	}
+
+	bignat abs;
+	int err = bignat_from_strn(&abs, str, len, base);
+	if (err != 0) {
+		return err;
+	}
+
+	*int_ = (bigint){
+		.sign=abs.ndigits == 0 ? 0 : sign,
+		.abs=abs
+	};
+	return 0;
+}
+
+int
+bigint_from_str(bigint *int_, const char *str, int base)
+{
+	return bigint_from_strn(int_, str, strlen(str), base);
+}
+
+/* 負の数では符号'-'の分だけbignat_str_sizeより大きい。 */
+size_t
+bigint_str_size(bigint x, int base)
+{
+	size_t size = bignat_str_size(x.abs, base);
+
+	return size != 0 && x.sign < 0 ? size + 1 : size;
+}
+
+/* 負の数に符号'-'を付ける点を除いてbignat_to_strと同じ。 */
+int
+bigint_to_str(char *str, size_t size, bigint x, int base)
+{
+	if (x.sign >= 0) {
+		return bignat_to_str(str, size, x.abs, base);
+	}
+
+	if (base < 2 || base > 36) {
+		return EINVAL;
+	}
+
+	if (size < bigint_str_size(x, base)) {
+		return ERANGE;
+	}
+
+	str[0] = '-';
+	return bignat_to_str(str + 1, size - 1, x.abs, base);
+}
+
+size_t
+bigint_export_size(bigint x)
+{
+	return bignat_export_size(x.abs);
+}
+
+/* 負の数でタグの最下位ビットを立てる点を除いてbignat_exportと同じ。 */
+int
+bigint_export(void *buf, size_t size, bigint x)
+{
+	int err = bignat_export(buf, size, x.abs);
+	if (err != 0) {
+		return err;
+	}
+
+	if (x.sign < 0) {
+		*(uint8_t *)buf |= 1;
+	}
+	return 0;
+}
+
+/*
+ * 負の数の記録も読める点を除いてbignat_importと同じ。
+ */
+int
+bigint_import(bigint *int_, size_t *len, const void *buf, size_t size)
+{
+	bignat abs;
+	int sign;
+	int err;
+
+	err = bignat_import_record(&abs, &sign, len, buf, size, false);
+	if (err != 0) {
+		return err;
+	}
+
+	*int_ = (bigint){
+		.sign=sign,
+		.abs=abs
+	};
+	return 0;
+}
+
+/*
+ * 負の数の記録も読める点を除いてbignat_import_viewと同じ。
+ */
+int
+bigint_import_view(bigint *int_, size_t *len, void *buf, size_t size)
+{
+	bignat abs;
+	int sign;
+	int err;
+
+	err = bignat_import_record(&abs, &sign, len, buf, size, true);
+	if (err != 0) {
+		return err;
+	}
+
+	*int_ = (bigint){
+		.sign=sign,
+		.abs=abs
+	};
+	return 0;
+}
+
 void
 bigint_del(bigint int_)
 {
@@ -216,6 +346,16 @@ bigint_add(bigint *sum, bigint x, bigint y)
 	return 0;
 }
 
+int
+bigint_add_digit(bigint *sum, bigint x, int32_t y)
+{
+	uint32_t abs = y < 0 ? (int64_t)y * -1 : y;
+	bigint y_view;
+
+	(void)bigint_view(&y_view, y < 0 ? -1 : y > 0, &abs, y != 0);
+	return bigint_add(sum, x, y_view);
+}
+
 int
 bigint_sub(bigint *diff, bigint x, bigint y)
 {
@@ -227,6 +367,16 @@ bigint_sub(bigint *diff, bigint x, bigint y)
 	return bigint_add(diff, x, neg_y);
 }
 
+int
+bigint_sub_digit(bigint *diff, bigint x, int32_t y)
+{
+	uint32_t abs = y < 0 ? (int64_t)y * -1 : y;
+	bigint neg_y_view;
+
+	(void)bigint_view(&neg_y_view, y < 0 ? 1 : -(y > 0), &abs, y != 0);
+	return bigint_add(diff, x, neg_y_view);
+}
+
 int
 bigint_mul(bigint *prod, bigint x, bigint y)
 {
@@ -245,6 +395,140 @@ bigint_mul(bigint *prod, bigint x, bigint y)
 	return 0;
 }
 
+int
+bigint_mul_digit(bigint *prod, bigint x, int32_t y)
+{
+	int err;
+	bignat abs;
+
+	err = bignat_mul_digit(&abs, x.abs, y < 0 ? (int64_t)y * -1 : y);
+	if (err != 0) {
+		return err;
+	}
+
+	*prod = (bigint){
+		.sign=abs.ndigits != 0 ? x.sign * (y < 0 ? -1 : 1) : 0,
+		.abs=abs
+	};
+	return 0;
+}
+
+int
+bigint_sqr(bigint *sq, bigint x)
+{
+	int err;
+	bignat abs;
+
+	err = bignat_sqr(&abs, x.abs);
+	if (err != 0) {
+		return err;
+	}
+
+	*sq = (bigint){
+		.sign=x.sign * x.sign,
+		.abs=abs
+	};
+	return 0;
+}
+
+int
+bigint_add_into(bigint *sum, bigint x, bigint y)
+{
+	int err;
+
+	if (x.sign * y.sign >= 0) {
+		err = bignat_add_into(&sum->abs, x.abs, y.abs);
+		if (err != 0) {
+			return err;
+		}
+
+		sum->sign = x.sign != 0 ? x.sign : y.sign;
+		return 0;
+	}
+
+	if (bignat_lt(x.abs, y.abs)) {
+		bigint t = x;
+		x = y;
+		y = t;
+	}
+
+	/* |x| >= |y| */
+
+	err = bignat_sub_into(&sum->abs, x.abs, y.abs);
+	if (err != 0) {
+		return err;
+	}
+
+	sum->sign = sum->abs.ndigits != 0 ? x.sign : 0;
+	return 0;
+}
+
+int
+bigint_sub_into(bigint *diff, bigint x, bigint y)
+{
+	bigint neg_y = {
+		.sign=y.sign * -1,
+		.abs=y.abs
+	};
+
+	return bigint_add_into(diff, x, neg_y);
+}
+
+int
+bigint_mul_into(bigint *prod, bigint x, bigint y)
+{
+	int err;
+
+	err = bignat_mul_into(&prod->abs, x.abs, y.abs);
+	if (err != 0) {
+		/* 失敗してabsが0になった場合に合わせる */
+		prod->sign = prod->abs.ndigits != 0 ? prod->sign : 0;
+		return err;
+	}
+
+	prod->sign = x.sign * y.sign;
+	return 0;
+}
+
+int
+bigint_divtrn_into(bigint *quot, bigint *rem, bigint x, bigint y)
+{
+	int err;
+	/* quot, remがx, yと同じでもよいように、符号は先に求めておく */
+	int qsign = x.sign * y.sign;
+	int rsign = x.sign;
+
+	err = bignat_divmod_into(&quot->abs, &rem->abs, x.abs, y.abs);
+	if (err != 0) {
+		/* 失敗してabsが0になった場合に合わせる */
+		quot->sign = quot->abs.ndigits != 0 ? quot->sign : 0;
+		rem->sign = rem->abs.ndigits != 0 ? rem->sign : 0;
+		return err;
+	}
+
+	quot->sign = quot->abs.ndigits != 0 ? qsign : 0;
+	rem->sign = rem->abs.ndigits != 0 ? rsign : 0;
+	return 0;
+}
+
+int
+bigint_add_inplace(bigint *acc, bigint x)
+{
+	return bigint_add_into(acc, *acc, x);
+}
+
+int
+bigint_sub_inplace(bigint *acc, bigint x)
+{
+	return bigint_sub_into(acc, *acc, x);
+}
+
+int
+bigint_mul_inplace(bigint *acc, bigint x)
+{
+	return bigint_mul_into(acc, *acc, x);
+}
+
 int
 bigint_divtrn(bigint *quot, bigint *rem, bigint x, bigint y)
 {
@@ -269,6 +553,29 @@ bigint_divtrn(bigint *quot, bigint *rem, bigint x, bigint y)
 	return 0;
 }
 
+int
+bigint_divtrn_digit(bigint *quot, int32_t *rem, bigint x, int32_t y)
+{
+	int err;
+	bignat absq;
+	uint32_t absr;
+
+	err = bignat_divmod_digit(&absq, &absr, x.abs,
+				  y < 0 ? (int64_t)y * -1 : y);
+	if (err != 0) {
+		return err;
+	}
+
+	*quot = (bigint){
+		.sign=absq.ndigits != 0 ? x.sign * (y < 0 ? -1 : 1) : 0,
+		.abs=absq
+	};
+
+	*rem = (int64_t)absr * x.sign;
+
+	return 0;
+}
+
 int
 bigint_divflr(bigint *quot, bigint *rem, bigint x, bigint y)
 {
@@ -372,3 +679,171 @@ fail:
 	bigint_del(adj_rem);
 	return err;
 }
+
+/*
+ * gcd = s * x + t * y を満たすgcd >= 0とs, tを求める。|s| < |y| / gcd。
+ */
+int
+bigint_gcdext(bigint *gcd, bigint *s, bigint *t, bigint x, bigint y)
+{
+	int err;
+	bignat absg = bignat_new_zero();
+	bignat abss = bignat_new_zero();
+	bigint tmp_t = bigint_new_zero();
+	bigint prod = bigint_new_zero();
+	bigint diff = bigint_new_zero();
+	bigint rem = bigint_new_zero();
+
+	err = bignat_gcdext(&absg, &abss, x.abs, y.abs);
+	if (err != 0) {
+		return err;
+	}
+
+	bigint tmp_gcd = {
+		.sign=absg.ndigits != 0 ? 1 : 0,
+		.abs=absg
+	};
+	bigint tmp_s = {
+		.sign=abss.ndigits != 0 ? x.sign : 0,
+		.abs=abss
+	};
+
+	if (y.sign != 0) {
+		/* t = (gcd - s * x) / y は割り切れる */
+		err = bigint_mul(&prod, tmp_s, x);
+		if (err != 0) {
+			goto fail;
+		}
+
+		err = bigint_sub(&diff, tmp_gcd, prod);
+		if (err != 0) {
+			goto fail;
+		}
+
+		err = bigint_divtrn(&tmp_t, &rem, diff, y);
+		if (err != 0) {
+			goto fail;
+		}
+	}
+
+	bigint_del(prod);
+	bigint_del(diff);
+	bigint_del(rem);
+	*gcd = tmp_gcd;
+	*s = tmp_s;
+	*t = tmp_t;
+	return 0;
+
+fail:
+	bigint_del(tmp_gcd);
+	bigint_del(tmp_s);
+	bigint_del(tmp_t);
+	bigint_del(prod);
+	bigint_del(diff);
+	bigint_del(rem);
+	return err;
+}
+
+/*
+ * x * inv ≡ 1 (mod m)、0 <= inv < |m| を満たすinvを求める。xとmが互い
+ * に素でないか、mが0の場合はEDOMを返す。
+ */
+int
+bigint_invmod(bigint *inv, bigint x, bigint m)
+{
+	int err;
+	bignat g = bignat_new_zero();
+	bignat s = bignat_new_zero();
+	bignat abs = bignat_new_zero();
+
+	if (m.sign == 0) {
+		return EDOM;
+	}
+
+	err = bignat_gcdext(&g, &s, x.abs, m.abs);
+	if (err != 0) {
+		return err;
+	}
+
+	if (g.ndigits != 1 || g.digits[0] != 1) {
+		err = EDOM;
+		goto fail;
+	}
+
+	if (x.sign == -1 && s.ndigits != 0) {
+		err = bignat_sub(&abs, m.abs, s);
+		if (err != 0) {
+			goto fail;
+		}
+		bignat_del(s);
+	} else {
+		abs = s;
+	}
+
+	bignat_del(g);
+	*inv = (bigint){
+		.sign=abs.ndigits != 0 ? 1 : 0,
+		.abs=abs
+	};
+	return 0;
+
+fail:
+	bignat_del(g);
+	bignat_del(s);
+	return err;
+}
+
+/*
+ * powm = base^exp mod |mod|、0 <= powm < |mod|。expが負の場合はbaseの
+ * 逆元のべき乗を求める。modが0の場合や逆元が存在しない場合はEDOMを返
+ * す。
+ */
+int
+bigint_powm(bigint *powm, bigint base, bigint exp, bigint mod)
+{
+	int err;
+	bigint inv = bigint_new_zero();
+	bignat abs = bignat_new_zero();
+
+	if (mod.sign == 0) {
+		return EDOM;
+	}
+
+	if (exp.sign == -1) {
+		err = bigint_invmod(&inv, base, mod);
+		if (err != 0) {
+			return err;
+		}
+		base = inv;
+	}
+
+	err = bignat_powm(&abs, base.abs, exp.abs, mod.abs);
+	if (err != 0) {
+		goto fail;
+	}
+
+	/* 負の数の奇数乗は負なので、法を足して正にする */
+	if (base.sign == -1 && exp.sign != 0 &&
+	    (exp.abs.digits[0] & 1) != 0 && abs.ndigits != 0) {
+		bignat adj;
+
+		err = bignat_sub(&adj, mod.abs, abs);
+		if (err != 0) {
+			goto fail;
+		}
+		bignat_del(abs);
+		abs = adj;
+	}
+
+	bigint_del(inv);
+	*powm = (bigint){
+		.sign=abs.ndigits != 0 ? 1 : 0,
+		.abs=abs
+	};
+	return 0;
+
+fail:
+	bigint_del(inv);
+	bignat_del(abs);
+	return err;
+}
@@ -1,434 +1,6027 @@
 #include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "bignum.h"
+#include "bignum_internal.h"
 
 #define countof(a) (sizeof(a) / sizeof((a)[0]))
 #define min(x, y) ((x) < (y) ? (x) : (y))
+#define max(x, y) ((x) > (y) ? (x) : (y))
 
-static void
-bignat_norm(bignat *nat)
+/*
+ * 乗算のアルゴリズムを切り替える桁数。両方の被演算子がこの桁数以上の場
+ * 合にKaratsuba法を用いる。
+ */
+#ifndef BIGNAT_KARATSUBA_THRESHOLD
+#define BIGNAT_KARATSUBA_THRESHOLD 32
+#endif
+#if BIGNAT_KARATSUBA_THRESHOLD < 2
+#error "BIGNAT_KARATSUBA_THRESHOLD must be at least 2"
+#endif
+
+/* 平方の場合にKaratsuba法を用いる桁数。 */
+#ifndef BIGNAT_SQR_KARATSUBA_THRESHOLD
+#define BIGNAT_SQR_KARATSUBA_THRESHOLD 48
+#endif
+#if BIGNAT_SQR_KARATSUBA_THRESHOLD < 2
+#error "BIGNAT_SQR_KARATSUBA_THRESHOLD must be at least 2"
+#endif
+
+/*
+ * 短い方の被演算子がこの桁数以上の場合にToom-Cook法(3分割)を、
+ * BIGNAT_TOOM4_THRESHOLD以上の場合は4分割を用いる。
+ */
+#ifndef BIGNAT_TOOM3_THRESHOLD
+#define BIGNAT_TOOM3_THRESHOLD 160
+#endif
+
+#ifndef BIGNAT_TOOM4_THRESHOLD
+#define BIGNAT_TOOM4_THRESHOLD 400
+#endif
+
+/*
+ * 短い方の被演算子がこの桁数以上の場合に数論変換(NTT)による乗算を用い
+ * る。
+ */
+#ifndef BIGNAT_NTT_THRESHOLD
+#define BIGNAT_NTT_THRESHOLD 2500
+#endif
+
+/*
+ * 除数と商がともにこの桁数以上の場合に分割統治法(Burnikel-Ziegler法)で
+ * 除算する。
+ */
+#ifndef BIGNAT_DC_DIV_THRESHOLD
+#define BIGNAT_DC_DIV_THRESHOLD 48
+#endif
+#if BIGNAT_DC_DIV_THRESHOLD < 4
+#error "BIGNAT_DC_DIV_THRESHOLD must be at least 4"
+#endif
+
+/*
+ * 除数と商がともにこの桁数以上の場合に、Newton法で求めた除数の逆数を
+ * 使って除算する。逆数そのものはBIGNAT_INV_NEWTON_THRESHOLD桁以上の場
+ * 合にNewton法で求め、それ未満では除算で求める。
+ */
+#ifndef BIGNAT_NEWTON_DIV_THRESHOLD
+#define BIGNAT_NEWTON_DIV_THRESHOLD 6000
+#endif
+
+#ifndef BIGNAT_INV_NEWTON_THRESHOLD
+#define BIGNAT_INV_NEWTON_THRESHOLD 400
+#endif
+#if BIGNAT_INV_NEWTON_THRESHOLD < 2
+#error "BIGNAT_INV_NEWTON_THRESHOLD must be at least 2"
+#endif
+
+/*
+ * BIGNAT_GCD_HGCD_THRESHOLD桁以上のGCDでは、half-GCDを使ってa, bを小さ
+ * くする。half-GCDはBIGNAT_HGCD_THRESHOLD桁以上の場合に再帰する。
+ */
+#ifndef BIGNAT_HGCD_THRESHOLD
+#define BIGNAT_HGCD_THRESHOLD 60
+#endif
+#if BIGNAT_HGCD_THRESHOLD < 4
+#error "BIGNAT_HGCD_THRESHOLD must be at least 4"
+#endif
+
+#ifndef BIGNAT_GCD_HGCD_THRESHOLD
+#define BIGNAT_GCD_HGCD_THRESHOLD 400
+#endif
+#if BIGNAT_GCD_HGCD_THRESHOLD < 3
+#error "BIGNAT_GCD_HGCD_THRESHOLD must be at least 3"
+#endif
+
+/*
+ * 文字列を基数変換する際、結果がこの桁数以上になる場合に分割統治法を用
+ * いる。
+ */
+#ifndef BIGNAT_FROM_STR_DC_THRESHOLD
+#define BIGNAT_FROM_STR_DC_THRESHOLD 20
+#endif
+#if BIGNAT_FROM_STR_DC_THRESHOLD < 2
+#error "BIGNAT_FROM_STR_DC_THRESHOLD must be at least 2"
+#endif
+
+/* 文字列に変換する数がこの桁数以上の場合に分割統治法を用いる。 */
+#ifndef BIGNAT_TO_STR_DC_THRESHOLD
+#define BIGNAT_TO_STR_DC_THRESHOLD 30
+#endif
+#if BIGNAT_TO_STR_DC_THRESHOLD < 3
+#error "BIGNAT_TO_STR_DC_THRESHOLD must be at least 3"
+#endif
+
+/* digits */
+
+/*
+ * 以下のdigits_*関数は、下位の桁から並んだuint32_tの配列を直接操作する。
+ * 先行0を許し、長さは呼び出し側が管理する。
+ */
+
+/*
+ * 作業領域を確保する。解放するときに大きさを割り当て関数に渡せるよう、
+ * 領域の桁数を先頭に記録しておく。
+ */
+static uint32_t *
+digits_alloc(size_t n)
 {
-	while (nat->ndigits > 0 && nat->digits[nat->ndigits - 1] == 0) {
-		dgtvec_pop(nat);
+	bignum_allocator a;
+	size_t *p;
+
+	n += !n;
+	if (n > (SIZE_MAX - sizeof(size_t)) / sizeof(uint32_t)) {
+		return NULL;
 	}
-}
 
-int
-bignat_view(bignat *nat, uint32_t *digits, size_t ndigits)
-{
-	if (ndigits > 0 && digits[ndigits - 1] == 0) {
-		return EINVAL;
+	bignum_get_allocator(&a);
+	p = a.alloc(a.ctx, sizeof(size_t) + n * sizeof(uint32_t));
+	if (p == NULL) {
+		return NULL;
 	}
 
-	*nat = (bignat){
-		.digits=digits,
-		.ndigits=ndigits,
-		.cap=0
-	};
-	return 0;
+	*p = n;
+	return (uint32_t *)(p + 1);
 }
 
-int
-bignat_init(bignat *nat, uint32_t *digits, size_t ndigits)
+static void
+digits_free(uint32_t *p)
 {
-	if (ndigits > 0 && digits[ndigits - 1] == 0) {
-		return EINVAL;
+	if (p == NULL) {
+		return;
 	}
 
-	return dgtvec_init(nat, digits, ndigits);
-}
+	bignum_allocator a;
+	size_t *q = (size_t *)p - 1;
 
-bignat
-bignat_new_zero(void)
-{
-	return dgtvec_new_empty();
+	bignum_get_allocator(&a);
+	a.free(a.ctx, q, sizeof(size_t) + *q * sizeof(uint32_t));
 }
 
-static bignat
-bignat_view_from_digit(uint32_t *n)
+static int
+digits_cmp(const uint32_t *ap, const uint32_t *bp, size_t n)
 {
-	if (*n == 0) {
-		return bignat_new_zero();
+	for (size_t i = n - 1; i < n; i--) {
+		if (ap[i] != bp[i]) {
+			return ap[i] < bp[i] ? -1 : 1;
+		}
 	}
 
-	bignat nat;
-	(void)bignat_view(&nat, n, 1);
-	return nat;
+	return 0;
 }
 
-int
-bignat_from_digit(bignat *nat, uint32_t n)
+/* rp[0, n) = ap[0, n) + bp[0, n)。桁上がりを返す。 */
+static uint32_t
+digits_add_n(uint32_t *rp, const uint32_t *ap, const uint32_t *bp, size_t n)
 {
-	if (n == 0) {
-		return dgtvec_init(nat, NULL, 0);
+	uint32_t carry = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		uint64_t s = (uint64_t)ap[i] + bp[i] + carry;
+		rp[i] = s;
+		carry = s >> 32;
 	}
 
-	return dgtvec_init(nat, &n, 1);
+	return carry;
 }
 
-int
-bignat_copy(bignat *dst, bignat src)
+/* rp[0, n) = ap[0, n) + b。桁上がりを返す。 */
+static uint32_t
+digits_add_1(uint32_t *rp, const uint32_t *ap, size_t n, uint32_t b)
 {
-	return bignat_init(dst, src.digits, src.ndigits);
+	size_t i;
+
+	for (i = 0; i < n && b != 0; i++) {
+		uint64_t s = (uint64_t)ap[i] + b;
+		rp[i] = s;
+		b = s >> 32;
+	}
+
+	if (rp != ap) {
+		for (; i < n; i++) {
+			rp[i] = ap[i];
+		}
+	}
+
+	return b;
 }
 
-void
-bignat_del(bignat n)
+/* rp[0, an) = ap[0, an) + bp[0, bn)。an >= bn。桁上がりを返す。 */
+static uint32_t
+digits_add(uint32_t *rp, const uint32_t *ap, size_t an,
+	   const uint32_t *bp, size_t bn)
 {
-	dgtvec_del(n);
+	uint32_t carry = digits_add_n(rp, ap, bp, bn);
+	return digits_add_1(rp + bn, ap + bn, an - bn, carry);
 }
 
-int
-bignat_cmp(bignat x, bignat y)
+/* rp[0, n) = ap[0, n) - bp[0, n)。桁借りを返す。 */
+static uint32_t
+digits_sub_n(uint32_t *rp, const uint32_t *ap, const uint32_t *bp, size_t n)
 {
-	if (x.ndigits < y.ndigits) {
-		return -1;
-	}
+	uint32_t borrow = 0;
 
-	if (x.ndigits > y.ndigits) {
-		return 1;
+	for (size_t i = 0; i < n; i++) {
+		uint64_t d = (uint64_t)ap[i] - bp[i] - borrow;
+		rp[i] = d;
+		borrow = (d >> 32) & 1;
 	}
 
-	/* x.ndigits == y.ndigits */
+	return borrow;
+}
 
-	for (size_t i = x.ndigits - 1; i < x.ndigits; i--) {
-		if (x.digits[i] < y.digits[i]) {
-			return -1;
-		}
+/* rp[0, n) = ap[0, n) - b。桁借りを返す。 */
+static uint32_t
+digits_sub_1(uint32_t *rp, const uint32_t *ap, size_t n, uint32_t b)
+{
+	size_t i;
 
-		if (x.digits[i] > y.digits[i]) {
-			return 1;
+	for (i = 0; i < n && b != 0; i++) {
+		uint64_t d = (uint64_t)ap[i] - b;
+		rp[i] = d;
+		b = (d >> 32) & 1;
+	}
+
+	if (rp != ap) {
+		for (; i < n; i++) {
+			rp[i] = ap[i];
 		}
 	}
 
-	return 0;
+	return b;
 }
 
-bool
-bignat_eq(bignat x, bignat y)
+/* rp[0, an) = ap[0, an) - bp[0, bn)。an >= bn。桁借りを返す。 */
+static uint32_t
+digits_sub(uint32_t *rp, const uint32_t *ap, size_t an,
+	   const uint32_t *bp, size_t bn)
 {
-	return bignat_cmp(x, y) == 0;
+	uint32_t borrow = digits_sub_n(rp, ap, bp, bn);
+	return digits_sub_1(rp + bn, ap + bn, an - bn, borrow);
 }
 
-bool
-bignat_ne(bignat x, bignat y)
+/*
+ * rp[0, an) = |ap[0, an) - bp[0, bn)|。an >= bn。ap < bpであれば真を返
+ * す。
+ */
+static bool
+digits_absdiff(uint32_t *rp, const uint32_t *ap, size_t an,
+	       const uint32_t *bp, size_t bn)
 {
-	return bignat_cmp(x, y) != 0;
-}
+	size_t n = an;
+	while (n > bn && ap[n - 1] == 0) {
+		n--;
+	}
 
-bool
-bignat_lt(bignat x, bignat y)
-{
-	return bignat_cmp(x, y) < 0;
-}
+	if (n == bn && digits_cmp(ap, bp, bn) < 0) {
+		(void)digits_sub_n(rp, bp, ap, bn);
+		for (size_t i = bn; i < an; i++) {
+			rp[i] = 0;
+		}
+		return true;
+	}
 
-bool
-bignat_gt(bignat x, bignat y)
-{
-	return bignat_cmp(x, y) > 0;
+	(void)digits_sub(rp, ap, an, bp, bn);
+	return false;
 }
 
-bool
-bignat_le(bignat x, bignat y)
+/* rp[0, n) = -ap[0, n) mod B^n */
+static void
+digits_neg(uint32_t *rp, const uint32_t *ap, size_t n)
 {
-	return bignat_cmp(x, y) <= 0;
+	uint32_t borrow = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		uint64_t d = 0 - (uint64_t)ap[i] - borrow;
+		rp[i] = d;
+		borrow = (d >> 32) & 1;
+	}
 }
 
-bool
-bignat_ge(bignat x, bignat y)
+/* rp[0, n) = ap[0, n) * b。上位にあふれた桁を返す。 */
+static uint32_t
+digits_mul_1(uint32_t *rp, const uint32_t *ap, size_t n, uint32_t b)
 {
-	return bignat_cmp(x, y) >= 0;
+	uint32_t carry = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		uint64_t t = (uint64_t)ap[i] * b + carry;
+		rp[i] = t;
+		carry = t >> 32;
+	}
+
+	return carry;
 }
 
-static int
-bignat_accadd(bignat *dst, bignat src, size_t src_exp)
+/*
+ * rp[0, n) += ap[0, n) * b。上位にあふれた桁を返す。乗算の基本となる
+ * 一行分の積和で、桁上げは一本の連鎖で済ませる。
+ */
+static uint32_t
+digits_addmul_1(uint32_t *rp, const uint32_t *ap, size_t n, uint32_t b)
 {
-	size_t ndigits = dst->ndigits > src.ndigits + src_exp
-		? dst->ndigits
-		: src.ndigits + src_exp;
-	for (size_t i = dst->ndigits; i < ndigits + 1; i++) {
-		int err = dgtvec_push(dst, 0);
-		if (err != 0) {
-			bignat_del(*dst);
-			*dst = bignat_new_zero();
-			return err;
-		}
+	uint32_t carry = 0;
+	size_t i;
+
+	for (i = 0; i + 1 < n; i += 2) {
+		uint64_t t0 = (uint64_t)ap[i] * b + rp[i] + carry;
+		uint64_t t1 = (uint64_t)ap[i + 1] * b + rp[i + 1] + (t0 >> 32);
+		rp[i] = t0;
+		rp[i + 1] = t1;
+		carry = t1 >> 32;
+	}
+	if (i < n) {
+		uint64_t t = (uint64_t)ap[i] * b + rp[i] + carry;
+		rp[i] = t;
+		carry = t >> 32;
 	}
 
+	return carry;
+}
+
+/* rp[0, n) -= ap[0, n) * b。上位から借りる量を返す。 */
+static uint32_t
+digits_submul_1(uint32_t *rp, const uint32_t *ap, size_t n, uint32_t b)
+{
 	uint32_t carry = 0;
-	size_t i;
-	for (i = 0; i < dst->ndigits - 1; i++) {
-		uint32_t dst_digit, src_digit, digit;
-		uint64_t sum_digit;
 
-		dst_digit = i < dst->ndigits ? dst->digits[i] : 0;
-		src_digit = i >= src_exp && i - src_exp < src.ndigits
-			? src.digits[i - src_exp]
-			: 0;
-		sum_digit = (uint64_t)dst_digit + (uint64_t)src_digit +
-			(uint64_t)carry;
-		digit = sum_digit & ~(uint32_t)0;
-		carry = sum_digit >> 32;
+	for (size_t i = 0; i < n; i++) {
+		uint64_t t = (uint64_t)ap[i] * b + carry;
+		uint32_t lo = t;
+		uint32_t r = rp[i];
 
-		dst->digits[i] = digit;
+		rp[i] = r - lo;
+		carry = (t >> 32) + (r < lo);
 	}
-	dst->digits[i] = carry;
 
-	bignat_norm(dst);
-	return 0;
+	return carry;
 }
 
-int
-bignat_add(bignat *sum, bignat x, bignat y)
+/*
+ * rp[0, n) = ap[0, n) >> cnt。0 < cnt < 32。下位にあふれたビットを上
+ * 詰めで返す。
+ */
+static uint32_t
+digits_rshift(uint32_t *rp, const uint32_t *ap, size_t n, unsigned cnt)
 {
-	int err = -1;
-	bignat tmp_sum;
+	uint32_t out = ap[0] << (32 - cnt);
 
-	err = bignat_copy(&tmp_sum, x);
-	if (err != 0) {
-		return err;
+	for (size_t i = 0; i < n - 1; i++) {
+		rp[i] = (ap[i] >> cnt) | (ap[i + 1] << (32 - cnt));
 	}
+	rp[n - 1] = ap[n - 1] >> cnt;
 
-	err = bignat_accadd(&tmp_sum, y, 0);
-	if (err != 0) {
-		bignat_del(tmp_sum);
-		return err;
+	return out;
+}
+
+/*
+ * rp[0, n) = ap[0, n) << cnt。0 < cnt < 32。上位にあふれたビットを下
+ * 詰めで返す。
+ */
+static uint32_t
+digits_lshift(uint32_t *rp, const uint32_t *ap, size_t n, unsigned cnt)
+{
+	uint32_t out = ap[n - 1] >> (32 - cnt);
+
+	for (size_t i = n - 1; i > 0; i--) {
+		rp[i] = (ap[i] << cnt) | (ap[i - 1] >> (32 - cnt));
 	}
+	rp[0] = ap[0] << cnt;
 
-	*sum = tmp_sum;
-	return 0;
+	return out;
 }
 
-static bool
-bignat_lt_exp(bignat x, bignat y, size_t y_exp)
+/*
+ * rp[0, n) = ap[0, n) / d。dは奇数で、apはdで割り切れなければならない。
+ * 2の補数表現の負の値もそのまま扱える。
+ */
+static void
+digits_divexact_1(uint32_t *rp, const uint32_t *ap, size_t n, uint32_t d)
 {
-	if (x.ndigits < y.ndigits + y_exp) {
-		return true;
-	}
+	uint32_t inv = d;
+	uint32_t c = 0;
 
-	if (x.ndigits > y.ndigits + y_exp) {
-		return false;
+	/* Newton法でdの2^32を法とする逆元を求める。 */
+	for (int i = 0; i < 4; i++) {
+		inv *= 2 - d * inv;
 	}
 
-	/* x.ndigits == y.ndigits */
+	for (size_t i = 0; i < n; i++) {
+		uint32_t s = ap[i];
+		uint32_t l = s - c;
+		uint32_t q;
 
-	for (size_t i = x.ndigits - 1; i < x.ndigits; i--) {
-		uint32_t y_digit = i >= y_exp ? y.digits[i - y_exp] : 0;
+		c = l > s;
+		q = l * inv;
+		rp[i] = q;
+		c += ((uint64_t)q * d) >> 32;
+	}
+}
 
-		if (x.digits[i] < y_digit) {
-			return true;
-		}
+/* xの先行する0のビット数。x != 0。 */
+static unsigned
+digit_clz(uint32_t x)
+{
+	unsigned cnt = 0;
 
-		if (x.digits[i] > y_digit) {
-			return false;
+	for (unsigned w = 16; w > 0; w /= 2) {
+		if (x >> (32 - w) == 0) {
+			x <<= w;
+			cnt += w;
 		}
 	}
 
-	return false;
+	return cnt;
 }
 
-static int
-bignat_accsub(bignat *dst, bignat src, size_t src_exp)
+static size_t
+digits_normlen(const uint32_t *ap, size_t n)
 {
-	if (bignat_lt_exp(*dst, src, src_exp)) {
-		return EDOM;
+	while (n > 0 && ap[n - 1] == 0) {
+		n--;
 	}
 
-	/* *dst >= src * ((2 ** 32) ** src_exp) */
-
-	uint32_t borrow = 0;
-	for (size_t i = 0; i < dst->ndigits; i++) {
-		uint64_t src_digit;
-		uint32_t diff_digit;
+	return n;
+}
 
-		src_digit = i >= src_exp && i - src_exp < src.ndigits
-			? src.digits[i - src_exp]
-			: 0;
-		src_digit += borrow;
-		borrow = dst->digits[i] < src_digit;
-		diff_digit = ((uint64_t)borrow << 32) + (uint64_t)dst->digits[i]
-			- src_digit;
-		dst->digits[i] = diff_digit;
+/*
+ * rp[0, an + bn) = ap[0, an) * bp[0, bn)。an >= bn >= 1。rpは入力と重な
+ * ってはならない。
+ */
+static void
+digits_mul_basecase(uint32_t *rp, const uint32_t *ap, size_t an,
+		    const uint32_t *bp, size_t bn)
+{
+	rp[an] = digits_mul_1(rp, ap, an, bp[0]);
+	for (size_t j = 1; j < bn; j++) {
+		rp[an + j] = digits_addmul_1(rp + j, ap, an, bp[j]);
 	}
-
-	bignat_norm(dst);
-	return 0;
 }
 
-int
-bignat_sub(bignat *diff, bignat x, bignat y)
+/*
+ * rp[0, 2n) = ap[0, n)^2。n >= 1。rpは入力と重なってはならない。
+ * 対角線の外側の積 ap[i] * ap[j] (i < j) を一度ずつ求めて2倍し、
+ * 対角線上の ap[i]^2 を足す。
+ */
+static void
+digits_sqr_basecase(uint32_t *rp, const uint32_t *ap, size_t n)
 {
-	int err = -1;
-	bignat tmp_diff;
+	uint32_t carry = 0;
 
-	err = bignat_copy(&tmp_diff, x);
-	if (err != 0) {
-		return err;
+	rp[0] = 0;
+	rp[2 * n - 1] = 0;
+	if (n > 1) {
+		rp[n] = digits_mul_1(rp + 1, ap + 1, n - 1, ap[0]);
+		for (size_t i = 1; i < n - 1; i++) {
+			rp[n + i] = digits_addmul_1(rp + 2 * i + 1, ap + i + 1,
+						    n - i - 1, ap[i]);
+		}
+		(void)digits_lshift(rp, rp, 2 * n, 1);
 	}
 
-	err = bignat_accsub(&tmp_diff, y, 0);
-	if (err != 0) {
-		bignat_del(tmp_diff);
-		return err;
-	}
+	carry = 0;
+	for (size_t i = 0; i < n; i++) {
+		uint64_t sq = (uint64_t)ap[i] * ap[i];
+		uint64_t lo = (uint64_t)rp[2 * i] + (sq & UINT32_MAX) + carry;
+		uint64_t hi = (uint64_t)rp[2 * i + 1] + (sq >> 32) + (lo >> 32);
 
-	*diff = tmp_diff;
-	return 0;
+		rp[2 * i] = lo;
+		rp[2 * i + 1] = hi;
+		carry = hi >> 32;
+	}
 }
 
-int
-bignat_mul(bignat *prod, bignat x, bignat y)
+/*
+ * digits_mul_karatsubaとdigits_sqr_karatsubaが必要とする作業領域の桁
+ * 数。thresholdはKaratsuba法に切り替える桁数。
+ */
+static size_t
+karatsuba_itch(size_t an, size_t threshold)
 {
-	bignat tmp_prod = bignat_new_zero();
+	size_t itch = 0;
+
+	while (an >= threshold) {
+		size_t h = (an + 1) / 2;
+		itch += 4 * h;
+		an = h;
+	}
 
-	for (size_t ix = 0; ix < x.ndigits; ix++) {
-		for (size_t iy = 0; iy < y.ndigits; iy++) {
-			int err = -1;
-			uint64_t pd;
-			uint32_t prod_digit[2];
-			size_t num_prod_digit;
-			bignat prod_digit_view;
+	return itch;
+}
 
-			pd = (uint64_t)x.digits[ix] * (uint64_t)y.digits[iy];
+/*
+ * Karatsuba multiplication
+ *
+ * rp[0, an + bn) = ap[0, an) * bp[0, bn)。an >= bn >= 1。tpは
+ * karatsuba_itch(an, BIGNAT_KARATSUBA_THRESHOLD)桁の作業領域。
+ */
+static void
+digits_mul_karatsuba(uint32_t *rp, const uint32_t *ap, size_t an,
+		     const uint32_t *bp, size_t bn, uint32_t *tp)
+{
+	if (bn < BIGNAT_KARATSUBA_THRESHOLD) {
+		digits_mul_basecase(rp, ap, an, bp, bn);
+		return;
+	}
 
-			prod_digit[0] = pd & ~(uint32_t)0;
-			prod_digit[1] = pd >> 32;
-			num_prod_digit = countof(prod_digit);
-			while (num_prod_digit > 0 &&
-			       prod_digit[num_prod_digit - 1] == 0) {
-				num_prod_digit--;
-			}
+	size_t h = (an + 1) / 2;
 
-			(void)bignat_view(&prod_digit_view, prod_digit, num_prod_digit);
+	if (bn <= h) {
+		/*
+		 * 桁数の差が大きい場合は、apをbn桁ずつに区切ってそれぞれ
+		 * を掛け、ずらしながら足し合わせる。
+		 */
+		digits_mul_karatsuba(rp, ap, bn, bp, bn, tp + 2 * bn);
+		for (size_t i = bn; i < an; i += bn) {
+			size_t cn = min(bn, an - i);
+			uint32_t carry;
 
-			err = bignat_accadd(&tmp_prod, prod_digit_view, ix + iy);
-			if (err != 0) {
-				bignat_del(tmp_prod);
-				return err;
+			if (cn == bn) {
+				digits_mul_karatsuba(tp, ap + i, cn, bp, bn,
+						     tp + 2 * bn);
+			} else {
+				digits_mul_karatsuba(tp, bp, bn, ap + i, cn,
+						     tp + 2 * bn);
 			}
+
+			carry = digits_add_n(rp + i, rp + i, tp, bn);
+			(void)digits_add_1(rp + i + bn, tp + bn, cn, carry);
 		}
+		return;
 	}
 
-	*prod = tmp_prod;
-	return 0;
+	/*
+	 * a = a1 * B^h + a0, b = b1 * B^h + b0 とすると、
+	 * a * b = z2 * B^2h + (z0 + z2 - (a0 - a1)(b0 - b1)) * B^h + z0
+	 * ただし z0 = a0 * b0, z2 = a1 * b1
+	 */
+	size_t an1 = an - h;
+	size_t bn1 = bn - h;
+	uint32_t *zm = tp;
+	uint32_t *da = tp + 2 * h;
+	uint32_t *db = tp + 3 * h;
+	uint32_t *t = tp + 2 * h;
+	bool neg;
+	uint32_t carry, carry2;
+
+	neg = digits_absdiff(da, ap, h, ap + h, an1);
+	neg ^= digits_absdiff(db, bp, h, bp + h, bn1);
+	digits_mul_karatsuba(zm, da, h, db, h, tp + 4 * h);
+
+	digits_mul_karatsuba(rp, ap, h, bp, h, tp + 2 * h);
+	digits_mul_karatsuba(rp + 2 * h, ap + h, an1, bp + h, bn1, tp + 2 * h);
+
+	/* t = z0 + z2 -/+ zm。真の値はcarry * B^2h + t。 */
+	carry = digits_add(t, rp, 2 * h, rp + 2 * h, an1 + bn1);
+	if (neg) {
+		carry += digits_add_n(t, t, zm, 2 * h);
+	} else {
+		carry -= digits_sub_n(t, t, zm, 2 * h);
+	}
+
+	carry2 = digits_add_n(rp + h, rp + h, t, 2 * h);
+	(void)digits_add_1(rp + 3 * h, rp + 3 * h, an + bn - 3 * h,
+			   carry + carry2);
+}
+
+/*
+ * Karatsuba squaring
+ *
+ * rp[0, 2n) = ap[0, n)^2。tpはkaratsuba_itch(n,
+ * BIGNAT_SQR_KARATSUBA_THRESHOLD)桁の作業領域。
+ * a^2 = z2 * B^2h + (z0 + z2 - (a0 - a1)^2) * B^h + z0
+ */
+static void
+digits_sqr_karatsuba(uint32_t *rp, const uint32_t *ap, size_t n,
+		     uint32_t *tp)
+{
+	if (n < BIGNAT_SQR_KARATSUBA_THRESHOLD) {
+		digits_sqr_basecase(rp, ap, n);
+		return;
+	}
+
+	size_t h = (n + 1) / 2;
+	size_t n1 = n - h;
+	uint32_t *zm = tp;
+	uint32_t *da = tp + 2 * h;
+	uint32_t *t = tp + 2 * h;
+	uint32_t carry, carry2;
+
+	(void)digits_absdiff(da, ap, h, ap + h, n1);
+	digits_sqr_karatsuba(zm, da, h, tp + 4 * h);
+
+	digits_sqr_karatsuba(rp, ap, h, tp + 2 * h);
+	digits_sqr_karatsuba(rp + 2 * h, ap + h, n1, tp + 2 * h);
+
+	carry = digits_add(t, rp, 2 * h, rp + 2 * h, 2 * n1);
+	carry -= digits_sub_n(t, t, zm, 2 * h);
+
+	carry2 = digits_add_n(rp + h, rp + h, t, 2 * h);
+	(void)digits_add_1(rp + 3 * h, rp + 3 * h, 2 * n - 3 * h,
+			   carry + carry2);
+}
+
+static size_t digits_mul_itch(size_t an, size_t bn);
+static size_t digits_sqr_itch(size_t n);
+static void digits_mul_tp(uint32_t *rp, const uint32_t *ap, size_t an,
+			  const uint32_t *bp, size_t bn, uint32_t *tp);
+static void digits_sqr_tp(uint32_t *rp, const uint32_t *ap, size_t n,
+			  uint32_t *tp);
+static int digits_mul(uint32_t *rp, const uint32_t *ap, size_t an,
+		      const uint32_t *bp, size_t bn);
+
+/*
+ * 以下のtc_*関数は、n桁の配列を2の補数表現の符号付き整数として扱う。
+ */
+
+static bool
+tc_isneg(const uint32_t *ap, size_t n)
+{
+	return ap[n - 1] >> 31;
+}
+
+/* ap[0, n)を絶対値に置き換え、元の値が負であれば真を返す。 */
+static bool
+tc_abs(uint32_t *ap, size_t n)
+{
+	if (!tc_isneg(ap, n)) {
+		return false;
+	}
+
+	digits_neg(ap, ap, n);
+	return true;
+}
+
+static void
+tc_mul_small(uint32_t *ap, size_t n, int x)
+{
+	(void)digits_mul_1(ap, ap, n, x < 0 ? -x : x);
+	if (x < 0) {
+		digits_neg(ap, ap, n);
+	}
+}
+
+/* ap[0, n) /= d。apはdで割り切れなければならない。 */
+static void
+tc_divexact_small(uint32_t *ap, size_t n, int d)
+{
+	unsigned cnt = 0;
+
+	if (d < 0) {
+		digits_neg(ap, ap, n);
+		d = -d;
+	}
+
+	while (d % 2 == 0) {
+		d /= 2;
+		cnt++;
+	}
+
+	if (cnt > 0) {
+		bool neg = tc_isneg(ap, n);
+		(void)digits_rshift(ap, ap, n, cnt);
+		if (neg) {
+			ap[n - 1] |= ~(UINT32_MAX >> cnt);
+		}
+	}
+
+	if (d > 1) {
+		digits_divexact_1(ap, ap, n, d);
+	}
+}
+
+/* 無限遠点以外の評価点。 */
+static const int toom_points[] = {0, 1, -1, 2, -2, 3};
+
+/*
+ * apをk桁ずつp個に区切った多項式をxで評価し、rp[0, k + 1)に2の補数で
+ * 書き込む。
+ */
+static void
+toom_eval(uint32_t *rp, const uint32_t *ap, size_t an, size_t p, size_t k,
+	  int x)
+{
+	size_t i = p - 1;
+
+	for (size_t j = 0; j < k + 1; j++) {
+		rp[j] = j < an - i * k ? ap[i * k + j] : 0;
+	}
+
+	while (i-- > 0) {
+		tc_mul_small(rp, k + 1, x);
+		(void)digits_add(rp, rp, k + 1, ap + i * k, k);
+	}
+}
+
+/* rp[off, rn) += ap[0, n) */
+static void
+toom_accumulate(uint32_t *rp, size_t rn, size_t off,
+		const uint32_t *ap, size_t n)
+{
+	if (off >= rn) {
+		return;
+	}
+
+	size_t len = min(n, rn - off);
+	uint32_t carry = digits_add_n(rp + off, rp + off, ap, len);
+	(void)digits_add_1(rp + off + len, rp + off + len, rn - off - len,
+			   carry);
+}
+
+/*
+ * Toom-Cook multiplication
+ *
+ * rp[0, an + bn) = ap[0, an) * bp[0, bn)。apをk桁ずつp個、bpをk桁ずつ
+ * q個に区切り、それぞれを多項式とみなして p + q - 1 点で評価する。評価
+ * 点はtoom_pointsの先頭 p + q - 2 点と無限遠点。各点での積から、Newton
+ * の差分商によって積の多項式を補間する。最上位の区切りは空であっては
+ * ならない。
+ *
+ * 補間の途中の値は、積の係数より数十ビット大きくなるだけなので、
+ * 2k + 2 桁の2の補数で扱う。apとbpが同じ値であれば平方として、評価を
+ * 一度で済ませ、各点で平方を求める。各点の積は先行0を含めた k + 1 桁
+ * 同士で求め、作業領域の大きさを桁数だけで決まるようにする。tpは
+ * toom_itch()桁の作業領域。
+ */
+static void
+digits_mul_toom(uint32_t *rp, const uint32_t *ap, size_t an,
+		const uint32_t *bp, size_t bn, size_t p, size_t q, size_t k,
+		uint32_t *tp)
+{
+	size_t m = p + q - 2;
+	size_t w = 2 * k + 2;
+	size_t en = k + 1;
+	size_t atn = an - (p - 1) * k;
+	size_t btn = bn - (q - 1) * k;
+	bool sqr = ap == bp && an == bn && p == q;
+	uint32_t *v = tp;
+	uint32_t *ctop = v + m * w;
+	uint32_t *tmp = ctop + w;
+	uint32_t *ea = tmp + w;
+	uint32_t *eb = ea + en;
+	uint32_t *wp = eb + en;
+
+	/* 無限遠点での値は最上位の区切り同士の積。 */
+	for (size_t i = 0; i < w; i++) {
+		ctop[i] = 0;
+	}
+	if (sqr) {
+		digits_sqr_tp(ctop, ap + (p - 1) * k, atn, wp);
+	} else {
+		digits_mul_tp(ctop, ap + (p - 1) * k, atn, bp + (q - 1) * k,
+			      btn, wp);
+	}
+
+	/*
+	 * 有限の評価点での値を求め、最高次の項 ctop * x^m を引いておく。
+	 * 残りは m - 1 次の多項式になる。
+	 */
+	for (size_t j = 0; j < m; j++) {
+		int x = toom_points[j];
+		uint32_t *vj = v + j * w;
+		bool neg;
+
+		toom_eval(ea, ap, an, p, k, x);
+		neg = tc_abs(ea, en);
+		if (sqr) {
+			neg = false;
+			digits_sqr_tp(vj, ea, en, wp);
+		} else {
+			toom_eval(eb, bp, bn, q, k, x);
+			neg ^= tc_abs(eb, en);
+			digits_mul_tp(vj, ea, en, eb, en, wp);
+		}
+		if (neg) {
+			digits_neg(vj, vj, w);
+		}
+
+		if (x != 0) {
+			uint32_t xpow = 1;
+			for (size_t i = 0; i < m; i++) {
+				xpow *= x < 0 ? -x : x;
+			}
+
+			(void)digits_mul_1(tmp, ctop, w, xpow);
+			if (x < 0 && m % 2 == 1) {
+				(void)digits_add_n(vj, vj, tmp, w);
+			} else {
+				(void)digits_sub_n(vj, vj, tmp, w);
+			}
+		}
+	}
+
+	/* 差分商 v[j] = f[x_0, ..., x_j] */
+	for (size_t l = 1; l < m; l++) {
+		for (size_t j = m - 1; j >= l; j--) {
+			uint32_t *vj = v + j * w;
+
+			(void)digits_sub_n(vj, vj, vj - w, w);
+			tc_divexact_small(vj, w,
+					  toom_points[j] - toom_points[j - l]);
+		}
+	}
+
+	/*
+	 * Newton形式から係数を求める。v[i, m)に x - x_{i} を掛けて v[i]
+	 * を足すことを、iの大きい方から繰り返す。
+	 */
+	for (size_t i = m - 1; i-- > 0;) {
+		int x = toom_points[i];
+
+		if (x == 0) {
+			continue;
+		}
+
+		for (size_t t = i; t < m - 1; t++) {
+			uint32_t *vt = v + t * w;
+
+			for (size_t j = 0; j < w; j++) {
+				tmp[j] = vt[w + j];
+			}
+			tc_mul_small(tmp, w, x);
+			(void)digits_sub_n(vt, vt, tmp, w);
+		}
+	}
+
+	for (size_t i = 0; i < an + bn; i++) {
+		rp[i] = 0;
+	}
+	for (size_t t = 0; t < m; t++) {
+		toom_accumulate(rp, an + bn, t * k, v + t * w, w);
+	}
+	toom_accumulate(rp, an + bn, m * k, ctop, w);
+}
+
+/* digits_mul_toomの作業領域の桁数。 */
+static size_t
+toom_itch(size_t an, size_t bn, size_t p, size_t q, size_t k, bool sqr)
+{
+	size_t m = p + q - 2;
+	size_t en = k + 1;
+	size_t atn = an - (p - 1) * k;
+	size_t btn = bn - (q - 1) * k;
+	size_t itch = sqr
+		? max(digits_sqr_itch(en), digits_sqr_itch(atn))
+		: max(digits_mul_itch(en, en), digits_mul_itch(atn, btn));
+
+	return (m + 2) * (2 * k + 2) + 2 * en + itch;
+}
+
+/*
+ * NTTに用いる素数。いずれも 2^25 を超える2冪の位数の原始根を持つ。3つ
+ * の積は約2^92.6で、長さ2^25までの畳み込みの各項 (< 2^25 * 2^64) を
+ * 中国剰余定理で復元できる。
+ */
+#define NTT_NPRIMES 3
+#define NTT_MAX_LOG 25
+
+static const struct ntt_prime {
+	uint32_t p;
+	uint32_t g;
+} ntt_primes[NTT_NPRIMES] = {
+	{2013265921, 31},	/* 15 * 2^27 + 1 */
+	{1811939329, 13},	/* 27 * 2^26 + 1 */
+	{2113929217, 5},	/* 63 * 2^25 + 1 */
+};
+
+/* 2^32を基数とするMontgomery乗算に必要な値。 */
+typedef struct ntt_mod {
+	uint32_t p;
+	uint32_t pinv;	/* -p^-1 mod 2^32 */
+	uint32_t r;	/* 2^32 mod p */
+} ntt_mod;
+
+static uint32_t
+ntt_powmod(uint32_t a, uint64_t e, uint32_t p)
+{
+	uint64_t r = 1, b = a % p;
+
+	while (e > 0) {
+		if (e & 1) {
+			r = r * b % p;
+		}
+		b = b * b % p;
+		e >>= 1;
+	}
+
+	return r;
+}
+
+static ntt_mod
+ntt_mod_init(uint32_t p)
+{
+	uint32_t inv = p;
+
+	for (int i = 0; i < 4; i++) {
+		inv *= 2 - p * inv;
+	}
+
+	return (ntt_mod){
+		.p=p,
+		.pinv=-inv,
+		.r=((uint64_t)1 << 32) % p
+	};
+}
+
+/* a * b * 2^-32 mod p */
+static uint32_t
+ntt_mulmod(ntt_mod m, uint32_t a, uint32_t b)
+{
+	uint64_t t = (uint64_t)a * b;
+	uint32_t q = (uint32_t)t * m.pinv;
+	uint32_t u = (t + (uint64_t)q * m.p) >> 32;
+
+	return u >= m.p ? u - m.p : u;
+}
+
+static uint32_t
+ntt_addmod(ntt_mod m, uint32_t a, uint32_t b)
+{
+	uint32_t s = a + b;
+	return s >= m.p ? s - m.p : s;
+}
+
+static uint32_t
+ntt_submod(ntt_mod m, uint32_t a, uint32_t b)
+{
+	return a >= b ? a - b : a + m.p - b;
+}
+
+/*
+ * 長さnの順変換 (decimation in frequency)。結果はビット反転順に並ぶ。
+ * rtは1の原始n乗根wについて、w^jのMontgomery表現 (0 <= j < n / 2)。
+ */
+static void
+ntt_forward(ntt_mod m, uint32_t *a, size_t n, const uint32_t *rt)
+{
+	for (size_t len = n / 2; len >= 1; len /= 2) {
+		size_t step = n / (2 * len);
+
+		for (size_t i = 0; i < n; i += 2 * len) {
+			for (size_t j = 0; j < len; j++) {
+				uint32_t u = a[i + j];
+				uint32_t v = a[i + j + len];
+
+				a[i + j] = ntt_addmod(m, u, v);
+				a[i + j + len] = ntt_mulmod(m, ntt_submod(m, u, v),
+							    rt[j * step]);
+			}
+		}
+	}
+}
+
+/*
+ * ビット反転順の入力に対する逆変換 (decimation in time)。結果は通常の
+ * 順に並び、n倍されている。w^-j = -w^(n/2 - j) を使ってrtを共用する。
+ */
+static void
+ntt_inverse(ntt_mod m, uint32_t *a, size_t n, const uint32_t *rt)
+{
+	for (size_t len = 1; len < n; len *= 2) {
+		size_t step = n / (2 * len);
+
+		for (size_t i = 0; i < n; i += 2 * len) {
+			for (size_t j = 0; j < len; j++) {
+				uint32_t w = j == 0
+					? rt[0]
+					: m.p - rt[n / 2 - j * step];
+				uint32_t u = a[i + j];
+				uint32_t v = ntt_mulmod(m, a[i + j + len], w);
+
+				a[i + j] = ntt_addmod(m, u, v);
+				a[i + j + len] = ntt_submod(m, u, v);
+			}
+		}
+	}
+}
+
+/*
+ * ap[0, an)とbp[0, bn)の各桁の畳み込みを素数ntt_primes[k]を法として求
+ * め、fa[0, n)に書き込む。fbとrtはそれぞれn桁、n / 2桁の作業領域。apと
+ * bpが同じ値であれば変換を一度で済ませる。
+ */
+static void
+ntt_convolve(uint32_t *fa, uint32_t *fb, uint32_t *rt, size_t n,
+	     const uint32_t *ap, size_t an, const uint32_t *bp, size_t bn,
+	     size_t k)
+{
+	uint32_t p = ntt_primes[k].p;
+	ntt_mod m = ntt_mod_init(p);
+	uint32_t w = ntt_powmod(ntt_primes[k].g, (p - 1) / n, p);
+	uint32_t scale;
+
+	rt[0] = m.r;
+	for (size_t j = 1; j < n / 2; j++) {
+		/* w^j * 2^32 = (w^(j-1) * 2^32) * w */
+		rt[j] = (uint64_t)rt[j - 1] * w % p;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		fa[i] = i < an ? ap[i] % p : 0;
+	}
+	ntt_forward(m, fa, n, rt);
+
+	if (ap == bp && an == bn) {
+		fb = fa;
+	} else {
+		for (size_t i = 0; i < n; i++) {
+			fb[i] = i < bn ? bp[i] % p : 0;
+		}
+		ntt_forward(m, fb, n, rt);
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		fa[i] = ntt_mulmod(m, fa[i], fb[i]);
+	}
+	ntt_inverse(m, fa, n, rt);
+
+	/*
+	 * 各点の積で2^-32が掛かり、逆変換でn倍されているので、
+	 * n^-1 * 2^32 を掛けて戻す。Montgomery乗算で掛けるため、さらに
+	 * 2^32倍した値を用いる。
+	 */
+	scale = ntt_powmod(n % p, p - 2, p);
+	scale = (uint64_t)scale * m.r % p;
+	scale = (uint64_t)scale * m.r % p;
+	for (size_t i = 0; i < n; i++) {
+		fa[i] = ntt_mulmod(m, fa[i], scale);
+	}
+}
+
+/*
+ * ap[0, an)とbp[0, bn)の長さnの巡回畳み込みを3つの素数を法としてそれぞ
+ * れ求め、Garnerのアルゴリズムで各項を復元して桁上げしながらrp[0, rn)
+ * に書き込む。rn <= an + bn。rn桁目以上への桁上げを*cyに書き込む。tp
+ * はntt_mul_itch(n)桁の作業領域。
+ */
+static void
+ntt_mul(uint32_t *rp, size_t rn, const uint32_t *ap, size_t an,
+	const uint32_t *bp, size_t bn, size_t n, uint64_t *cy, uint32_t *tp)
+{
+	uint32_t *res[NTT_NPRIMES], *fb, *rt;
+
+	for (size_t k = 0; k < NTT_NPRIMES; k++) {
+		res[k] = tp + k * n;
+	}
+	fb = tp + NTT_NPRIMES * n;
+	rt = fb + n;
+
+	for (size_t k = 0; k < NTT_NPRIMES; k++) {
+		ntt_convolve(res[k], fb, rt, n, ap, an, bp, bn, k);
+	}
+
+	uint32_t p0 = ntt_primes[0].p;
+	uint32_t p1 = ntt_primes[1].p;
+	uint32_t p2 = ntt_primes[2].p;
+	uint64_t p01 = (uint64_t)p0 * p1;
+	uint32_t inv_p0 = ntt_powmod(p0, p1 - 2, p1);
+	uint32_t inv_p01 = ntt_powmod(p01 % p2, p2 - 2, p2);
+	uint64_t c0 = 0, c1 = 0, c2 = 0;
+
+	for (size_t i = 0; i < rn; i++) {
+		if (i < n) {
+			uint32_t r0 = res[0][i], r1 = res[1][i], r2 = res[2][i];
+			uint64_t t1, t2, s, u, v;
+
+			/* x = r0 + p0 * t1 + p0 * p1 * t2 */
+			t1 = (uint64_t)(r1 + p1 - r0 % p1) * inv_p0 % p1;
+			s = r0 + p0 * t1;
+			t2 = (p2 - s % p2 + r2) * inv_p01 % p2;
+
+			u = (p01 & UINT32_MAX) * t2 + (s & UINT32_MAX);
+			v = (p01 >> 32) * t2 + (s >> 32) + (u >> 32);
+			c0 += u & UINT32_MAX;
+			c1 += v & UINT32_MAX;
+			c2 += v >> 32;
+		}
+
+		rp[i] = c0;
+		c1 += c0 >> 32;
+		c0 = c1;
+		c1 = c2;
+		c2 = 0;
+	}
+
+	*cy = c0 + (c1 << 32);
+}
+
+static size_t
+ntt_mul_itch(size_t n)
+{
+	return (NTT_NPRIMES + 1) * n + n / 2;
+}
+
+/* 長さlenの積を巡回畳み込みで求められる、2以上の最小の2冪。 */
+static size_t
+ntt_size(size_t len)
+{
+	size_t n = 2;
+
+	while (n < len) {
+		n *= 2;
+	}
+	return n;
+}
+
+/*
+ * NTT multiplication
+ *
+ * rp[0, an + bn) = ap[0, an) * bp[0, bn)。an + bn - 1 は
+ * 2^NTT_MAX_LOG 以下でなければならない。tpは
+ * ntt_mul_itch(ntt_size(an + bn - 1))桁の作業領域。
+ */
+static void
+digits_mul_ntt(uint32_t *rp, const uint32_t *ap, size_t an,
+	       const uint32_t *bp, size_t bn, uint32_t *tp)
+{
+	uint64_t cy;
+
+	ntt_mul(rp, an + bn, ap, an, bp, bn, ntt_size(an + bn - 1), &cy, tp);
+}
+
+/*
+ * 以下のdigits_*_bnm1関数は、n桁の配列を B^n - 1 を法とする剰余として
+ * 扱う。B = 2^32。
+ */
+
+/*
+ * B^n - 1 を法とする乗算で、全体の積より安く求められるnを返す。n以上で
+ * 最小の値を選ぶ。
+ */
+static size_t
+digits_mulmod_bnm1_size(size_t n)
+{
+	size_t m = 2;
+
+	if (n < BIGNAT_NTT_THRESHOLD) {
+		return n;
+	}
+
+	while (m < n) {
+		m *= 2;
+	}
+
+	return m <= (size_t)1 << NTT_MAX_LOG ? m : n;
+}
+
+/* rp[0, n) = ap[0, an) mod (B^n - 1)。an <= 2n。 */
+static void
+digits_fold_bnm1(uint32_t *rp, size_t n, const uint32_t *ap, size_t an)
+{
+	uint32_t cy;
+
+	if (an <= n) {
+		for (size_t i = 0; i < n; i++) {
+			rp[i] = i < an ? ap[i] : 0;
+		}
+		return;
+	}
+
+	cy = digits_add(rp, ap, n, ap + n, an - n);
+	while (cy != 0) {
+		cy = digits_add_1(rp, rp, n, cy);
+	}
+}
+
+/*
+ * rp[0, n) = (ap[0, n) - bp[0, n)) mod (B^n - 1)。結果はB^n - 1未満に
+ * する。
+ */
+static void
+digits_sub_bnm1(uint32_t *rp, const uint32_t *ap, const uint32_t *bp,
+		size_t n)
+{
+	size_t i;
+
+	if (digits_sub_n(rp, ap, bp, n) != 0) {
+		(void)digits_sub_1(rp, rp, n, 1);
+	}
+
+	for (i = 0; i < n && rp[i] == UINT32_MAX; i++) {
+	}
+	if (i == n) {
+		for (i = 0; i < n; i++) {
+			rp[i] = 0;
+		}
+	}
+}
+
+/*
+ * rp[0, rn) = ap[0, an) * bp[0, bn) mod (B^rn - 1)。an, bn <= rn。rnは
+ * digits_mulmod_bnm1_size()で決めたもの。rnが2の冪であれば長さrnの巡
+ * 回畳み込みで求め、そうでなければ積を求めてから畳み込む。
+ */
+static int
+digits_mulmod_bnm1(uint32_t *rp, size_t rn, const uint32_t *ap, size_t an,
+		   const uint32_t *bp, size_t bn)
+{
+	int err;
+
+	if (an + bn <= rn) {
+		for (size_t i = an + bn; i < rn; i++) {
+			rp[i] = 0;
+		}
+		return digits_mul(rp, ap, an, bp, bn);
+	}
+
+	if (rn >= BIGNAT_NTT_THRESHOLD && (rn & (rn - 1)) == 0) {
+		uint32_t *tp = digits_alloc(ntt_mul_itch(rn));
+		uint64_t cy;
+
+		if (tp == NULL) {
+			return ENOMEM;
+		}
+
+		ntt_mul(rp, rn, ap, an, bp, bn, rn, &cy, tp);
+		digits_free(tp);
+
+		for (size_t i = 0; cy != 0; i = (i + 1) % rn) {
+			cy += rp[i];
+			rp[i] = cy;
+			cy >>= 32;
+		}
+		return 0;
+	}
+
+	uint32_t *tp = digits_alloc(an + bn);
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	err = digits_mul(tp, ap, an, bp, bn);
+	if (err == 0) {
+		digits_fold_bnm1(rp, rn, tp, an + bn);
+	}
+
+	digits_free(tp);
+	return err;
+}
+
+/*
+ * Toom-Cook法で掛ける場合の分割数p, qと区切りの桁数kを決める。桁数の比
+ * に応じて、Toom-33 (Toom-44)、Toom-32、Toom-42から選ぶ。どれも使え
+ * なければ偽を返す。
+ */
+static bool
+toom_split(size_t an, size_t bn, size_t *p, size_t *q, size_t *k)
+{
+	if (4 * an < 5 * bn) {
+		*p = *q = bn >= BIGNAT_TOOM4_THRESHOLD ? 4 : 3;
+	} else if (4 * an < 7 * bn) {
+		*p = 3;
+		*q = 2;
+	} else if (2 * an < 5 * bn) {
+		*p = 4;
+		*q = 2;
+	} else {
+		return false;
+	}
+
+	size_t ka = (an + *p - 1) / *p;
+	size_t kb = (bn + *q - 1) / *q;
+	*k = ka > kb ? ka : kb;
+
+	return an > (*p - 1) * *k && bn > (*q - 1) * *k;
+}
+
+/*
+ * rp[0, an + bn) = ap[0, an) * bp[0, bn)。an >= bn。apをbn桁ずつに区切
+ * って掛ける。tpはchunked_itch(an, bn)桁の作業領域。
+ */
+static void
+digits_mul_chunked(uint32_t *rp, const uint32_t *ap, size_t an,
+		   const uint32_t *bp, size_t bn, uint32_t *tp)
+{
+	uint32_t *wp = tp + 2 * bn;
+
+	digits_mul_tp(rp, ap, bn, bp, bn, wp);
+
+	for (size_t i = bn; i < an; i += bn) {
+		size_t cn = min(bn, an - i);
+		uint32_t carry;
+
+		digits_mul_tp(tp, ap + i, cn, bp, bn, wp);
+		carry = digits_add_n(rp + i, rp + i, tp, bn);
+		(void)digits_add_1(rp + i + bn, tp + bn, cn, carry);
+	}
+}
+
+static size_t
+chunked_itch(size_t an, size_t bn)
+{
+	size_t cn = an % bn != 0 ? an % bn : bn;
+
+	return 2 * bn + max(digits_mul_itch(bn, bn), digits_mul_itch(cn, bn));
+}
+
+/*
+ * rp[0, 2n) = ap[0, n)^2。n >= 1。rpは入力と重なってはならない。桁数に
+ * 応じてアルゴリズムを選ぶ。tpはdigits_sqr_itch(n)桁の作業領域。
+ */
+static void
+digits_sqr_tp(uint32_t *rp, const uint32_t *ap, size_t n, uint32_t *tp)
+{
+	if (n < BIGNAT_SQR_KARATSUBA_THRESHOLD) {
+		digits_sqr_basecase(rp, ap, n);
+		return;
+	}
+
+	if (n >= BIGNAT_NTT_THRESHOLD &&
+	    2 * n - 1 <= (size_t)1 << NTT_MAX_LOG) {
+		digits_mul_ntt(rp, ap, n, ap, n, tp);
+		return;
+	}
+
+	if (n >= BIGNAT_TOOM3_THRESHOLD) {
+		size_t p, q, k;
+
+		if (toom_split(n, n, &p, &q, &k)) {
+			digits_mul_toom(rp, ap, n, ap, n, p, q, k, tp);
+			return;
+		}
+	}
+
+	digits_sqr_karatsuba(rp, ap, n, tp);
+}
+
+/* digits_sqr_tpの作業領域の桁数。選ぶアルゴリズムはdigits_sqr_tpと同じ。 */
+static size_t
+digits_sqr_itch(size_t n)
+{
+	if (n < BIGNAT_SQR_KARATSUBA_THRESHOLD) {
+		return 0;
+	}
+
+	if (n >= BIGNAT_NTT_THRESHOLD &&
+	    2 * n - 1 <= (size_t)1 << NTT_MAX_LOG) {
+		return ntt_mul_itch(ntt_size(2 * n - 1));
+	}
+
+	if (n >= BIGNAT_TOOM3_THRESHOLD) {
+		size_t p, q, k;
+
+		if (toom_split(n, n, &p, &q, &k)) {
+			return toom_itch(n, n, p, q, k, true);
+		}
+	}
+
+	return karatsuba_itch(n, BIGNAT_SQR_KARATSUBA_THRESHOLD);
+}
+
+/*
+ * rp[0, an + bn) = ap[0, an) * bp[0, bn)。an, bn >= 1。rpは入力と重な
+ * ってはならない。桁数に応じてアルゴリズムを選ぶ。tpは
+ * digits_mul_itch(an, bn)桁の作業領域。
+ */
+static void
+digits_mul_tp(uint32_t *rp, const uint32_t *ap, size_t an,
+	      const uint32_t *bp, size_t bn, uint32_t *tp)
+{
+	if (an < bn) {
+		digits_mul_tp(rp, bp, bn, ap, an, tp);
+		return;
+	}
+
+	if (ap == bp && an == bn) {
+		digits_sqr_tp(rp, ap, an, tp);
+		return;
+	}
+
+	if (bn < BIGNAT_KARATSUBA_THRESHOLD) {
+		digits_mul_basecase(rp, ap, an, bp, bn);
+		return;
+	}
+
+	if (bn >= BIGNAT_NTT_THRESHOLD &&
+	    an + bn - 1 <= (size_t)1 << NTT_MAX_LOG) {
+		digits_mul_ntt(rp, ap, an, bp, bn, tp);
+		return;
+	}
+
+	if (bn >= BIGNAT_TOOM3_THRESHOLD) {
+		size_t p, q, k;
+
+		if (toom_split(an, bn, &p, &q, &k)) {
+			digits_mul_toom(rp, ap, an, bp, bn, p, q, k, tp);
+			return;
+		}
+
+		if (2 * an >= 5 * bn) {
+			digits_mul_chunked(rp, ap, an, bp, bn, tp);
+			return;
+		}
+	}
+
+	digits_mul_karatsuba(rp, ap, an, bp, bn, tp);
+}
+
+/*
+ * digits_mul_tpの作業領域の桁数。選ぶアルゴリズムはdigits_mul_tpと同じ
+ * で、an == bn では平方に切り替わる場合の分も含める。
+ */
+static size_t
+digits_mul_itch(size_t an, size_t bn)
+{
+	if (an < bn) {
+		return digits_mul_itch(bn, an);
+	}
+
+	size_t itch = an == bn ? digits_sqr_itch(an) : 0;
+
+	if (bn < BIGNAT_KARATSUBA_THRESHOLD) {
+		return itch;
+	}
+
+	if (bn >= BIGNAT_NTT_THRESHOLD &&
+	    an + bn - 1 <= (size_t)1 << NTT_MAX_LOG) {
+		return max(itch, ntt_mul_itch(ntt_size(an + bn - 1)));
+	}
+
+	if (bn >= BIGNAT_TOOM3_THRESHOLD) {
+		size_t p, q, k;
+
+		if (toom_split(an, bn, &p, &q, &k)) {
+			return max(itch, toom_itch(an, bn, p, q, k, false));
+		}
+
+		if (2 * an >= 5 * bn) {
+			return max(itch, chunked_itch(an, bn));
+		}
+	}
+
+	return max(itch, karatsuba_itch(an, BIGNAT_KARATSUBA_THRESHOLD));
+}
+
+/* digits_sqr_tpと同じだが、作業領域を確保する。 */
+static int
+digits_sqr(uint32_t *rp, const uint32_t *ap, size_t n)
+{
+	size_t itch = digits_sqr_itch(n);
+	uint32_t *tp = NULL;
+
+	if (itch > 0) {
+		tp = digits_alloc(itch);
+		if (tp == NULL) {
+			return ENOMEM;
+		}
+	}
+
+	digits_sqr_tp(rp, ap, n, tp);
+	digits_free(tp);
+	return 0;
+}
+
+/* digits_mul_tpと同じだが、作業領域を確保する。 */
+static int
+digits_mul(uint32_t *rp, const uint32_t *ap, size_t an,
+	   const uint32_t *bp, size_t bn)
+{
+	size_t itch = digits_mul_itch(an, bn);
+	uint32_t *tp = NULL;
+
+	if (itch > 0) {
+		tp = digits_alloc(itch);
+		if (tp == NULL) {
+			return ENOMEM;
+		}
+	}
+
+	digits_mul_tp(rp, ap, an, bp, bn, tp);
+	digits_free(tp);
+	return 0;
+}
+
+/*
+ * 正規化されたdについて、floor((B^2 - 1) / d) - B を返す。B = 2^32。
+ */
+static uint32_t
+digit_inverse(uint32_t d)
+{
+	return UINT64_MAX / d - ((uint64_t)1 << 32);
+}
+
+/*
+ * Möller-Granlund division
+ *
+ * (u1 * B + u0) / d の商を返し、剰余を*rに書き込む。dは正規化されてい
+ * なければならず、vはdigit_inverse(d)。u1 < d。除算命令の代わりに乗算
+ * 1回と補正で求める。
+ */
+static uint32_t
+digit_div_preinv(uint32_t *r, uint32_t u1, uint32_t u0, uint32_t d,
+		 uint32_t v)
+{
+	uint64_t q = (uint64_t)v * u1 + (((uint64_t)u1 + 1) << 32) + u0;
+	uint32_t q1 = q >> 32;
+	uint32_t rem = u0 - q1 * d;
+
+	if (rem > (uint32_t)q) {
+		q1--;
+		rem += d;
+	}
+	if (rem >= d) {
+		q1++;
+		rem -= d;
+	}
+
+	*r = rem;
+	return q1;
+}
+
+/*
+ * qp[0, nn) = np[0, nn) / d。剰余を返す。d != 0。dを正規化して逆数を
+ * 一度だけ求め、各桁を乗算で割る。
+ */
+static uint32_t
+digits_divmod_1(uint32_t *qp, const uint32_t *np, size_t nn, uint32_t d)
+{
+	unsigned cnt = digit_clz(d);
+	uint32_t v, r = 0;
+
+	if (nn == 0) {
+		return 0;
+	}
+
+	d <<= cnt;
+	v = digit_inverse(d);
+
+	if (cnt == 0) {
+		for (size_t i = nn - 1; i < nn; i--) {
+			qp[i] = digit_div_preinv(&r, r, np[i], d, v);
+		}
+		return r;
+	}
+
+	r = np[nn - 1] >> (32 - cnt);
+	for (size_t i = nn - 1; i > 0; i--) {
+		uint32_t u = np[i] << cnt | np[i - 1] >> (32 - cnt);
+		qp[i] = digit_div_preinv(&r, r, u, d, v);
+	}
+	qp[0] = digit_div_preinv(&r, r, np[0] << cnt, d, v);
+
+	return r >> cnt;
+}
+
+/*
+ * Knuth's Algorithm D
+ *
+ * np[0, nn)をdp[0, dn)で割り、商の下位 nn - dn 桁をqpに、剰余を
+ * np[0, dn)に書き込む。np[dn, nn)の内容は不定になる。商の最上位の桁
+ * (0か1)を返す。nn >= dn >= 2。dpは最上位のビットが1になるように正規
+ * 化されていなければならない。
+ *
+ * 商の各桁は剰余の上位2桁と除数の最上位桁から見積もり、除数の次の桁を
+ * 使って補正する。見積もりが過大になるのは高々1回で、その場合は除数を
+ * 足し戻す。
+ */
+static uint32_t
+digits_div_basecase(uint32_t *qp, uint32_t *np, size_t nn,
+		    const uint32_t *dp, size_t dn)
+{
+	uint32_t d1 = dp[dn - 1];
+	uint32_t d0 = dp[dn - 2];
+	uint32_t qh = 0;
+
+	if (digits_cmp(np + nn - dn, dp, dn) >= 0) {
+		(void)digits_sub_n(np + nn - dn, np + nn - dn, dp, dn);
+		qh = 1;
+	}
+
+	for (size_t j = nn - dn - 1; j < nn - dn; j--) {
+		uint32_t n2 = np[j + dn];
+		uint32_t n1 = np[j + dn - 1];
+		uint32_t n0 = np[j + dn - 2];
+		uint64_t q, rhat;
+		uint32_t borrow;
+
+		if (n2 == d1) {
+			q = UINT32_MAX;
+			rhat = (uint64_t)n1 + d1;
+		} else {
+			uint64_t num = ((uint64_t)n2 << 32) | n1;
+			q = num / d1;
+			rhat = num % d1;
+		}
+
+		while (rhat <= UINT32_MAX && q * d0 > ((rhat << 32) | n0)) {
+			q--;
+			rhat += d1;
+		}
+
+		borrow = digits_submul_1(np + j, dp, dn, q);
+		if (n2 < borrow) {
+			q--;
+			(void)digits_add_n(np + j, np + j, dp, dn);
+		}
+		np[j + dn] = 0;
+		qp[j] = q;
+	}
+
+	return qh;
+}
+
+/*
+ * Burnikel-Ziegler division
+ *
+ * np[0, 2n)をdp[0, n)で割り、商の下位n桁をqpに、剰余をnp[0, n)に書き
+ * 込む。商の最上位の桁(0か1)を*qhに書き込む。dpは正規化されていなけれ
+ * ばならない。n >= BIGNAT_DC_DIV_THRESHOLD。tpはn桁の作業領域。
+ *
+ * 商の上位半分を除数の上位半分で再帰的に求め、除数の下位半分との積を
+ * 引いて補正する。補正は高々2回で済む。下位半分も同様に求める。
+ */
+static int
+digits_div_dc_n(uint32_t *qp, uint32_t *np, const uint32_t *dp, size_t n,
+		uint32_t *tp, uint32_t *qh)
+{
+	size_t lo = n / 2;
+	size_t hi = n - lo;
+	uint32_t q1, q0, cy;
+	int err;
+
+	if (hi < BIGNAT_DC_DIV_THRESHOLD) {
+		q1 = digits_div_basecase(qp + lo, np + 2 * lo, 2 * hi,
+					 dp + lo, hi);
+	} else {
+		err = digits_div_dc_n(qp + lo, np + 2 * lo, dp + lo, hi, tp,
+				      &q1);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	err = digits_mul(tp, qp + lo, hi, dp, lo);
+	if (err != 0) {
+		return err;
+	}
+	cy = digits_sub_n(np + lo, np + lo, tp, n);
+	if (q1 != 0) {
+		cy += digits_sub_n(np + n, np + n, dp, lo);
+	}
+	while (cy != 0) {
+		q1 -= digits_sub_1(qp + lo, qp + lo, hi, 1);
+		cy -= digits_add_n(np + lo, np + lo, dp, n);
+	}
+
+	if (lo < BIGNAT_DC_DIV_THRESHOLD) {
+		q0 = digits_div_basecase(qp, np + hi, 2 * lo, dp + hi, lo);
+	} else {
+		err = digits_div_dc_n(qp, np + hi, dp + hi, lo, tp, &q0);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	err = digits_mul(tp, qp, lo, dp, hi);
+	if (err != 0) {
+		return err;
+	}
+	cy = digits_sub_n(np, np, tp, n);
+	if (q0 != 0) {
+		cy += digits_sub_n(np + lo, np + lo, dp, hi);
+	}
+	while (cy != 0) {
+		(void)digits_sub_1(qp, qp, lo, 1);
+		cy -= digits_add_n(np, np, dp, n);
+	}
+
+	*qh = q1;
+	return 0;
+}
+
+/*
+ * np[0, dn + qn)をdp[0, dn)で割り、商の下位qn桁をqpに、剰余をnp[0, dn)
+ * に書き込む。商の最上位の桁(0か1)を*qhに書き込む。qn <= dn。dpは正規
+ * 化されていなければならない。tpはdn桁の作業領域。
+ *
+ * qnが小さい場合はそのまま筆算で割る。そうでなければ、上位2qn桁を除数
+ * の上位qn桁で割って商を見積もり、除数の残りの桁との積を引いて補正す
+ * る。
+ */
+static int
+digits_div_dc_block(uint32_t *qp, uint32_t *np, const uint32_t *dp,
+		    size_t dn, size_t qn, uint32_t *tp, uint32_t *qh)
+{
+	uint32_t q, cy;
+	int err;
+
+	if (qn < BIGNAT_DC_DIV_THRESHOLD) {
+		*qh = digits_div_basecase(qp, np, dn + qn, dp, dn);
+		return 0;
+	}
+
+	if (qn == dn) {
+		return digits_div_dc_n(qp, np, dp, dn, tp, qh);
+	}
+
+	err = digits_div_dc_n(qp, np + dn - qn, dp + dn - qn, qn, tp, &q);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_mul(tp, qp, qn, dp, dn - qn);
+	if (err != 0) {
+		return err;
+	}
+	cy = digits_sub_n(np, np, tp, dn);
+	if (q != 0) {
+		cy += digits_sub_n(np + qn, np + qn, dp, dn - qn);
+	}
+	while (cy != 0) {
+		q -= digits_sub_1(qp, qp, qn, 1);
+		cy -= digits_add_n(np, np, dp, dn);
+	}
+
+	*qh = q;
+	return 0;
+}
+
+/*
+ * np[0, nn)をdp[0, dn)で割り、商の下位 nn - dn 桁をqpに、剰余を
+ * np[0, dn)に書き込む。商の最上位の桁(0か1)を*qhに書き込む。
+ * nn > dn >= BIGNAT_DC_DIV_THRESHOLD。dpは正規化されていなければならな
+ * い。tpはdn桁の作業領域。
+ *
+ * 商を上位からdn桁ずつのブロックに分け、各ブロックを分割統治法で求め
+ * る。端数のブロックを最初に処理する。
+ */
+static int
+digits_div_dc(uint32_t *qp, uint32_t *np, size_t nn,
+	      const uint32_t *dp, size_t dn, uint32_t *tp, uint32_t *qh)
+{
+	size_t qn = nn - dn;
+	size_t bn = (qn - 1) % dn + 1;
+	int err;
+
+	qn -= bn;
+	err = digits_div_dc_block(qp + qn, np + qn, dp, dn, bn, tp, qh);
+
+	while (err == 0 && qn > 0) {
+		uint32_t q;
+
+		qn -= dn;
+		err = digits_div_dc_n(qp + qn, np + qn, dp, dn, tp, &q);
+	}
+
+	return err;
+}
+
+/*
+ * Newton's method
+ *
+ * rp[0, n + 1) = floor(B^2n / dp[0, n))。B = 2^32。dpは正規化されてい
+ * なければならない。xpがNULLでなければ、剰余 B^2n - dp * rp を
+ * xp[0, n)に書き込む。
+ *
+ * 除数の上位 h = ceil(n / 2) 桁に1を足した値の逆数を再帰的に求めると、
+ * 真の値を超えない近似値 x が得られる。これをNewton法で1回改良する。
+ *
+ *     x' = x + floor(x * (B^2n - dp * x) / B^2n)
+ *
+ * x' も真の値を超えず、誤差は高々数十なので、剰余を計算して残りを補正す
+ * る。途中の積は結果が小さいことが分かっているので、B^rn - 1 を法とし
+ * て求める。
+ */
+static int
+digits_invert(uint32_t *rp, uint32_t *xp, const uint32_t *dp, size_t n)
+{
+	int err;
+
+	if (n == 1) {
+		uint64_t q = UINT64_MAX / dp[0];
+		uint64_t r = UINT64_MAX % dp[0] + 1;
+
+		if (r == dp[0]) {
+			q++;
+			r = 0;
+		}
+		rp[0] = q;
+		rp[1] = q >> 32;
+		if (xp != NULL) {
+			xp[0] = r;
+		}
+		return 0;
+	}
+
+	if (n < BIGNAT_INV_NEWTON_THRESHOLD) {
+		uint32_t *tp = digits_alloc(2 * n + 1 + n);
+		uint32_t qh;
+
+		if (tp == NULL) {
+			return ENOMEM;
+		}
+
+		for (size_t i = 0; i < 2 * n; i++) {
+			tp[i] = 0;
+		}
+		tp[2 * n] = 1;
+
+		err = 0;
+		if (n >= BIGNAT_DC_DIV_THRESHOLD) {
+			err = digits_div_dc(rp, tp, 2 * n + 1, dp, n,
+					    tp + 2 * n + 1, &qh);
+		} else {
+			(void)digits_div_basecase(rp, tp, 2 * n + 1, dp, n);
+		}
+		if (err == 0 && xp != NULL) {
+			for (size_t i = 0; i < n; i++) {
+				xp[i] = tp[i];
+			}
+		}
+
+		digits_free(tp);
+		return err;
+	}
+
+	size_t h = (n + 1) / 2;
+	size_t l = n - h;
+	size_t rn = digits_mulmod_bnm1_size(n + 2);
+	uint32_t *tp = digits_alloc((h + 1) + h + 3 * rn + (n + 2));
+	uint32_t *ip = tp;
+	uint32_t *dh = ip + h + 1;
+	uint32_t *ep = dh + h;
+	uint32_t *wp = ep + rn;
+	uint32_t *cp = wp + rn;
+	uint32_t *pp = cp + rn;
+
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	/* 上位h桁に1を足した値の逆数 */
+	if (digits_add_1(dh, dp + l, h, 1) != 0) {
+		for (size_t i = 0; i < h; i++) {
+			ip[i] = 0;
+		}
+		ip[h] = 1;
+	} else {
+		err = digits_invert(ip, NULL, dh, h);
+		if (err != 0) {
+			goto out;
+		}
+	}
+
+	/* B^2n - dp * x = B^l * ep、ep = B^(n + h) - dp * ip < 3 * B^n */
+	err = digits_mulmod_bnm1(wp, rn, dp, n, ip, h + 1);
+	if (err != 0) {
+		goto out;
+	}
+	for (size_t i = 0; i < rn; i++) {
+		cp[i] = i == (n + h) % rn;
+	}
+	digits_sub_bnm1(ep, cp, wp, rn);
+
+	/*
+	 * x' = x + floor(ip * ep / B^2h)。epの下位h桁を切り捨てても誤差は
+	 * 1未満。
+	 */
+	err = digits_mul(pp, ip, h + 1, ep + h, l + 1);
+	if (err != 0) {
+		goto out;
+	}
+	for (size_t i = 0; i < l; i++) {
+		rp[i] = pp[h + i];
+	}
+	(void)digits_add(rp + l, ip, h + 1, pp + h + l, 2);
+
+	/* 剰余 B^2n - dp * x' < B^(n + 1) */
+	err = digits_mulmod_bnm1(wp, rn, dp, n, rp, n + 1);
+	if (err != 0) {
+		goto out;
+	}
+	for (size_t i = 0; i < rn; i++) {
+		cp[i] = i == 2 * n % rn;
+	}
+	digits_sub_bnm1(ep, cp, wp, rn);
+
+	while (ep[n] != 0 || digits_cmp(ep, dp, n) >= 0) {
+		ep[n] -= digits_sub_n(ep, ep, dp, n);
+		(void)digits_add_1(rp, rp, n + 1, 1);
+	}
+
+	if (xp != NULL) {
+		for (size_t i = 0; i < n; i++) {
+			xp[i] = ep[i];
+		}
+	}
+
+out:
+	digits_free(tp);
+	return err;
+}
+
+/*
+ * np[0, wn)をdp[0, dn)で割り、商の下位 wn - dn 桁をqpに、剰余を
+ * np[0, dn)に書き込む。商の最上位の桁(0か1)を*qhに書き込む。
+ * dn < wn <= 2dn。ipはdpの逆数 floor(B^2dn / dp)(dn + 1桁)。rnは
+ * digits_mulmod_bnm1_size(dn + 2)。tpは 2dn + 2 + 2rn 桁の作業領域。
+ *
+ * 商を floor(floor(np / B^(dn - 1)) * ip / B^(dn + 1)) で見積もる。見積
+ * もりは真の値より高々2小さいので、剰余は B^rn - 1 を法として求めれば
+ * 十分で、そこから除数を引いて補正する。
+ */
+static int
+digits_div_inv_block(uint32_t *qp, uint32_t *np, size_t wn,
+		     const uint32_t *dp, size_t dn, const uint32_t *ip,
+		     size_t rn, uint32_t *tp, uint32_t *qh)
+{
+	size_t m = wn - dn;
+	uint32_t *sp = tp + dn + 1;
+	uint32_t *fp = tp + 2 * dn + 2;
+	uint32_t *wp = fp + rn;
+	uint32_t q, top;
+	int err;
+
+	err = digits_mul(tp, np + dn - 1, m + 1, ip, dn + 1);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_mulmod_bnm1(wp, rn, sp, m + 1, dp, dn);
+	if (err != 0) {
+		return err;
+	}
+	digits_fold_bnm1(fp, rn, np, wn);
+	digits_sub_bnm1(fp, fp, wp, rn);
+
+	for (size_t i = 0; i < m; i++) {
+		qp[i] = sp[i];
+	}
+	q = sp[m];
+	for (size_t i = 0; i < dn; i++) {
+		np[i] = fp[i];
+	}
+	top = fp[dn];
+
+	while (top != 0 || digits_cmp(np, dp, dn) >= 0) {
+		top -= digits_sub_n(np, np, dp, dn);
+		q += digits_add_1(qp, qp, m, 1);
+	}
+
+	*qh = q;
+	return 0;
+}
+
+/*
+ * np[0, nn)をdp[0, dn)で割り、商の nn - dn 桁をqpに、剰余をnp[0, dn)に
+ * 書き込む。np[nn - dn, nn)はdpより小さくなければならない。
+ * nn - dn >= BIGNAT_NEWTON_DIV_THRESHOLD、
+ * dn >= BIGNAT_NEWTON_DIV_THRESHOLD。dpは正規化されていなければならない。
+ *
+ * 商が除数より短い場合は、除数の上位の桁だけで商を求めてから補正する。
+ * そうでなければ除数の逆数を一度だけ求め、商を上位からdn桁ずつ求める。
+ */
+static int
+digits_div_newton(uint32_t *qp, uint32_t *np, size_t nn,
+		  const uint32_t *dp, size_t dn)
+{
+	size_t qn = nn - dn;
+	size_t in = min(qn, dn);
+	size_t rn = digits_mulmod_bnm1_size(in + 2);
+	uint32_t *tp = digits_alloc((in + 1) + max(2 * in + 2 + 2 * rn, dn));
+	uint32_t *ip = tp;
+	uint32_t *wp = ip + in + 1;
+	uint32_t q, cy;
+	int err;
+
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	err = digits_invert(ip, NULL, dp + dn - in, in);
+	if (err != 0) {
+		goto out;
+	}
+
+	if (qn < dn) {
+		err = digits_div_inv_block(qp, np + dn - qn, 2 * qn,
+					   dp + dn - qn, qn, ip, rn, wp, &q);
+		if (err != 0) {
+			goto out;
+		}
+
+		err = digits_mul(wp, qp, qn, dp, dn - qn);
+		if (err != 0) {
+			goto out;
+		}
+		cy = digits_sub_n(np, np, wp, dn);
+		if (q != 0) {
+			cy += digits_sub_n(np + qn, np + qn, dp, dn - qn);
+		}
+		while (cy != 0) {
+			q -= digits_sub_1(qp, qp, qn, 1);
+			cy -= digits_add_n(np, np, dp, dn);
+		}
+		goto out;
+	}
+
+	size_t bn = (qn - 1) % dn + 1;
+
+	qn -= bn;
+	err = digits_div_inv_block(qp + qn, np + qn, dn + bn, dp, dn, ip, rn,
+				   wp, &q);
+	while (err == 0 && qn > 0) {
+		qn -= dn;
+		err = digits_div_inv_block(qp + qn, np + qn, 2 * dn, dp, dn,
+					   ip, rn, wp, &q);
+	}
+
+out:
+	digits_free(tp);
+	return err;
+}
+
+/*
+ * np[0, nn)をdp[0, dn)で割り、商の nn - dn 桁をqpに、剰余をnp[0, dn)に
+ * 書き込む。np[nn - dn, nn)はdpより小さくなければならない。
+ * nn > dn >= 2。dpは正規化されていなければならない。tpはdn桁の作業領
+ * 域。桁数に応じてアルゴリズムを選ぶ。
+ */
+static int
+digits_div_qr(uint32_t *qp, uint32_t *np, size_t nn,
+	      const uint32_t *dp, size_t dn, uint32_t *tp)
+{
+	uint32_t qh;
+
+	if (dn >= BIGNAT_NEWTON_DIV_THRESHOLD &&
+	    nn - dn >= BIGNAT_NEWTON_DIV_THRESHOLD) {
+		return digits_div_newton(qp, np, nn, dp, dn);
+	}
+
+	if (dn >= BIGNAT_DC_DIV_THRESHOLD &&
+	    nn - dn >= BIGNAT_DC_DIV_THRESHOLD) {
+		return digits_div_dc(qp, np, nn, dp, dn, tp, &qh);
+	}
+
+	(void)digits_div_basecase(qp, np, nn, dp, dn);
+	return 0;
+}
+
+/* digits_divmod_tpの作業領域の桁数。 */
+static size_t
+digits_divmod_itch(size_t nn, size_t dn)
+{
+	return nn + 1 + 2 * dn;
+}
+
+/*
+ * np[0, nn)をdp[0, dn)で割り、商をqp[0, nn - dn + 1)に、剰余を
+ * rp[0, dn)に書き込む。nn >= dn >= 2。dp[dn - 1] != 0。tpは
+ * digits_divmod_itch(nn, dn)桁の作業領域で、正規化した被除数と除数の写
+ * しを置く。
+ */
+static int
+digits_divmod_tp(uint32_t *qp, uint32_t *rp, const uint32_t *np, size_t nn,
+		 const uint32_t *dp, size_t dn, uint32_t *tp)
+{
+	unsigned cnt = digit_clz(dp[dn - 1]);
+	uint32_t *tn = tp;
+	uint32_t *td = tp + nn + 1;
+
+	if (cnt > 0) {
+		(void)digits_lshift(td, dp, dn, cnt);
+		tn[nn] = digits_lshift(tn, np, nn, cnt);
+	} else {
+		for (size_t i = 0; i < dn; i++) {
+			td[i] = dp[i];
+		}
+		for (size_t i = 0; i < nn; i++) {
+			tn[i] = np[i];
+		}
+		tn[nn] = 0;
+	}
+
+	int err = digits_div_qr(qp, tn, nn + 1, td, dn, td + dn);
+	if (err != 0) {
+		return err;
+	}
+
+	if (cnt > 0) {
+		(void)digits_rshift(rp, tn, dn, cnt);
+	} else {
+		for (size_t i = 0; i < dn; i++) {
+			rp[i] = tn[i];
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * np[0, nn)をdp[0, dn)で割り、商をqp[0, nn - dn + 1)に、剰余を
+ * rp[0, dn)に書き込む。nn >= dn >= 1。dp[dn - 1] != 0。除数を正規化し
+ * た写しのために一度だけ作業領域を確保する。
+ */
+static int
+digits_divmod(uint32_t *qp, uint32_t *rp, const uint32_t *np, size_t nn,
+	      const uint32_t *dp, size_t dn)
+{
+	if (dn == 1) {
+		rp[0] = digits_divmod_1(qp, np, nn, dp[0]);
+		return 0;
+	}
+
+	uint32_t *tp = digits_alloc(digits_divmod_itch(nn, dn));
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	int err = digits_divmod_tp(qp, rp, np, nn, dp, dn, tp);
+	digits_free(tp);
+	return err;
+}
+
+/* xの末尾の0のビット数。x != 0。 */
+static unsigned
+digit_ctz(uint32_t x)
+{
+	unsigned cnt = 0;
+
+	for (unsigned w = 16; w > 0; w /= 2) {
+		if ((x & (((uint32_t)1 << w) - 1)) == 0) {
+			x >>= w;
+			cnt += w;
+		}
+	}
+
+	return cnt;
+}
+
+static unsigned
+digit2_ctz(uint64_t x)
+{
+	return (uint32_t)x != 0 ? digit_ctz(x) : 32 + digit_ctz(x >> 32);
+}
+
+/*
+ * binary GCD
+ *
+ * 2桁に収まる値の最大公約数。除算を使わず、2で割ることと引き算だけで
+ * 求める。
+ */
+static uint64_t
+digit2_gcd(uint64_t a, uint64_t b)
+{
+	unsigned k;
+
+	if (a == 0 || b == 0) {
+		return a | b;
+	}
+
+	k = digit2_ctz(a | b);
+	a >>= digit2_ctz(a);
+	do {
+		b >>= digit2_ctz(b);
+		if (a > b) {
+			uint64_t t = a;
+			a = b;
+			b = t;
+		}
+		b -= a;
+	} while (b != 0);
+
+	return a << k;
+}
+
+/*
+ * Lehmer's algorithm
+ *
+ * a, bの上位64ビット(同じ位置から取り出したもの)ah, bhだけを使って、
+ * a, bに対するEuclidの互除法の最初の数ステップをまとめた行列
+ *
+ *     (a, b)^T = M (a', b')^T、det M = 1
+ *
+ * を求め、mに書き込む。Mの要素は2^32未満になる。a', bが小さくなりすぎ
+ * て商が上位ビットだけでは決まらなくなる手前で止めるので、a', b'はと
+ * もに正になる。1ステップも進められなければ偽を返す。
+ */
+static bool
+digits_hgcd2(uint64_t ah, uint64_t bh, uint32_t m[2][2])
+{
+	const uint64_t lim = (uint64_t)1 << 33;
+	uint64_t u00, u01, u10, u11, q;
+
+	if (ah < lim || bh < lim) {
+		return false;
+	}
+
+	if (ah >= bh) {
+		ah -= bh;
+		if (ah < lim) {
+			return false;
+		}
+		u00 = u01 = u11 = 1;
+		u10 = 0;
+	} else {
+		bh -= ah;
+		if (bh < lim) {
+			return false;
+		}
+		u00 = u10 = u11 = 1;
+		u01 = 0;
+	}
+
+	if (ah < bh) {
+		goto subtract_a;
+	}
+
+	for (;;) {
+		/* ah >= bh */
+		if (ah == bh) {
+			break;
+		}
+		ah -= bh;
+		if (ah < lim) {
+			break;
+		}
+		if (ah <= bh) {
+			u01 += u00;
+			u11 += u10;
+		} else {
+			q = ah / bh;
+			ah -= q * bh;
+			if (ah < lim) {
+				/* 最後の1回分は引かない */
+				u01 += q * u00;
+				u11 += q * u10;
+				break;
+			}
+			q++;
+			u01 += q * u00;
+			u11 += q * u10;
+		}
+
+subtract_a:
+		/* bh >= ah */
+		if (ah == bh) {
+			break;
+		}
+		bh -= ah;
+		if (bh < lim) {
+			break;
+		}
+		if (bh <= ah) {
+			u00 += u01;
+			u10 += u11;
+		} else {
+			q = bh / ah;
+			bh -= q * ah;
+			if (bh < lim) {
+				u00 += q * u01;
+				u10 += q * u11;
+				break;
+			}
+			q++;
+			u00 += q * u01;
+			u10 += q * u11;
+		}
+	}
+
+	m[0][0] = u00;
+	m[0][1] = u01;
+	m[1][0] = u10;
+	m[1][1] = u11;
+	return true;
+}
+
+/*
+ * (a, b)^T = M^-1 (a, b)^T、すなわち
+ *
+ *     a' = m11 * a - m01 * b、b' = m00 * b - m10 * a
+ *
+ * を求める。a'をtp[0, n)に、b'をbp[0, n)に書き込む。a', b'は非負でな
+ * ければならない。
+ */
+static void
+digits_hgcd2_apply(uint32_t *tp, const uint32_t *ap, uint32_t *bp, size_t n,
+		   uint32_t m[2][2])
+{
+	(void)digits_mul_1(tp, ap, n, m[1][1]);
+	(void)digits_submul_1(tp, bp, n, m[0][1]);
+	(void)digits_mul_1(bp, bp, n, m[0][0]);
+	(void)digits_submul_1(bp, ap, n, m[1][0]);
+}
+
+/*
+ * (a, b) M を求める。rp[0, n] = m00 * a + m10 * b、
+ * bp[0, n] = m01 * a + m11 * b。結果の桁数を返す。rpとapは重なっては
+ * ならない。
+ */
+static size_t
+digits_hgcd2_mul_vector(uint32_t *rp, const uint32_t *ap, uint32_t *bp,
+			size_t n, uint32_t m[2][2])
+{
+	uint32_t h0, h1;
+
+	h0 = digits_mul_1(rp, ap, n, m[0][0]);
+	h0 += digits_addmul_1(rp, bp, n, m[1][0]);
+	h1 = digits_mul_1(bp, bp, n, m[1][1]);
+	h1 += digits_addmul_1(bp, ap, n, m[0][1]);
+
+	rp[n] = h0;
+	bp[n] = h1;
+	return n + ((h0 | h1) != 0);
+}
+
+/*
+ * half-GCDで求める行列。要素は下位の桁から並んだn桁の自然数で、それぞ
+ * れalloc桁の領域を持つ。(a, b)^T = M (a', b')^T、det M = 1。
+ */
+typedef struct hgcd_matrix {
+	size_t alloc;
+	size_t n;
+	uint32_t *p[2][2];
+} hgcd_matrix;
+
+/* n桁の入力に対するhgcd_matrixに必要な領域の桁数。 */
+static size_t
+hgcd_matrix_itch(size_t n)
+{
+	return 4 * ((n + 1) / 2 + 1);
+}
+
+/* 単位行列で初期化する。 */
+static void
+hgcd_matrix_init(hgcd_matrix *m, size_t n, uint32_t *p)
+{
+	size_t s = (n + 1) / 2 + 1;
+
+	for (size_t i = 0; i < 4 * s; i++) {
+		p[i] = 0;
+	}
+
+	m->alloc = s;
+	m->n = 1;
+	m->p[0][0] = p;
+	m->p[0][1] = p + s;
+	m->p[1][0] = p + 2 * s;
+	m->p[1][1] = p + 3 * s;
+	m->p[0][0][0] = 1;
+	m->p[1][1][0] = 1;
+}
+
+/*
+ * 列colに列 1 - col のq倍を足す。tpは qn + m->n 桁の作業領域。
+ */
+static int
+hgcd_matrix_update_q(hgcd_matrix *m, const uint32_t *qp, size_t qn,
+		     unsigned col, uint32_t *tp)
+{
+	if (qn == 1) {
+		uint32_t q = qp[0];
+		uint32_t c0, c1;
+
+		c0 = digits_addmul_1(m->p[0][col], m->p[0][1 - col], m->n, q);
+		c1 = digits_addmul_1(m->p[1][col], m->p[1][1 - col], m->n, q);
+		m->p[0][col][m->n] = c0;
+		m->p[1][col][m->n] = c1;
+		m->n += (c0 | c1) != 0;
+		return 0;
+	}
+
+	uint32_t c[2];
+	size_t n;
+	int err;
+
+	/* 積の桁数が領域を超えないように、列 1 - col の先行0を除く */
+	for (n = m->n; n + qn > m->n; n--) {
+		if (m->p[0][1 - col][n - 1] > 0 || m->p[1][1 - col][n - 1] > 0) {
+			break;
+		}
+	}
+
+	for (unsigned row = 0; row < 2; row++) {
+		err = digits_mul(tp, m->p[row][1 - col], n, qp, qn);
+		if (err != 0) {
+			return err;
+		}
+		c[row] = digits_add(m->p[row][col], tp, n + qn,
+				    m->p[row][col], m->n);
+	}
+
+	n += qn;
+	if ((c[0] | c[1]) != 0) {
+		m->p[0][col][n] = c[0];
+		m->p[1][col][n] = c[1];
+		n++;
+	} else {
+		n -= (m->p[0][col][n - 1] | m->p[1][col][n - 1]) == 0;
+	}
+	m->n = n;
+	return 0;
+}
+
+/* M = M M1。M1は要素が1桁の行列。tpは m->n 桁の作業領域。 */
+static void
+hgcd_matrix_mul_1(hgcd_matrix *m, uint32_t m1[2][2], uint32_t *tp)
+{
+	size_t n[2];
+
+	for (unsigned row = 0; row < 2; row++) {
+		for (size_t i = 0; i < m->n; i++) {
+			tp[i] = m->p[row][0][i];
+		}
+		n[row] = digits_hgcd2_mul_vector(m->p[row][0], tp,
+						 m->p[row][1], m->n, m1);
+	}
+
+	m->n = max(n[0], n[1]);
+}
+
+/* M = M M1 */
+static int
+hgcd_matrix_mul(hgcd_matrix *m, const hgcd_matrix *m1)
+{
+	size_t n = m->n + m1->n;
+	uint32_t *tp = digits_alloc(2 * m->n + 2 * n);
+	uint32_t *r0 = tp;
+	uint32_t *r1 = r0 + m->n;
+	uint32_t *t0 = r1 + m->n;
+	uint32_t *t1 = t0 + n;
+	int err = 0;
+
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	for (unsigned row = 0; row < 2 && err == 0; row++) {
+		for (size_t i = 0; i < m->n; i++) {
+			r0[i] = m->p[row][0][i];
+			r1[i] = m->p[row][1][i];
+		}
+
+		for (unsigned col = 0; col < 2 && err == 0; col++) {
+			err = digits_mul(t0, r0, m->n, m1->p[0][col], m1->n);
+			if (err == 0) {
+				err = digits_mul(t1, r1, m->n, m1->p[1][col],
+						 m1->n);
+			}
+			if (err == 0) {
+				m->p[row][col][n] = digits_add_n(
+					m->p[row][col], t0, t1, n);
+			}
+		}
+	}
+
+	digits_free(tp);
+	if (err != 0) {
+		return err;
+	}
+
+	/* 積は高々3桁小さくなる */
+	for (int i = 0; i < 3; i++) {
+		if ((m->p[0][0][n] | m->p[0][1][n] |
+		     m->p[1][0][n] | m->p[1][1][n]) != 0) {
+			break;
+		}
+		n--;
+	}
+	m->n = n + 1;
+	return 0;
+}
+
+/*
+ * 上位の桁 ap[p, n), bp[p, n)だけがMで小さくなっているときに、下位の
+ * p桁にも M^-1 を掛けて a, bを求め直す。新しい桁数を*rnに書き込む。
+ */
+static int
+hgcd_matrix_adjust(const hgcd_matrix *m, size_t *rn, size_t n,
+		   uint32_t *ap, uint32_t *bp, size_t p)
+{
+	uint32_t *tp = digits_alloc(2 * (p + m->n));
+	uint32_t *t0 = tp;
+	uint32_t *t1 = tp + p + m->n;
+	uint32_t ah, bh;
+	int err;
+
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	/* a' = m11 * a - m01 * b、b' = m00 * b - m10 * a */
+	err = digits_mul(t0, m->p[1][1], m->n, ap, p);
+	if (err != 0) {
+		goto out;
+	}
+	err = digits_mul(t1, m->p[1][0], m->n, ap, p);
+	if (err != 0) {
+		goto out;
+	}
+
+	for (size_t i = 0; i < p; i++) {
+		ap[i] = t0[i];
+	}
+	ah = digits_add(ap + p, ap + p, n - p, t0 + p, m->n);
+
+	err = digits_mul(t0, m->p[0][1], m->n, bp, p);
+	if (err != 0) {
+		goto out;
+	}
+	ah -= digits_sub(ap, ap, n, t0, p + m->n);
+
+	err = digits_mul(t0, m->p[0][0], m->n, bp, p);
+	if (err != 0) {
+		goto out;
+	}
+
+	for (size_t i = 0; i < p; i++) {
+		bp[i] = t0[i];
+	}
+	bh = digits_add(bp + p, bp + p, n - p, t0 + p, m->n);
+	bh -= digits_sub(bp, bp, n, t1, p + m->n);
+
+	if ((ah | bh) != 0) {
+		ap[n] = ah;
+		bp[n] = bh;
+		n++;
+	} else if (ap[n - 1] == 0 && bp[n - 1] == 0) {
+		/* 引き算で減るのは高々1桁 */
+		n--;
+	}
+	*rn = n;
+
+out:
+	digits_free(tp);
+	return err;
+}
+
+/*
+ * a, bのうち大きい方から小さい方を1回引き、さらに剰余を取る。ただし、
+ * 結果がs桁以下になる手前で止める。行った操作をMに記録し、新しい桁数
+ * を*rnに書き込む。何もできなければ*rnは0になる。tpは 2n + m->alloc
+ * 桁の作業領域。
+ */
+static int
+digits_hgcd_subdiv_step(size_t *rn, uint32_t *ap, uint32_t *bp, size_t n,
+			size_t s, hgcd_matrix *m, uint32_t *tp)
+{
+	static const uint32_t one = 1;
+	size_t an = digits_normlen(ap, n);
+	size_t bn = digits_normlen(bp, n);
+	unsigned swapped = 0;
+	size_t qn;
+	int c, err;
+
+	*rn = 0;
+
+	/* a < b となるように並べて b -= a とする */
+	if (an == bn) {
+		c = digits_cmp(ap, bp, an);
+		if (c == 0) {
+			return 0;
+		}
+		if (c > 0) {
+			uint32_t *t = ap;
+			ap = bp;
+			bp = t;
+			swapped ^= 1;
+		}
+	} else if (an > bn) {
+		uint32_t *t = ap;
+		size_t tn = an;
+		ap = bp;
+		bp = t;
+		an = bn;
+		bn = tn;
+		swapped ^= 1;
+	}
+
+	if (an <= s) {
+		return 0;
+	}
+
+	(void)digits_sub(bp, bp, bn, ap, an);
+	bn = digits_normlen(bp, bn);
+
+	if (bn <= s) {
+		/* 引き算を取り消す */
+		uint32_t cy = digits_add(bp, ap, an, bp, bn);
+		if (cy != 0) {
+			bp[an] = cy;
+		}
+		return 0;
+	}
+
+	err = hgcd_matrix_update_q(m, &one, 1, swapped, tp);
+	if (err != 0) {
+		return err;
+	}
+
+	if (an == bn) {
+		c = digits_cmp(ap, bp, an);
+		if (c == 0) {
+			*rn = an;
+			return 0;
+		}
+		if (c > 0) {
+			uint32_t *t = ap;
+			ap = bp;
+			bp = t;
+			swapped ^= 1;
+		}
+	} else if (an > bn) {
+		uint32_t *t = ap;
+		size_t tn = an;
+		ap = bp;
+		bp = t;
+		an = bn;
+		bn = tn;
+		swapped ^= 1;
+	}
+
+	err = digits_divmod(tp, bp, bp, bn, ap, an);
+	if (err != 0) {
+		return err;
+	}
+	qn = bn - an + 1;
+	bn = digits_normlen(bp, an);
+
+	if (bn <= s) {
+		/* 商が1大きすぎるので、1減らしてaを足し戻す */
+		if (bn > 0) {
+			uint32_t cy = digits_add(bp, ap, an, bp, bn);
+			if (cy != 0) {
+				bp[an++] = cy;
+			}
+		} else {
+			for (size_t i = 0; i < an; i++) {
+				bp[i] = ap[i];
+			}
+		}
+		(void)digits_sub_1(tp, tp, qn, 1);
+	}
+
+	qn = digits_normlen(tp, qn);
+	if (qn > 0) {
+		err = hgcd_matrix_update_q(m, tp, qn, swapped, tp + qn);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	*rn = an;
+	return 0;
+}
+
+/*
+ * half-GCDの1ステップ。上位64ビットで求めた行列でa, bを小さくし、それ
+ * ができなければ引き算と剰余で小さくする。Mを更新し、新しい桁数を*rn
+ * に書き込む。進めなければ*rnは0になる。n > s。tpは 2n + m->alloc 桁
+ * の作業領域。
+ */
+static int
+digits_hgcd_step(size_t *rn, size_t n, uint32_t *ap, uint32_t *bp, size_t s,
+		 hgcd_matrix *m, uint32_t *tp)
+{
+	uint32_t mask = ap[n - 1] | bp[n - 1];
+	uint64_t ah = (uint64_t)ap[n - 1] << 32 | ap[n - 2];
+	uint64_t bh = (uint64_t)bp[n - 1] << 32 | bp[n - 2];
+	uint32_t m1[2][2];
+
+	if (n == s + 1) {
+		if (mask < 4) {
+			goto subtract;
+		}
+	} else {
+		unsigned cnt = digit_clz(mask);
+
+		if (cnt > 0) {
+			ah = ah << cnt | ap[n - 3] >> (32 - cnt);
+			bh = bh << cnt | bp[n - 3] >> (32 - cnt);
+		}
+	}
+
+	if (digits_hgcd2(ah, bh, m1)) {
+		hgcd_matrix_mul_1(m, m1, tp);
+		for (size_t i = 0; i < n; i++) {
+			tp[i] = ap[i];
+		}
+		digits_hgcd2_apply(ap, tp, bp, n, m1);
+		*rn = n - ((ap[n - 1] | bp[n - 1]) == 0);
+		return 0;
+	}
+
+subtract:
+	return digits_hgcd_subdiv_step(rn, ap, bp, n, s, m, tp);
+}
+
+/*
+ * half-GCD
+ *
+ * ap[0, n), bp[0, n)を、差が s = floor(n / 2) + 1 桁に収まる手前まで
+ * Euclidの互除法で小さくし、その過程をまとめた行列をmに掛ける。mは
+ * n桁に対してhgcd_matrix_init()で初期化したもの。新しい桁数を*rnに書
+ * き込む。小さくできなければ*rnは0になる。
+ *
+ * 上位半分に再帰的に適用して行列を求め、それを全体に掛けて桁数を約3/4
+ * にする。残りも上位の桁に再帰的に適用して、全体で O(M(n) log n) にす
+ * る。
+ */
+static int
+digits_hgcd(size_t *rn, uint32_t *ap, uint32_t *bp, size_t n, hgcd_matrix *m)
+{
+	size_t s = n / 2 + 1;
+	size_t nn;
+	bool success = false;
+	uint32_t *tp;
+	int err = 0;
+
+	*rn = 0;
+	if (n <= s) {
+		return 0;
+	}
+
+	tp = digits_alloc(2 * n + m->alloc);
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	if (n >= BIGNAT_HGCD_THRESHOLD) {
+		size_t n2 = 3 * n / 4 + 1;
+		size_t p = n / 2;
+
+		err = digits_hgcd(&nn, ap + p, bp + p, n - p, m);
+		if (err != 0) {
+			goto out;
+		}
+		if (nn > 0) {
+			err = hgcd_matrix_adjust(m, &n, p + nn, ap, bp, p);
+			if (err != 0) {
+				goto out;
+			}
+			success = true;
+		}
+
+		while (n > n2) {
+			err = digits_hgcd_step(&nn, n, ap, bp, s, m, tp);
+			if (err != 0 || nn == 0) {
+				goto out;
+			}
+			n = nn;
+			success = true;
+		}
+
+		if (n > s + 2) {
+			hgcd_matrix m1;
+			uint32_t *mp;
+
+			p = 2 * s - n + 1;
+			mp = digits_alloc(hgcd_matrix_itch(n - p));
+			if (mp == NULL) {
+				err = ENOMEM;
+				goto out;
+			}
+			hgcd_matrix_init(&m1, n - p, mp);
+
+			err = digits_hgcd(&nn, ap + p, bp + p, n - p, &m1);
+			if (err == 0 && nn > 0) {
+				err = hgcd_matrix_adjust(&m1, &n, p + nn, ap, bp,
+							 p);
+				if (err == 0) {
+					err = hgcd_matrix_mul(m, &m1);
+				}
+				success = true;
+			}
+
+			digits_free(mp);
+			if (err != 0) {
+				goto out;
+			}
+		}
+	}
+
+	for (;;) {
+		err = digits_hgcd_step(&nn, n, ap, bp, s, m, tp);
+		if (err != 0 || nn == 0) {
+			break;
+		}
+		n = nn;
+		success = true;
+	}
+
+out:
+	digits_free(tp);
+	if (err == 0 && success) {
+		*rn = n;
+	}
+	return err;
+}
+
+/*
+ * (u0, u1) = (u0, u1) M。u0, u1はともに*un桁で、結果の桁数を*unに書き
+ * 込む。
+ */
+static int
+hgcd_matrix_mul_row(const hgcd_matrix *m, uint32_t *u0, uint32_t *u1,
+		    size_t *un)
+{
+	size_t n = *un + m->n;
+	uint32_t *tp = digits_alloc(3 * n + 2);
+	uint32_t *t0 = tp;
+	uint32_t *t1 = t0 + n + 1;
+	uint32_t *t2 = t1 + n + 1;
+	int err;
+
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	err = digits_mul(t0, u0, *un, m->p[0][0], m->n);
+	if (err != 0) {
+		goto out;
+	}
+	err = digits_mul(t2, u1, *un, m->p[1][0], m->n);
+	if (err != 0) {
+		goto out;
+	}
+	t0[n] = digits_add_n(t0, t0, t2, n);
+
+	err = digits_mul(t1, u0, *un, m->p[0][1], m->n);
+	if (err != 0) {
+		goto out;
+	}
+	err = digits_mul(t2, u1, *un, m->p[1][1], m->n);
+	if (err != 0) {
+		goto out;
+	}
+	t1[n] = digits_add_n(t1, t1, t2, n);
+
+	n = max(digits_normlen(t0, n + 1), digits_normlen(t1, n + 1));
+	for (size_t i = 0; i < n; i++) {
+		u0[i] = t0[i];
+		u1[i] = t1[i];
+	}
+	*un = n;
+
+out:
+	digits_free(tp);
+	return err;
+}
+
+/*
+ * a, bの上位 n - p 桁 (p = floor(2n / 3)) にhalf-GCDを適用し、求めた行
+ * 列でa, b全体を小さくする。新しい桁数を*rnに書き込む。小さくできなけ
+ * れば*rnは0になる。u0がNULLでなければ、(u0, u1)に行列を右から掛ける。
+ */
+static int
+digits_gcd_hgcd(size_t *rn, uint32_t *ap, uint32_t *bp, size_t n,
+		uint32_t *u0, uint32_t *u1, size_t *un)
+{
+	size_t p = 2 * n / 3;
+	size_t nn;
+	hgcd_matrix m;
+	uint32_t *mp = digits_alloc(hgcd_matrix_itch(n - p));
+	int err;
+
+	*rn = 0;
+	if (mp == NULL) {
+		return ENOMEM;
+	}
+	hgcd_matrix_init(&m, n - p, mp);
+
+	err = digits_hgcd(&nn, ap + p, bp + p, n - p, &m);
+	if (err == 0 && nn > 0) {
+		err = hgcd_matrix_adjust(&m, rn, p + nn, ap, bp, p);
+		if (err == 0 && u0 != NULL) {
+			err = hgcd_matrix_mul_row(&m, u0, u1, un);
+		}
+	}
+
+	digits_free(mp);
+	return err;
+}
+
+/*
+ * ap[0, n)とbp[0, n)の最大公約数をgp[0, max(n, 2))に書き込み、その桁
+ * 数を*gnに書き込む。a, bのどちらかは0でない。apとbpは作業領域として書
+ * き換えられる。tpは 2n + 1 桁の作業領域。
+ *
+ * 上位64ビットから求めた行列でa, bをまとめて小さくしていき(Lehmer)、
+ * 行列が求まらなければ1回だけ剰余を取る。BIGNAT_GCD_HGCD_THRESHOLD桁
+ * 以上の間は、上位の桁にhalf-GCDを適用して求めた行列で小さくする。2桁
+ * 以下になったらbinary GCDに切り替える。
+ */
+static int
+digits_gcd(uint32_t *gp, size_t *gn, uint32_t *ap, uint32_t *bp, size_t n,
+	   uint32_t *tp)
+{
+	uint32_t *qp = tp + n;
+	int err;
+
+	n = max(digits_normlen(ap, n), digits_normlen(bp, n));
+	while (n > 2) {
+		if (n >= BIGNAT_GCD_HGCD_THRESHOLD) {
+			size_t nn;
+
+			err = digits_gcd_hgcd(&nn, ap, bp, n, NULL, NULL, NULL);
+			if (err != 0) {
+				return err;
+			}
+			if (nn > 0) {
+				n = max(digits_normlen(ap, nn),
+					digits_normlen(bp, nn));
+				continue;
+			}
+		} else {
+			uint32_t mask = ap[n - 1] | bp[n - 1];
+			unsigned cnt = digit_clz(mask);
+			uint64_t ah = (uint64_t)ap[n - 1] << 32 | ap[n - 2];
+			uint64_t bh = (uint64_t)bp[n - 1] << 32 | bp[n - 2];
+			uint32_t m[2][2];
+
+			if (cnt > 0) {
+				ah = ah << cnt | ap[n - 3] >> (32 - cnt);
+				bh = bh << cnt | bp[n - 3] >> (32 - cnt);
+			}
+
+			if (digits_hgcd2(ah, bh, m)) {
+				uint32_t *t = ap;
+
+				digits_hgcd2_apply(tp, ap, bp, n, m);
+				ap = tp;
+				tp = t;
+				n = max(digits_normlen(ap, n),
+					digits_normlen(bp, n));
+				continue;
+			}
+		}
+
+		/* 大きい方を小さい方で割った剰余で置き換える */
+		size_t an = digits_normlen(ap, n);
+		size_t bn = digits_normlen(bp, n);
+
+		if (an < bn || (an == bn && digits_cmp(ap, bp, an) < 0)) {
+			uint32_t *t = ap;
+			size_t tn = an;
+
+			ap = bp;
+			bp = t;
+			an = bn;
+			bn = tn;
+		}
+
+		if (bn == 0) {
+			break;
+		}
+
+		err = digits_divmod(qp, ap, ap, an, bp, bn);
+		if (err != 0) {
+			return err;
+		}
+		for (size_t i = bn; i < an; i++) {
+			ap[i] = 0;
+		}
+		n = bn;
+	}
+
+	if (n <= 2) {
+		uint64_t a = n > 1 ? (uint64_t)ap[1] << 32 | ap[0] : ap[0];
+		uint64_t b = n > 1 ? (uint64_t)bp[1] << 32 | bp[0] : bp[0];
+		uint64_t g = digit2_gcd(a, b);
+
+		gp[0] = g;
+		gp[1] = g >> 32;
+		*gn = digits_normlen(gp, 2);
+		return 0;
+	}
+
+	n = digits_normlen(ap, n);
+	for (size_t i = 0; i < n; i++) {
+		gp[i] = ap[i];
+	}
+	*gn = n;
+	return 0;
+}
+
+/*
+ * u1 += q u0。u0, u1はともに*un桁で、結果の桁数を*unに書き込む。tpは
+ * *un + qn + 1 桁の作業領域。
+ */
+static int
+digits_gcdext_addmul(size_t *un, uint32_t *u0, uint32_t *u1,
+		     const uint32_t *qp, size_t qn, uint32_t *tp)
+{
+	size_t n = *un;
+	size_t k;
+	int err;
+
+	if (qn == 1) {
+		u1[n] = digits_addmul_1(u1, u0, n, qp[0]);
+		u0[n] = 0;
+		*un = n + (u1[n] != 0);
+		return 0;
+	}
+
+	err = digits_mul(tp, u0, n, qp, qn);
+	if (err != 0) {
+		return err;
+	}
+	tp[n + qn] = digits_add(tp, tp, n + qn, u1, n);
+
+	k = digits_normlen(tp, n + qn + 1);
+	for (size_t i = 0; i < k; i++) {
+		u1[i] = tp[i];
+	}
+	for (size_t i = n; i < k; i++) {
+		u0[i] = 0;
+	}
+	*un = max(n, k);
+	return 0;
+}
+
+/*
+ * ap[0, n)とbp[0, n)の最大公約数gをgp[0, max(n, 2))に、s a ≡ g (mod b)、
+ * 0 <= s < b / g を満たすsをsp[0, n)に書き込み、それぞれの桁数を*gn、
+ * *snに書き込む。a, bはともに0でない。apとbpは作業領域として書き換え
+ * られる。
+ *
+ * digits_gcd()と同じ手順でa, bを小さくしながら、もとのA, Bについて
+ * (A, B)^T = M (a, b)^T を満たす行列Mの2行目(m10, m11)を記録する。b
+ * が0になったとき、a = g = det M (m11 A - m01 B)、m10 = B / gなので、
+ * s ≡ det M m11 (mod m10) となる。
+ */
+static int
+digits_gcdext(uint32_t *gp, size_t *gn, uint32_t *sp, size_t *sn,
+	      uint32_t *ap, uint32_t *bp, size_t n)
+{
+	uint32_t *wp = digits_alloc(n + 3 * (n + 2) + (n + 1) + (2 * n + 3));
+	uint32_t *tp = wp;
+	uint32_t *u0 = tp + n;
+	uint32_t *u1 = u0 + n + 2;
+	uint32_t *ut = u1 + n + 2;
+	uint32_t *qp = ut + n + 2;
+	uint32_t *xp = qp + n + 1;
+	size_t un = 1;
+	bool neg = false;
+	int err = 0;
+
+	if (wp == NULL) {
+		return ENOMEM;
+	}
+
+	u0[0] = 0;
+	u1[0] = 1;
+
+	n = max(digits_normlen(ap, n), digits_normlen(bp, n));
+	while (n > 2) {
+		if (n >= BIGNAT_GCD_HGCD_THRESHOLD) {
+			size_t nn;
+
+			err = digits_gcd_hgcd(&nn, ap, bp, n, u0, u1, &un);
+			if (err != 0) {
+				goto out;
+			}
+			if (nn > 0) {
+				n = max(digits_normlen(ap, nn),
+					digits_normlen(bp, nn));
+				continue;
+			}
+		} else {
+			uint32_t mask = ap[n - 1] | bp[n - 1];
+			unsigned cnt = digit_clz(mask);
+			uint64_t ah = (uint64_t)ap[n - 1] << 32 | ap[n - 2];
+			uint64_t bh = (uint64_t)bp[n - 1] << 32 | bp[n - 2];
+			uint32_t m[2][2];
+
+			if (cnt > 0) {
+				ah = ah << cnt | ap[n - 3] >> (32 - cnt);
+				bh = bh << cnt | bp[n - 3] >> (32 - cnt);
+			}
+
+			if (digits_hgcd2(ah, bh, m)) {
+				uint32_t *t = ap;
+
+				digits_hgcd2_apply(tp, ap, bp, n, m);
+				ap = tp;
+				tp = t;
+				n = max(digits_normlen(ap, n),
+					digits_normlen(bp, n));
+
+				t = u0;
+				un = digits_hgcd2_mul_vector(ut, u0, u1, un, m);
+				u0 = ut;
+				ut = t;
+				continue;
+			}
+		}
+
+		/* 大きい方を小さい方で割った剰余で置き換える */
+		size_t an = digits_normlen(ap, n);
+		size_t bn = digits_normlen(bp, n);
+
+		if (an < bn || (an == bn && digits_cmp(ap, bp, an) < 0)) {
+			uint32_t *t = ap;
+			size_t tn = an;
+
+			ap = bp;
+			bp = t;
+			an = bn;
+			bn = tn;
+			t = u0;
+			u0 = u1;
+			u1 = t;
+			neg = !neg;
+		}
+
+		if (bn == 0) {
+			break;
+		}
+
+		err = digits_divmod(qp, ap, ap, an, bp, bn);
+		if (err != 0) {
+			goto out;
+		}
+		for (size_t i = bn; i < an; i++) {
+			ap[i] = 0;
+		}
+		err = digits_gcdext_addmul(&un, u0, u1, qp,
+					   digits_normlen(qp, an - bn + 1), xp);
+		if (err != 0) {
+			goto out;
+		}
+		n = bn;
+	}
+
+	if (n <= 2) {
+		uint64_t a = n > 1 ? (uint64_t)ap[1] << 32 | ap[0] : ap[0];
+		uint64_t b = n > 1 ? (uint64_t)bp[1] << 32 | bp[0] : bp[0];
+
+		for (;;) {
+			if (a < b) {
+				uint64_t t = a;
+				uint32_t *tu = u0;
+
+				a = b;
+				b = t;
+				u0 = u1;
+				u1 = tu;
+				neg = !neg;
+			}
+
+			if (b == 0) {
+				break;
+			}
+
+			uint64_t q = a / b;
+			uint32_t qd[2] = {q, q >> 32};
+
+			a %= b;
+			err = digits_gcdext_addmul(&un, u0, u1, qd,
+						   digits_normlen(qd, 2), xp);
+			if (err != 0) {
+				goto out;
+			}
+		}
+
+		gp[0] = a;
+		gp[1] = a >> 32;
+		*gn = digits_normlen(gp, 2);
+	} else {
+		n = digits_normlen(ap, n);
+		for (size_t i = 0; i < n; i++) {
+			gp[i] = ap[i];
+		}
+		*gn = n;
+	}
+
+	/* s = ±m11 mod m10 */
+	size_t mn = digits_normlen(u0, un);
+	size_t kn = digits_normlen(u1, un);
+
+	if (kn > mn || (kn == mn && digits_cmp(u1, u0, kn) >= 0)) {
+		err = digits_divmod(qp, u1, u1, kn, u0, mn);
+		if (err != 0) {
+			goto out;
+		}
+		kn = digits_normlen(u1, mn);
+	}
+
+	if (neg && kn > 0) {
+		(void)digits_sub(sp, u0, mn, u1, kn);
+		*sn = digits_normlen(sp, mn);
+	} else {
+		for (size_t i = 0; i < kn; i++) {
+			sp[i] = u1[i];
+		}
+		*sn = kn;
+	}
+
+out:
+	digits_free(wp);
+	return err;
+}
+
+/*
+ * 剰余演算の法 mp[0, n)。mp[n - 1] != 0。
+ *
+ * 奇数の法ではMontgomery乗算を用い、剰余類aを a R mod m (R = B^n) で
+ * 表す。偶数の法ではBarrett法を用い、正規化した法 d = m 2^cnt とその逆
+ * 数 floor(B^2n / d) で剰余を求める。tpは剰余を求める際の作業領域、rp
+ * は結果を一時的に置くn桁の領域、wpは積の作業領域で
+ * digits_mod_mul_itch(n)桁。
+ */
+typedef struct digits_mod {
+	const uint32_t *mp;
+	size_t n;
+	bool montgomery;
+	uint32_t minv;
+	unsigned cnt;
+	uint32_t *dp;
+	uint32_t *ip;
+	uint32_t *tp;
+	uint32_t *rp;
+	uint32_t *wp;
+} digits_mod;
+
+/* -m^-1 mod B。mは奇数。 */
+static uint32_t
+digit_montgomery_inverse(uint32_t m)
+{
+	/* 1ステップごとに正しいビット数が倍になる */
+	uint32_t inv = m;
+
+	for (int i = 0; i < 4; i++) {
+		inv *= 2 - m * inv;
+	}
+	return -inv;
+}
+
+/* 領域pを割り当てる。pは digits_mod_itch(n) 桁。 */
+static void
+digits_mod_set(digits_mod *mod, const uint32_t *mp, size_t n, bool montgomery,
+	       uint32_t *p)
+{
+	*mod = (digits_mod){
+		.mp=mp,
+		.n=n,
+		.montgomery=montgomery,
+		.cnt=digit_clz(mp[n - 1]),
+		.dp=p,
+		.ip=p + n,
+		.tp=p + 2 * n + 2,
+		.rp=p + 10 * n + 6,
+		.wp=p + 11 * n + 6
+	};
+}
+
+/*
+ * digits_mod_mulとdigits_barrettの積の作業領域の桁数。n桁同士の積と平
+ * 方、Barrett法の n + 1 桁の積を賄う。
+ */
+static size_t
+digits_mod_mul_itch(size_t n)
+{
+	return max(digits_mul_itch(n + 1, n + 1),
+		   max(digits_mul_itch(n + 1, n), digits_mul_itch(n, n)));
+}
+
+static size_t
+digits_mod_itch(size_t n)
+{
+	return 11 * n + 6 + digits_mod_mul_itch(n);
+}
+
+/*
+ * montgomeryが真ならMontgomery乗算の、偽ならBarrett法の準備をする。
+ * Montgomery乗算の法は奇数でなければならない。
+ */
+static int
+digits_mod_init(digits_mod *mod, const uint32_t *mp, size_t n, bool montgomery)
+{
+	uint32_t *p = digits_alloc(digits_mod_itch(n));
+	int err;
+
+	if (p == NULL) {
+		return ENOMEM;
+	}
+
+	digits_mod_set(mod, mp, n, montgomery, p);
+
+	if (mod->montgomery) {
+		mod->minv = digit_montgomery_inverse(mp[0]);
+		return 0;
+	}
+
+	if (mod->cnt > 0) {
+		(void)digits_lshift(mod->dp, mp, n, mod->cnt);
+	} else {
+		for (size_t i = 0; i < n; i++) {
+			mod->dp[i] = mp[i];
+		}
+	}
+
+	err = digits_invert(mod->ip, NULL, mod->dp, n);
+	if (err != 0) {
+		digits_free(p);
+	}
+	return err;
+}
+
+static void
+digits_mod_del(digits_mod *mod)
+{
+	digits_free(mod->dp);
+}
+
+/*
+ * Montgomery reduction
+ *
+ * rp[0, n) = tp[0, 2n) R^-1 mod m。tp < m R。tpは書き換えられる。
+ */
+static void
+digits_redc(uint32_t *rp, uint32_t *tp, const digits_mod *mod)
+{
+	size_t n = mod->n;
+	uint32_t cy;
+
+	/* 下位から1桁ずつ0にする。繰り上がりは空いた桁に置いておく */
+	for (size_t i = 0; i < n; i++) {
+		uint32_t q = tp[i] * mod->minv;
+		tp[i] = digits_addmul_1(tp + i, mod->mp, n, q);
+	}
+
+	cy = digits_add_n(rp, tp + n, tp, n);
+	if (cy != 0 || digits_cmp(rp, mod->mp, n) >= 0) {
+		(void)digits_sub_n(rp, rp, mod->mp, n);
+	}
+}
+
+/*
+ * Barrett reduction
+ *
+ * rp[0, n) = tp[0, 2n) mod m。tp 2^cnt < B^2n。m^2未満の積は常にこれを
+ * 満たす。
+ *
+ * x = t 2^cnt として、q = floor(floor(x / B^(n-1)) floor(B^2n / d) /
+ * B^(n+1)) は真の商より高々2小さい。x - q d は下位 n + 1 桁だけ求めれ
+ * ばよい。
+ *
+ * 桁数が少ないときは、qの積で B^(n-1) 未満の桁に入る外側の積も省く。省
+ * いた分は B^(n+1) 未満なので、qはさらに高々1小さくなるだけである。
+ */
+static void
+digits_barrett(uint32_t *rp, const uint32_t *tp, const digits_mod *mod)
+{
+	size_t n = mod->n;
+	uint32_t *xp = mod->tp + 2 * n;
+	uint32_t *qp = xp + 2 * n + 1;
+	uint32_t *pp = qp + 2 * n + 2;
+
+	if (mod->cnt > 0) {
+		xp[2 * n] = digits_lshift(xp, tp, 2 * n, mod->cnt);
+	} else {
+		for (size_t i = 0; i < 2 * n; i++) {
+			xp[i] = tp[i];
+		}
+	}
+
+	if (n < BIGNAT_KARATSUBA_THRESHOLD) {
+		for (size_t i = n - 1; i < 2 * n + 2; i++) {
+			qp[i] = 0;
+		}
+		for (size_t j = 0; j <= n; j++) {
+			size_t i = j < n - 1 ? n - 1 - j : 0;
+
+			qp[n + 1 + j] = digits_addmul_1(qp + i + j,
+							xp + n - 1 + i,
+							n + 1 - i, mod->ip[j]);
+		}
+
+		for (size_t i = 0; i <= n; i++) {
+			pp[i] = 0;
+		}
+		for (size_t j = 0; j < n; j++) {
+			(void)digits_addmul_1(pp + j, qp + n + 1, n + 1 - j,
+					      mod->dp[j]);
+		}
+	} else {
+		digits_mul_tp(qp, xp + n - 1, n + 1, mod->ip, n + 1, mod->wp);
+		digits_mul_tp(pp, qp + n + 1, n + 1, mod->dp, n, mod->wp);
+	}
+
+	(void)digits_sub_n(xp, xp, pp, n + 1);
+	while (xp[n] != 0 || digits_cmp(xp, mod->dp, n) >= 0) {
+		(void)digits_sub(xp, xp, n + 1, mod->dp, n);
+	}
+
+	if (mod->cnt > 0) {
+		(void)digits_rshift(rp, xp, n, mod->cnt);
+	} else {
+		for (size_t i = 0; i < n; i++) {
+			rp[i] = xp[i];
+		}
+	}
+}
+
+/*
+ * rp[0, n) = ap[0, an) mod m。Barrett法の法に限る。
+ *
+ * 最初に上位の高々2n桁を剰余に置き換え、以降は剰余の下にn桁ずつ付け足
+ * して剰余を取る。付け足した値は m B^n 未満なので、いずれもBarrett法
+ * の前提を満たす。
+ */
+static void
+digits_barrett_reduce(uint32_t *rp, const uint32_t *ap, size_t an,
+		      const digits_mod *mod)
+{
+	size_t n = mod->n;
+	uint32_t *tp = mod->tp;
+	size_t c = min(an, 2 * n);
+	size_t i = an;
+
+	/* 2^cnt倍して2n桁に収まらない場合は1桁減らす */
+	if (c == 2 * n && mod->cnt > 0 && ap[an - 1] >> (32 - mod->cnt) != 0) {
+		c--;
+	}
+
+	for (;;) {
+		i -= c;
+		for (size_t j = 0; j < 2 * n; j++) {
+			tp[j] = j < c ? ap[i + j] : 0;
+		}
+		if (i + c < an) {
+			for (size_t j = 0; j < n; j++) {
+				tp[c + j] = rp[j];
+			}
+		}
+
+		digits_barrett(rp, tp, mod);
+		if (i == 0) {
+			return;
+		}
+		c = min(i, n);
+	}
+}
+
+/* rp[0, n) = ap[0, n) bp[0, n) mod m。rpはap, bpと重なってもよい。 */
+static void
+digits_mod_mul(uint32_t *rp, const uint32_t *ap, const uint32_t *bp,
+	       const digits_mod *mod)
+{
+	if (ap == bp) {
+		digits_sqr_tp(mod->tp, ap, mod->n, mod->wp);
+	} else {
+		digits_mul_tp(mod->tp, ap, mod->n, bp, mod->n, mod->wp);
+	}
+
+	if (mod->montgomery) {
+		digits_redc(rp, mod->tp, mod);
+	} else {
+		digits_barrett(rp, mod->tp, mod);
+	}
+}
+
+/* ap[0, an)を剰余類の表現に変換してrp[0, n)に書き込む。 */
+static int
+digits_mod_to(uint32_t *rp, const uint32_t *ap, size_t an,
+	      const digits_mod *mod)
+{
+	size_t n = mod->n;
+	size_t xn = mod->montgomery ? an + n : max(an, n);
+	uint32_t *xp = digits_alloc(2 * xn + 1);
+	uint32_t *qp = xp + xn;
+	size_t i = 0;
+	int err;
+
+	if (xp == NULL) {
+		return ENOMEM;
+	}
+
+	/* Montgomery乗算では a R を法で割る */
+	if (mod->montgomery) {
+		for (; i < n; i++) {
+			xp[i] = 0;
+		}
+	}
+	for (size_t j = 0; j < an; j++) {
+		xp[i++] = ap[j];
+	}
+	for (; i < xn; i++) {
+		xp[i] = 0;
+	}
+
+	err = digits_divmod(qp, rp, xp, xn, mod->mp, n);
+	digits_free(xp);
+	return err;
+}
+
+/* 剰余類の表現ap[0, n)を通常の値に戻してrp[0, n)に書き込む。 */
+static void
+digits_mod_from(uint32_t *rp, const uint32_t *ap, const digits_mod *mod)
+{
+	size_t n = mod->n;
+
+	if (!mod->montgomery) {
+		for (size_t i = 0; i < n; i++) {
+			rp[i] = ap[i];
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		mod->tp[i] = ap[i];
+		mod->tp[n + i] = 0;
+	}
+	digits_redc(rp, mod->tp, mod);
+}
+
+/* 指数のビット数に対するスライディングウィンドウの幅。 */
+static unsigned
+powm_window(size_t bits)
+{
+	static const size_t limits[] = {7, 25, 81, 241, 673, 1793, 4609};
+	unsigned k = 1;
+
+	while (k <= countof(limits) && bits > limits[k - 1]) {
+		k++;
+	}
+	return k;
+}
+
+/* ap[i / 32]のi % 32ビット目。 */
+static unsigned
+digits_bit(const uint32_t *ap, size_t i)
+{
+	return ap[i / 32] >> (i % 32) & 1;
+}
+
+/*
+ * sliding window
+ *
+ * rp[0, n) = bp[0, bn)^ep[0, en) mod m。ep[en - 1] != 0。
+ *
+ * 幅kのウィンドウで指数を上位から読み、奇数乗 b, b^3, ..., b^(2^k - 1)
+ * の表を引いて掛ける。ウィンドウの間の0のビットでは2乗だけを行う。
+ */
+static int
+digits_powm(uint32_t *rp, const uint32_t *bp, size_t bn, const uint32_t *ep,
+	    size_t en, const digits_mod *mod)
+{
+	size_t n = mod->n;
+	size_t bits = 32 * en - digit_clz(ep[en - 1]);
+	unsigned k = powm_window(bits);
+	size_t tn = (size_t)1 << (k - 1);
+	uint32_t *tab = digits_alloc((tn + 1) * n);
+	uint32_t *sq = tab + tn * n;
+	bool first = true;
+	int err;
+
+	if (tab == NULL) {
+		return ENOMEM;
+	}
+
+	err = digits_mod_to(tab, bp, bn, mod);
+	if (err != 0) {
+		goto out;
+	}
+
+	if (tn > 1) {
+		digits_mod_mul(sq, tab, tab, mod);
+	}
+	for (size_t i = 1; i < tn; i++) {
+		digits_mod_mul(tab + i * n, tab + (i - 1) * n, sq, mod);
+	}
+
+	/* 未処理のビットは [0, i) */
+	for (size_t i = bits; i > 0;) {
+		if (digits_bit(ep, i - 1) == 0) {
+			digits_mod_mul(rp, rp, rp, mod);
+			i--;
+			continue;
+		}
+
+		/* ウィンドウ [j, i) は両端のビットが1 */
+		size_t j = i > k ? i - k : 0;
+		size_t w = 0;
+
+		while (digits_bit(ep, j) == 0) {
+			j++;
+		}
+		for (size_t l = i; l > j; l--) {
+			w = w << 1 | digits_bit(ep, l - 1);
+		}
+
+		if (first) {
+			for (size_t l = 0; l < n; l++) {
+				rp[l] = tab[(w >> 1) * n + l];
+			}
+			first = false;
+		} else {
+			for (size_t l = j; l < i; l++) {
+				digits_mod_mul(rp, rp, rp, mod);
+			}
+			digits_mod_mul(rp, rp, tab + (w >> 1) * n, mod);
+		}
+		i = j;
+	}
+
+	digits_mod_from(rp, rp, mod);
+
+out:
+	digits_free(tab);
+	return err;
+}
+
+/* rp[0, n) = R^2 mod m。 */
+static int
+digits_mont_r2(uint32_t *rp, const uint32_t *mp, size_t n)
+{
+	uint32_t *np = digits_alloc(3 * n + 3);
+	uint32_t *qp = np + 2 * n + 1;
+	int err;
+
+	if (np == NULL) {
+		return ENOMEM;
+	}
+
+	for (size_t i = 0; i < 2 * n; i++) {
+		np[i] = 0;
+	}
+	np[2 * n] = 1;
+	err = digits_divmod(qp, rp, np, 2 * n + 1, mp, n);
+
+	digits_free(np);
+	return err;
+}
+
+/*
+ * 以下のdigits_sec_*は、秘密の値に依存する分岐やメモリアクセスを含ま
+ * ない。処理の流れは桁数だけで決まる。
+ */
+
+/*
+ * rp[0, n) = tp[0, 2n) R^-1 mod m。tp < m R。tpは書き換えられる。xpは
+ * n桁の作業領域。最後の引き算は常に行い、結果をマスクで選ぶ。
+ */
+static void
+digits_sec_redc(uint32_t *rp, uint32_t *tp, const uint32_t *mp, size_t n,
+		uint32_t minv, uint32_t *xp)
+{
+	uint32_t cy, bw, mask;
+
+	for (size_t i = 0; i < n; i++) {
+		uint32_t q = tp[i] * minv;
+		tp[i] = digits_addmul_1(tp + i, mp, n, q);
+	}
+
+	cy = digits_add_n(rp, tp + n, tp, n);
+	bw = digits_sub_n(xp, rp, mp, n);
+	mask = -(cy | (bw ^ 1));
+	for (size_t i = 0; i < n; i++) {
+		rp[i] = (xp[i] & mask) | (rp[i] & ~mask);
+	}
+}
+
+/*
+ * rp[0, n) = ap[0, n) bp[0, n) R^-1 mod m。rpはap, bpと重なってもよい。
+ * tpは 3n 桁の作業領域。積は基本の方法で求める。
+ */
+static void
+digits_sec_mul(uint32_t *rp, const uint32_t *ap, const uint32_t *bp,
+	       const uint32_t *mp, size_t n, uint32_t minv, uint32_t *tp)
+{
+	if (ap == bp) {
+		digits_sqr_basecase(tp, ap, n);
+	} else {
+		digits_mul_basecase(tp, ap, n, bp, n);
+	}
+	digits_sec_redc(rp, tp, mp, n, minv, tp + 2 * n);
+}
+
+/* rp[0, n) = ap[0, n) + bp[0, n) mod m。a, b < m。xpはn桁の作業領域。 */
+static void
+digits_sec_add_mod(uint32_t *rp, const uint32_t *ap, const uint32_t *bp,
+		   const uint32_t *mp, size_t n, uint32_t *xp)
+{
+	uint32_t cy, bw, mask;
+
+	cy = digits_add_n(rp, ap, bp, n);
+	bw = digits_sub_n(xp, rp, mp, n);
+	mask = -(cy | (bw ^ 1));
+	for (size_t i = 0; i < n; i++) {
+		rp[i] = (xp[i] & mask) | (rp[i] & ~mask);
+	}
+}
+
+/*
+ * rp[0, n) = tab[which * n, (which + 1) * n)。表のすべての要素を読み、
+ * マスクで選ぶ。
+ */
+static void
+digits_sec_tabselect(uint32_t *rp, const uint32_t *tab, size_t n,
+		     size_t nents, size_t which)
+{
+	for (size_t i = 0; i < n; i++) {
+		rp[i] = 0;
+	}
+
+	for (size_t k = 0; k < nents; k++) {
+		size_t d = k ^ which;
+		/* k == whichのときだけ全ビットが1になる */
+		uint32_t mask = ((d | (0 - d)) >> (sizeof(size_t) * 8 - 1)) - 1;
+
+		for (size_t i = 0; i < n; i++) {
+			rp[i] |= tab[k * n + i] & mask;
+		}
+	}
+}
+
+/* ap[0, an)のiビット目から上のlビット。l <= 32。 */
+static uint32_t
+digits_getbits(const uint32_t *ap, size_t i, unsigned l)
+{
+	size_t j = i / 32;
+	unsigned s = i % 32;
+	uint64_t w = ap[j] >> s;
+
+	if (s + l > 32) {
+		w |= (uint64_t)ap[j + 1] << (32 - s);
+	}
+	return w & (((uint64_t)1 << l) - 1);
+}
+
+/*
+ * fixed window
+ *
+ * rp[0, n) = bp[0, bn)^ep[0, en) mod m。mは奇数。en >= 1。
+ *
+ * 指数を上位から幅kずつ区切り、各区間でk回の2乗と、b^0, ..., b^(2^k - 1)
+ * の表から定数時間で選んだ値との積を行う。区間の値が0でも掛け算を省
+ * かない。作業領域は最初にまとめて確保する。
+ */
+static int
+digits_powm_sec(uint32_t *rp, const uint32_t *bp, size_t bn,
+		const uint32_t *ep, size_t en, const uint32_t *mp, size_t n)
+{
+	size_t bits = 32 * en;
+	unsigned k = powm_window(bits);
+	size_t tn = (size_t)1 << k;
+	uint32_t minv = digit_montgomery_inverse(mp[0]);
+	uint32_t *wp = digits_alloc((tn + 6) * n);
+	uint32_t *tab = wp;
+	uint32_t *r2 = tab + tn * n;
+	uint32_t *cp = r2 + n;
+	uint32_t *xp = cp + n;
+	uint32_t *tp = xp + n;
+	size_t i;
+	int err;
+
+	if (wp == NULL) {
+		return ENOMEM;
+	}
+
+	/* 法は公開の値なので通常の除算で求める */
+	err = digits_mont_r2(r2, mp, n);
+	if (err != 0) {
+		goto out;
+	}
+
+	/* b R mod m を上位のn桁から順に求める */
+	for (i = 0; i < n; i++) {
+		rp[i] = 0;
+	}
+	for (size_t c = (bn + n - 1) / n; c-- > 0;) {
+		for (i = 0; i < n; i++) {
+			cp[i] = c * n + i < bn ? bp[c * n + i] : 0;
+		}
+		digits_sec_mul(rp, rp, r2, mp, n, minv, tp);
+		digits_sec_mul(cp, cp, r2, mp, n, minv, tp);
+		digits_sec_add_mod(rp, rp, cp, mp, n, xp);
+	}
+
+	/* tab[0] = R mod m、tab[j] = b^j R mod m */
+	for (i = 0; i < n; i++) {
+		tp[i] = r2[i];
+		tp[n + i] = 0;
+	}
+	digits_sec_redc(tab, tp, mp, n, minv, xp);
+	for (i = 0; i < n; i++) {
+		tab[n + i] = rp[i];
+	}
+	for (size_t j = 2; j < tn; j++) {
+		digits_sec_mul(tab + j * n, tab + (j - 1) * n, rp, mp, n, minv,
+			       tp);
+	}
+
+	i = bits % k != 0 ? bits - bits % k : bits - k;
+	digits_sec_tabselect(rp, tab, n, tn, digits_getbits(ep, i, bits - i));
+	while (i > 0) {
+		i -= k;
+		for (unsigned j = 0; j < k; j++) {
+			digits_sec_mul(rp, rp, rp, mp, n, minv, tp);
+		}
+		digits_sec_tabselect(cp, tab, n, tn, digits_getbits(ep, i, k));
+		digits_sec_mul(rp, rp, cp, mp, n, minv, tp);
+	}
+
+	for (i = 0; i < n; i++) {
+		tp[i] = rp[i];
+		tp[n + i] = 0;
+	}
+	digits_sec_redc(rp, tp, mp, n, minv, xp);
+
+out:
+	digits_free(wp);
+	return err;
+}
+
+/*
+ * 基数変換
+ *
+ * base進数の文字列を、base^kがuint32_tに収まる最大のkについてk文字ず
+ * つまとめて扱う。
+ */
+
+static const char digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/*
+ * 文字が表す数。英字は大文字と小文字を区別せず10から35を表す。数字でな
+ * い文字は36とする。分岐を避けるために表を引く。
+ */
+static const unsigned char digit_values[256] = {
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 36, 36, 36, 36, 36, 36,
+	36, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+	25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 36, 36, 36, 36,
+	36, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+	25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+	36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36
+};
+
+static unsigned
+digit_value(char c)
+{
+	return digit_values[(unsigned char)c];
+}
+
+/*
+ * base^(k 2^i) (i = 0, 1, ..., n - 1) の表。p[i]はpn[i]桁で、先行0を
+ * 含まない。
+ */
+typedef struct digits_pow {
+	unsigned base;
+	unsigned k;
+	uint32_t bb;
+	size_t n;
+	uint32_t *p[SIZE_WIDTH];
+	size_t pn[SIZE_WIDTH];
+	uint32_t *buf;
+} digits_pow;
+
+/* base^k < 2^32 となる最大のkを返し、*bbをbase^kとする。 */
+static unsigned
+digits_str_chunk(unsigned base, uint32_t *bb)
+{
+	unsigned k = 1;
+
+	*bb = base;
+	while (*bb <= UINT32_MAX / base) {
+		*bb *= base;
+		k++;
+	}
+	return k;
+}
+
+/* base進数のsn文字を表すのに足りる桁数。 */
+static size_t
+digits_str_limbs(size_t sn, unsigned base)
+{
+	uint32_t bb;
+	unsigned k = digits_str_chunk(base, &bb);
+
+	return sn / k + (sn % k != 0);
+}
+
+/*
+ * 文字数snの分割に必要な分だけ、k 2^i < sn となるiまでの表を作る。表は
+ * 互いに重ならないように一つの領域に置く。p[i]の桁数は2^i以下なので、
+ * 2^i - 1 から始まる2^i桁に置けばよい。
+ */
+static int
+digits_pow_init(digits_pow *pw, unsigned base, size_t sn)
+{
+	size_t n = 1;
+	int err;
+
+	pw->base = base;
+	pw->k = digits_str_chunk(base, &pw->bb);
+	while (n < SIZE_WIDTH - 1 && ((size_t)pw->k << n) < sn) {
+		n++;
+	}
+
+	pw->buf = digits_alloc(((size_t)1 << n) - 1);
+	if (pw->buf == NULL) {
+		return ENOMEM;
+	}
+
+	pw->n = n;
+	pw->p[0] = pw->buf;
+	pw->p[0][0] = pw->bb;
+	pw->pn[0] = 1;
+	for (size_t i = 1; i < n; i++) {
+		pw->p[i] = pw->buf + ((size_t)1 << i) - 1;
+		err = digits_sqr(pw->p[i], pw->p[i - 1], pw->pn[i - 1]);
+		if (err != 0) {
+			digits_free(pw->buf);
+			return err;
+		}
+		pw->pn[i] = digits_normlen(pw->p[i], 2 * pw->pn[i - 1]);
+	}
+
+	return 0;
+}
+
+static void
+digits_pow_del(digits_pow *pw)
+{
+	digits_free(pw->buf);
+}
+
+/*
+ * rp[0, *rn) = sp[0, sn)。sp[0]が最上位の文字。k文字ごとに、それまでの
+ * 値をbase^k倍して足し込む。結果は先行0を含まない。
+ */
+static size_t
+digits_from_str_basecase(uint32_t *rp, const char *sp, size_t sn,
+			 const digits_pow *pw)
+{
+	size_t rn = 0;
+	size_t c = sn % pw->k != 0 ? sn % pw->k : pw->k;
+
+	for (size_t i = 0; i < sn; i += c, c = pw->k) {
+		uint32_t cy = 0;
+
+		for (size_t j = 0; j < c; j++) {
+			cy = cy * pw->base + digit_value(sp[i + j]);
+		}
+
+		for (size_t j = 0; j < rn; j++) {
+			uint64_t t = (uint64_t)rp[j] * pw->bb + cy;
+			rp[j] = t;
+			cy = t >> 32;
+		}
+		if (cy != 0) {
+			rp[rn++] = cy;
+		}
+	}
+
+	return rn;
+}
+
+/*
+ * rp[0, *rn) = sp[0, sn)。k 2^i < sn となる最大のiについて、下位の
+ * k 2^i 文字とそれより上位の文字をそれぞれ変換し、上位を base^(k 2^i)
+ * 倍して足す。
+ *
+ * rpには digits_str_limbs(sn) 桁、tpにはその2倍の桁が必要である。
+ */
+static int
+digits_from_str_dc(uint32_t *rp, size_t *rn, const char *sp, size_t sn,
+		   const digits_pow *pw, uint32_t *tp)
+{
+	size_t i = 0;
+	size_t ln, hn, lrn;
+	int err;
+
+	if (sn < BIGNAT_FROM_STR_DC_THRESHOLD * pw->k) {
+		*rn = digits_from_str_basecase(rp, sp, sn, pw);
+		return 0;
+	}
+
+	while (((size_t)pw->k << (i + 1)) < sn) {
+		i++;
+	}
+	ln = (size_t)pw->k << i;
+
+	/* 上位は2^i桁以下 */
+	err = digits_from_str_dc(tp, &hn, sp, sn - ln, pw,
+				 tp + ((size_t)1 << i));
+	if (err != 0) {
+		return err;
+	}
+
+	if (hn == 0) {
+		return digits_from_str_dc(rp, rn, sp + sn - ln, ln, pw, tp);
+	}
+
+	err = digits_mul(rp, tp, hn, pw->p[i], pw->pn[i]);
+	if (err != 0) {
+		return err;
+	}
+	*rn = hn + pw->pn[i];
+
+	err = digits_from_str_dc(tp, &lrn, sp + sn - ln, ln, pw,
+				 tp + ((size_t)1 << i));
+	if (err != 0) {
+		return err;
+	}
+
+	if (lrn > 0) {
+		(void)digits_add(rp, rp, *rn, tp, lrn);
+	}
+	*rn = digits_normlen(rp, *rn);
+	return 0;
+}
+
+/* baseが2の冪であれば1文字のビット数を、そうでなければ0を返す。 */
+static unsigned
+digits_str_pow2_bits(unsigned base)
+{
+	unsigned b = 0;
+
+	if ((base & (base - 1)) != 0) {
+		return 0;
+	}
+	while ((1u << b) < base) {
+		b++;
+	}
+	return b;
+}
+
+/*
+ * rp[0, *rn) = sp[0, sn)。基数が2^bの場合で、除算も乗算も使わず、下位
+ * の文字から順にbビットずつ詰める。結果は先行0を含まない。
+ */
+static size_t
+digits_from_str_pow2(uint32_t *rp, const char *sp, size_t sn, unsigned b)
+{
+	uint64_t acc = 0;
+	unsigned nb = 0;
+	size_t rn = 0;
+
+	/* 32ビットがbの倍数なら1桁ずつ詰めるだけでよい */
+	if (32 % b == 0) {
+		for (; sn >= 32 / b; sn -= 32 / b) {
+			uint32_t w = 0;
+
+			for (unsigned j = 0; j < 32 / b; j++) {
+				w |= (uint32_t)digit_value(sp[sn - 1 - j]) << b * j;
+			}
+			rp[rn++] = w;
+		}
+	}
+
+	while (sn > 0) {
+		acc |= (uint64_t)digit_value(sp[--sn]) << nb;
+		nb += b;
+		if (nb >= 32) {
+			rp[rn++] = acc;
+			acc >>= 32;
+			nb -= 32;
+		}
+	}
+	if (nb > 0) {
+		rp[rn++] = acc;
+	}
+
+	return digits_normlen(rp, rn);
+}
+
+/*
+ * rp[0, *rn) = sp[0, sn)。spはbase進数の数字だけからなる。rpには
+ * digits_str_limbs(sn, base) 桁が必要である。
+ */
+static int
+digits_from_str(uint32_t *rp, size_t *rn, const char *sp, size_t sn,
+		unsigned base)
+{
+	digits_pow pw = {
+		.base=base
+	};
+	unsigned b = digits_str_pow2_bits(base);
+	uint32_t *tp;
+	int err;
+
+	if (b != 0) {
+		*rn = digits_from_str_pow2(rp, sp, sn, b);
+		return 0;
+	}
+
+	pw.k = digits_str_chunk(base, &pw.bb);
+	if (sn < BIGNAT_FROM_STR_DC_THRESHOLD * pw.k) {
+		*rn = digits_from_str_basecase(rp, sp, sn, &pw);
+		return 0;
+	}
+
+	err = digits_pow_init(&pw, base, sn);
+	if (err != 0) {
+		return err;
+	}
+
+	tp = digits_alloc(2 * digits_str_limbs(sn, base));
+	if (tp == NULL) {
+		digits_pow_del(&pw);
+		return ENOMEM;
+	}
+
+	err = digits_from_str_dc(rp, rn, sp, sn, &pw, tp);
+
+	digits_free(tp);
+	digits_pow_del(&pw);
+	return err;
+}
+
+/*
+ * ceil(2^31 log_base 2)。base進数での桁数の上限を求めるのに使う。
+ */
+static const uint32_t str_log2[37] = {
+	0, 0,
+	0x80000000, 0x50c24e61, 0x40000000, 0x372068d3, 0x3184648e,
+	0x2d983276, 0x2aaaaaab, 0x28612731, 0x268826a2, 0x25001384,
+	0x23b46707, 0x229729f2, 0x219e7ffe, 0x20c33b89, 0x20000000,
+	0x1f50b57f, 0x1eb22cc7, 0x1e21e119, 0x1d9dcd22, 0x1d244c79,
+	0x1cb4058a, 0x1c4bd95c, 0x1bead769, 0x1b90346a, 0x1b3b4340,
+	0x1aeb6f76, 0x1aa038ec, 0x1a593063, 0x1a15f4c4, 0x19d630dd,
+	0x1999999a, 0x195fec81, 0x1928ee7c, 0x18f46ad0, 0x18c23247
+};
+
+/*
+ * ap[0, an)をbase進数で表すのに足りる文字数 ceil(bits log_base 2)。
+ * baseが2の冪であれば過不足ない文字数になる。an >= 1。ap[an - 1] != 0。
+ */
+static size_t
+digits_str_size(const uint32_t *ap, size_t an, unsigned base)
+{
+	size_t bits = 32 * an - digit_clz(ap[an - 1]);
+	unsigned b = digits_str_pow2_bits(base);
+	uint64_t l = str_log2[base];
+
+	if (b != 0) {
+		return bits / b + (bits % b != 0);
+	}
+
+	return (bits >> 31) * l +
+	       (((bits & 0x7fffffff) * l + 0x7fffffff) >> 31);
+}
+
+/*
+ * sp[0, sn) = ap[0, an)。ap[0, an) < base^sn で、足りない上位は'0'で埋
+ * める。base^kで割った剰余からk文字ずつ下位から求める。
+ */
+static void
+digits_to_str_basecase(char *sp, size_t sn, const uint32_t *ap, size_t an,
+		       const digits_pow *pw)
+{
+	uint32_t tp[BIGNAT_TO_STR_DC_THRESHOLD];
+
+	for (size_t i = 0; i < an; i++) {
+		tp[i] = ap[i];
+	}
+
+	while (an > 0) {
+		uint32_t r = digits_divmod_1(tp, tp, an, pw->bb);
+
+		if (tp[an - 1] == 0) {
+			an--;
+		}
+		for (unsigned j = 0; j < pw->k && sn > 0; j++) {
+			sp[--sn] = digit_chars[r % pw->base];
+			r /= pw->base;
+		}
+	}
+
+	while (sn > 0) {
+		sp[--sn] = '0';
+	}
+}
+
+/*
+ * digits_to_str_dcの作業領域の桁数。各段は an + 1 桁に加えて除算に高々
+ * 2 an + 2 桁を使い、pn[i] > (an + 1) / 4 なので商は元の3/4程度に縮む。
+ * よって 5 an 桁で再帰全体が収まる。
+ */
+static size_t
+digits_to_str_itch(size_t an)
+{
+	return 5 * an;
+}
+
+/*
+ * sp[0, sn) = ap[0, an)。ap[0, an) < base^sn。2 pn[i] <= an + 1 となる
+ * 最大のiについてbase^(k 2^i)で割り、商を上位の sn - k 2^i 文字に、剰余
+ * を下位のk 2^i文字に変換する。tpはdigits_to_str_itch(an)桁の作業領域。
+ * 商と剰余を先頭の an + 1 桁に置き、残りを除算と再帰呼び出しで使い回す。
+ */
+static int
+digits_to_str_dc(char *sp, size_t sn, const uint32_t *ap, size_t an,
+		 const digits_pow *pw, uint32_t *tp)
+{
+	size_t i = 0;
+	size_t ln, pn, qn, rn;
+	int err;
+
+	if (an < BIGNAT_TO_STR_DC_THRESHOLD) {
+		digits_to_str_basecase(sp, sn, ap, an, pw);
+		return 0;
+	}
+
+	while (i + 1 < pw->n && 2 * pw->pn[i + 1] <= an + 1) {
+		i++;
+	}
+	ln = (size_t)pw->k << i;
+	pn = pw->pn[i];
+
+	/* 除数はan桁未満なので商は0でなく、sn > ln */
+	err = digits_divmod_tp(tp, tp + an - pn + 1, ap, an, pw->p[i], pn,
+			       tp + an + 1);
+	if (err != 0) {
+		return err;
+	}
+	qn = digits_normlen(tp, an - pn + 1);
+	rn = digits_normlen(tp + an - pn + 1, pn);
+
+	err = digits_to_str_dc(sp, sn - ln, tp, qn, pw, tp + an + 1);
+	if (err != 0) {
+		return err;
+	}
+
+	return digits_to_str_dc(sp + sn - ln, ln, tp + an - pn + 1, rn, pw,
+				tp + an + 1);
+}
+
+/*
+ * sp[0, sn) = ap[0, an)。基数が2^bの場合で、下位のビットから順にb
+ * ビットずつ取り出す。足りない上位は'0'で埋める。
+ */
+static void
+digits_to_str_pow2(char *sp, size_t sn, const uint32_t *ap, size_t an,
+		   unsigned b)
+{
+	uint32_t mask = (1u << b) - 1;
+	uint64_t acc = 0;
+	unsigned nb = 0;
+	size_t i = 0;
+
+	/* 32ビットがbの倍数なら1桁ずつ取り出すだけでよい */
+	if (32 % b == 0) {
+		for (; i < an && sn >= 32 / b; i++) {
+			uint32_t w = ap[i];
+
+			for (unsigned j = 0; j < 32 / b; j++) {
+				sp[--sn] = digit_chars[w & mask];
+				w >>= b;
+			}
+		}
+	}
+
+	while (sn > 0) {
+		if (nb < b) {
+			acc |= (uint64_t)(i < an ? ap[i] : 0) << nb;
+			i++;
+			nb += 32;
+		}
+		sp[--sn] = digit_chars[acc & mask];
+		acc >>= b;
+		nb -= b;
+	}
+}
+
+/* sp[0, sn) = ap[0, an)。ap[0, an) < base^sn。 */
+static int
+digits_to_str(char *sp, size_t sn, const uint32_t *ap, size_t an,
+	      unsigned base)
+{
+	digits_pow pw = {
+		.base=base
+	};
+	unsigned b = digits_str_pow2_bits(base);
+	int err;
+
+	if (b != 0) {
+		digits_to_str_pow2(sp, sn, ap, an, b);
+		return 0;
+	}
+
+	pw.k = digits_str_chunk(base, &pw.bb);
+	if (an < BIGNAT_TO_STR_DC_THRESHOLD) {
+		digits_to_str_basecase(sp, sn, ap, an, &pw);
+		return 0;
+	}
+
+	/* 商と剰余が半分ずつになる程度の冪までで足りる */
+	err = digits_pow_init(&pw, base, sn / 2 + 1);
+	if (err != 0) {
+		return err;
+	}
+
+	uint32_t *tp = digits_alloc(digits_to_str_itch(an));
+	if (tp == NULL) {
+		digits_pow_del(&pw);
+		return ENOMEM;
+	}
+
+	err = digits_to_str_dc(sp, sn, ap, an, &pw, tp);
+
+	digits_free(tp);
+	digits_pow_del(&pw);
+	return err;
+}
+
+/* bignat */
+
+static void
+bignat_norm(bignat *nat)
+{
+	while (nat->ndigits > 0 && nat->digits[nat->ndigits - 1] == 0) {
+		dgtvec_pop(nat);
+	}
+}
+
+int
+bignat_view(bignat *nat, uint32_t *digits, size_t ndigits)
+{
+	if (ndigits > 0 && digits[ndigits - 1] == 0) {
+		return EINVAL;
+	}
+
+	*nat = (bignat){
+		.digits=digits,
+		.ndigits=ndigits,
+		.cap=0
+	};
+	return 0;
+}
+
+int
+bignat_init(bignat *nat, uint32_t *digits, size_t ndigits)
+{
+	if (ndigits > 0 && digits[ndigits - 1] == 0) {
+		return EINVAL;
+	}
+
+	return dgtvec_init(nat, digits, ndigits);
+}
+
+bignat
+bignat_new_zero(void)
+{
+	return dgtvec_new_empty();
+}
+
+int
+bignat_from_digit(bignat *nat, uint32_t n)
+{
+	if (n == 0) {
+		return dgtvec_init(nat, NULL, 0);
+	}
+
+	return dgtvec_init(nat, &n, 1);
+}
+
+int
+bignat_copy(bignat *dst, bignat src)
+{
+	return bignat_init(dst, src.digits, src.ndigits);
+}
+
+int
+bignat_reserve(bignat *nat, size_t ndigits)
+{
+	return dgtvec_reserve(nat, ndigits);
+}
+
+/*
+ * base進数の文字列strの先頭len文字を読む。baseは2以上36以下で、英字は
+ * 大文字と小文字を区別しない。符号、空白、接頭辞は受け付けない。空の場
+ * 合やbase進数の数字でない文字を含む場合はEINVALを返す。
+ */
+int
+bignat_from_strn(bignat *nat, const char *str, size_t len, int base)
+{
+	if (base < 2 || base > 36 || len == 0) {
+		return EINVAL;
+	}
+
+	/* 途中で抜けない方が速い */
+	unsigned max_value = 0;
+	for (size_t i = 0; i < len; i++) {
+		max_value = max(max_value, digit_value(str[i]));
+	}
+	if (max_value >= (unsigned)base) {
+		return EINVAL;
+	}
+
+	int err;
+	size_t n;
+	bignat tmp = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp, digits_str_limbs(len, base));
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_from_str(tmp.digits, &n, str, len, base);
+	if (err != 0) {
+		bignat_del(tmp);
+		return err;
+	}
+
+	(void)dgtvec_resize(&tmp, n);
+	*nat = tmp;
+	return 0;
+}
+
+int
+bignat_from_str(bignat *nat, const char *str, int base)
+{
+	return bignat_from_strn(nat, str, strlen(str), base);
+}
+
+/*
+ * bignat_to_strに必要な、終端のナル文字を含むバッファの大きさ。実際の
+ * 文字数より大きい場合がある。baseが2以上36以下でなければ0を返す。
+ */
+size_t
+bignat_str_size(bignat x, int base)
+{
+	if (base < 2 || base > 36) {
+		return 0;
+	}
+
+	if (x.ndigits == 0) {
+		return 2;
+	}
+
+	return digits_str_size(x.digits, x.ndigits, base) + 1;
+}
+
+/*
+ * xをbase進数の文字列としてstrに書き込む。英字は小文字で、先行0は付け
+ * ない。sizeはstrの大きさで、bignat_str_size(x, base)未満であれば
+ * ERANGEを返す。baseが2以上36以下でなければEINVALを返す。
+ */
+int
+bignat_to_str(char *str, size_t size, bignat x, int base)
+{
+	if (base < 2 || base > 36) {
+		return EINVAL;
+	}
+
+	if (size < bignat_str_size(x, base)) {
+		return ERANGE;
+	}
+
+	if (x.ndigits == 0) {
+		str[0] = '0';
+		str[1] = '\0';
+		return 0;
+	}
+
+	int err;
+	size_t sn = digits_str_size(x.digits, x.ndigits, base);
+	size_t i = 0;
+
+	err = digits_to_str(str, sn, x.digits, x.ndigits, base);
+	if (err != 0) {
+		return err;
+	}
+
+	while (str[i] == '0') {
+		i++;
+	}
+	memmove(str, str + i, sn - i);
+	str[sn - i] = '\0';
+	return 0;
+}
+
+static bool
+host_little_endian(void)
+{
+	return (union { uint32_t u; uint8_t b[4]; }){ .u=1 }.b[0] == 1;
+}
+
+/* 桁数nの記録の見出しのバイト数。 */
+static size_t
+bignat_header_size(size_t n)
+{
+	size_t hn = 2;
+
+	while (n >= 0x80) {
+		n >>= 7;
+		hn++;
+	}
+	return (hn + 3) & ~(size_t)3;
+}
+
+/*
+ * 記録の見出しを読み、符号、桁数、見出しのバイト数を返す。桁の並びが
+ * sizeバイトに収まらない場合や、桁数の符号が最短でない場合、値0に負の
+ * 印がある場合はEINVALを返す。
+ */
+static int
+bignat_get_header(int *sign, size_t *n, size_t *hn, const uint8_t *p,
+		  size_t size)
+{
+	size_t v = 0;
+	size_t i = 1;
+	unsigned shift = 0;
+
+	if (size < 4 || p[0] >> 1 != BIGNUM_FORMAT_VERSION) {
+		return EINVAL;
+	}
+
+	for (;;) {
+		if (i >= size || shift >= SIZE_WIDTH) {
+			return EINVAL;
+		}
+
+		size_t b = p[i] & 0x7f;
+		if (b << shift >> shift != b) {
+			return EINVAL;
+		}
+		v |= b << shift;
+		shift += 7;
+		if ((p[i++] & 0x80) == 0) {
+			break;
+		}
+	}
+
+	/* 最後のバイトが0なら、より短い符号で書けたはず */
+	if (i > 2 && p[i - 1] == 0) {
+		return EINVAL;
+	}
+
+	for (; i % 4 != 0; i++) {
+		if (i >= size || p[i] != 0) {
+			return EINVAL;
+		}
+	}
+
+	if (v > (size - i) / 4 || (v == 0 && (p[0] & 1) != 0)) {
+		return EINVAL;
+	}
+
+	*sign = v == 0 ? 0 : (p[0] & 1) != 0 ? -1 : 1;
+	*n = v;
+	*hn = i;
+	return 0;
+}
+
+/* bignat_exportが書き込むバイト数。常に4の倍数である。 */
+size_t
+bignat_export_size(bignat x)
+{
+	return bignat_header_size(x.ndigits) + 4 * x.ndigits;
+}
+
+/*
+ * xを直列化してbufに書き込む。sizeはbufの大きさで、
+ * bignat_export_size(x)未満であればERANGEを返す。
+ */
+int
+bignat_export(void *buf, size_t size, bignat x)
+{
+	if (size < bignat_export_size(x)) {
+		return ERANGE;
+	}
+
+	uint8_t *p = buf;
+	size_t n = x.ndigits;
+	size_t i = 0;
+
+	p[i++] = BIGNUM_FORMAT_VERSION << 1;
+	do {
+		p[i++] = (n & 0x7f) | (n >= 0x80 ? 0x80 : 0);
+		n >>= 7;
+	} while (n != 0);
+	while (i % 4 != 0) {
+		p[i++] = 0;
+	}
+
+	for (size_t j = 0; j < x.ndigits; j++) {
+		for (unsigned k = 0; k < 4; k++) {
+			p[i + 4 * j + k] = x.digits[j] >> 8 * k;
+		}
+	}
+	return 0;
+}
+
+/*
+ * bufの先頭からsizeバイト以内にある記録を読み、絶対値をnatに、符号を
+ * *signに返す。読んだバイト数を*lenに返す。signがNULLなら負の数の記録
+ * をEINVALとする。viewが真なら複製せずにbuf内の桁の並びを指すビューを
+ * 作る。bignat_importとbigint_importで共有する。
+ */
+int
+bignat_import_record(bignat *nat, int *sign, size_t *len, const void *buf,
+		     size_t size, bool view)
+{
+	const uint8_t *p = buf;
+	int sg;
+	size_t n, hn;
+	int err;
+
+	err = bignat_get_header(&sg, &n, &hn, p, size);
+	if (err != 0) {
+		return err;
+	}
+
+	if (sign == NULL && sg < 0) {
+		return EINVAL;
+	}
+
+	bignat tmp;
+	if (view) {
+		if (!host_little_endian()) {
+			return ENOTSUP;
+		}
+
+		if ((uintptr_t)(p + hn) % sizeof(uint32_t) != 0) {
+			return EINVAL;
+		}
+
+		err = bignat_view(&tmp, n > 0 ? (uint32_t *)(p + hn) : NULL, n);
+		if (err != 0) {
+			return err;
+		}
+	} else {
+		tmp = bignat_new_zero();
+		err = dgtvec_resize(&tmp, n);
+		if (err != 0) {
+			return err;
+		}
+
+		for (size_t j = 0; j < n; j++) {
+			for (unsigned k = 0; k < 4; k++) {
+				tmp.digits[j] |=
+					(uint32_t)p[hn + 4 * j + k] << 8 * k;
+			}
+		}
+
+		if (n > 0 && tmp.digits[n - 1] == 0) {
+			bignat_del(tmp);
+			return EINVAL;
+		}
+	}
+
+	*nat = tmp;
+	if (sign != NULL) {
+		*sign = sg;
+	}
+	*len = hn + 4 * n;
+	return 0;
+}
+
+/*
+ * bufの先頭からsizeバイト以内にある記録を読み、natに複製する。読んだバ
+ * イト数を*lenに返す。記録が壊れている場合はEINVALを返す。
+ */
+int
+bignat_import(bignat *nat, size_t *len, const void *buf, size_t size)
+{
+	return bignat_import_record(nat, NULL, len, buf, size, false);
+}
+
+/*
+ * bignat_importと同じだが、複製せずにbuf内の桁の並びを指すビューを作る。
+ * 桁の並びがuint32_tの境界に揃っていない場合はEINVALを、ホストがリト
+ * ルエンディアンでない場合はENOTSUPを返す。ビューはbufが有効な間だけ使
+ * え、bignat_delに渡してはならない。
+ */
+int
+bignat_import_view(bignat *nat, size_t *len, void *buf, size_t size)
+{
+	return bignat_import_record(nat, NULL, len, buf, size, true);
+}
+
+void
+bignat_del(bignat n)
+{
+	dgtvec_del(n);
+}
+
+int
+bignat_cmp(bignat x, bignat y)
+{
+	if (x.ndigits < y.ndigits) {
+		return -1;
+	}
+
+	if (x.ndigits > y.ndigits) {
+		return 1;
+	}
+
+	/* x.ndigits == y.ndigits */
+
+	for (size_t i = x.ndigits - 1; i < x.ndigits; i--) {
+		if (x.digits[i] < y.digits[i]) {
+			return -1;
+		}
+
+		if (x.digits[i] > y.digits[i]) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+bool
+bignat_eq(bignat x, bignat y)
+{
+	return bignat_cmp(x, y) == 0;
+}
+
+bool
+bignat_ne(bignat x, bignat y)
+{
+	return bignat_cmp(x, y) != 0;
+}
+
+bool
+bignat_lt(bignat x, bignat y)
+{
+	return bignat_cmp(x, y) < 0;
+}
+
+bool
+bignat_gt(bignat x, bignat y)
+{
+	return bignat_cmp(x, y) > 0;
+}
+
+bool
+bignat_le(bignat x, bignat y)
+{
+	return bignat_cmp(x, y) <= 0;
+}
+
+bool
+bignat_ge(bignat x, bignat y)
+{
+	return bignat_cmp(x, y) >= 0;
+}
+
+static int
+bignat_accadd(bignat *dst, bignat src, size_t src_exp)
+{
+	size_t ndigits = dst->ndigits > src.ndigits + src_exp
+		? dst->ndigits
+		: src.ndigits + src_exp;
+	for (size_t i = dst->ndigits; i < ndigits + 1; i++) {
+		int err = dgtvec_push(dst, 0);
+		if (err != 0) {
+			bignat_del(*dst);
+			*dst = bignat_new_zero();
+			return err;
+		}
+	}
+
+	uint32_t carry = 0;
+	size_t i;
+	for (i = 0; i < dst->ndigits - 1; i++) {
+		uint32_t dst_digit, src_digit, digit;
+		uint64_t sum_digit;
+
+		dst_digit = i < dst->ndigits ? dst->digits[i] : 0;
+		src_digit = i >= src_exp && i - src_exp < src.ndigits
+			? src.digits[i - src_exp]
+			: 0;
+		sum_digit = (uint64_t)dst_digit + (uint64_t)src_digit +
+			(uint64_t)carry;
+		digit = sum_digit & ~(uint32_t)0;
+		carry = sum_digit >> 32;
+
+		dst->digits[i] = digit;
+	}
+	dst->digits[i] = carry;
+
+	bignat_norm(dst);
+	return 0;
+}
+
+int
+bignat_add(bignat *sum, bignat x, bignat y)
+{
+	if (y.ndigits == 1) {
+		return bignat_add_digit(sum, x, y.digits[0]);
+	}
+
+	if (x.ndigits == 1) {
+		return bignat_add_digit(sum, y, x.digits[0]);
+	}
+
+	int err = -1;
+	bignat tmp_sum;
+
+	err = bignat_copy(&tmp_sum, x);
+	if (err != 0) {
+		return err;
+	}
+
+	err = bignat_accadd(&tmp_sum, y, 0);
+	if (err != 0) {
+		bignat_del(tmp_sum);
+		return err;
+	}
+
+	*sum = tmp_sum;
+	return 0;
+}
+
+int
+bignat_add_digit(bignat *sum, bignat x, uint32_t y)
+{
+	int err = -1;
+	bignat tmp_sum = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp_sum, x.ndigits + 1);
+	if (err != 0) {
+		return err;
+	}
+
+	tmp_sum.digits[x.ndigits] = digits_add_1(tmp_sum.digits, x.digits,
+						  x.ndigits, y);
+	bignat_norm(&tmp_sum);
+	*sum = tmp_sum;
+	return 0;
+}
+
+static bool
+bignat_lt_exp(bignat x, bignat y, size_t y_exp)
+{
+	if (x.ndigits < y.ndigits + y_exp) {
+		return true;
+	}
+
+	if (x.ndigits > y.ndigits + y_exp) {
+		return false;
+	}
+
+	/* x.ndigits == y.ndigits */
+
+	for (size_t i = x.ndigits - 1; i < x.ndigits; i--) {
+		uint32_t y_digit = i >= y_exp ? y.digits[i - y_exp] : 0;
+
+		if (x.digits[i] < y_digit) {
+			return true;
+		}
+
+		if (x.digits[i] > y_digit) {
+			return false;
+		}
+	}
+
+	return false;
+}
+
+static int
+bignat_accsub(bignat *dst, bignat src, size_t src_exp)
+{
+	if (bignat_lt_exp(*dst, src, src_exp)) {
+		return EDOM;
+	}
+
+	/* *dst >= src * ((2 ** 32) ** src_exp) */
+
+	uint32_t borrow = 0;
+	for (size_t i = 0; i < dst->ndigits; i++) {
+		uint64_t src_digit;
+		uint32_t diff_digit;
+
+		src_digit = i >= src_exp && i - src_exp < src.ndigits
+			? src.digits[i - src_exp]
+			: 0;
+		src_digit += borrow;
+		borrow = dst->digits[i] < src_digit;
+		diff_digit = ((uint64_t)borrow << 32) + (uint64_t)dst->digits[i]
+			- src_digit;
+		dst->digits[i] = diff_digit;
+	}
+
+	bignat_norm(dst);
+	return 0;
+}
+
+int
+bignat_sub(bignat *diff, bignat x, bignat y)
+{
+	if (y.ndigits == 1) {
+		return bignat_sub_digit(diff, x, y.digits[0]);
+	}
+
+	int err = -1;
+	bignat tmp_diff;
+
+	err = bignat_copy(&tmp_diff, x);
+	if (err != 0) {
+		return err;
+	}
+
+	err = bignat_accsub(&tmp_diff, y, 0);
+	if (err != 0) {
+		bignat_del(tmp_diff);
+		return err;
+	}
+
+	*diff = tmp_diff;
+	return 0;
+}
+
+int
+bignat_sub_digit(bignat *diff, bignat x, uint32_t y)
+{
+	if (x.ndigits == 0 ? y != 0 : x.ndigits == 1 && x.digits[0] < y) {
+		return EDOM;
+	}
+
+	int err = -1;
+	bignat tmp_diff = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp_diff, x.ndigits);
+	if (err != 0) {
+		return err;
+	}
+
+	(void)digits_sub_1(tmp_diff.digits, x.digits, x.ndigits, y);
+	bignat_norm(&tmp_diff);
+	*diff = tmp_diff;
+	return 0;
+}
+
+int
+bignat_mul(bignat *prod, bignat x, bignat y)
+{
+	if (x.ndigits < y.ndigits) {
+		return bignat_mul(prod, y, x);
+	}
+
+	if (y.ndigits == 0) {
+		*prod = bignat_new_zero();
+		return 0;
+	}
+
+	if (y.ndigits == 1) {
+		return bignat_mul_digit(prod, x, y.digits[0]);
+	}
+
+	int err = -1;
+	bignat tmp_prod = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp_prod, x.ndigits + y.ndigits);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_mul(tmp_prod.digits, x.digits, x.ndigits,
+			 y.digits, y.ndigits);
+	if (err != 0) {
+		bignat_del(tmp_prod);
+		return err;
+	}
+
+	bignat_norm(&tmp_prod);
+	*prod = tmp_prod;
+	return 0;
+}
+
+int
+bignat_mul_digit(bignat *prod, bignat x, uint32_t y)
+{
+	if (x.ndigits == 0 || y == 0) {
+		*prod = bignat_new_zero();
+		return 0;
+	}
+
+	int err = -1;
+	bignat tmp_prod = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp_prod, x.ndigits + 1);
+	if (err != 0) {
+		return err;
+	}
+
+	tmp_prod.digits[x.ndigits] = digits_mul_1(tmp_prod.digits, x.digits,
+						   x.ndigits, y);
+	bignat_norm(&tmp_prod);
+	*prod = tmp_prod;
+	return 0;
+}
+
+int
+bignat_add_into(bignat *sum, bignat x, bignat y)
+{
+	if (x.ndigits < y.ndigits) {
+		return bignat_add_into(sum, y, x);
+	}
+
+	int err;
+	bool alias_x = x.digits == sum->digits;
+	bool alias_y = y.digits == sum->digits;
+	size_t n = x.ndigits;
+
+	err = dgtvec_resize(sum, n + 1);
+	if (err != 0) {
+		return err;
+	}
+	if (alias_x) {
+		x.digits = sum->digits;
+	}
+	if (alias_y) {
+		y.digits = sum->digits;
+	}
+
+	sum->digits[n] = digits_add(sum->digits, x.digits, n,
+				    y.digits, y.ndigits);
+	bignat_norm(sum);
+	return 0;
+}
+
+int
+bignat_add_digit_into(bignat *sum, bignat x, uint32_t y)
+{
+	int err;
+	bool alias = x.digits == sum->digits;
+	size_t n = x.ndigits;
+
+	err = dgtvec_resize(sum, n + 1);
+	if (err != 0) {
+		return err;
+	}
+	if (alias) {
+		x.digits = sum->digits;
+	}
+
+	sum->digits[n] = digits_add_1(sum->digits, x.digits, n, y);
+	bignat_norm(sum);
+	return 0;
+}
+
+int
+bignat_sub_into(bignat *diff, bignat x, bignat y)
+{
+	if (bignat_lt(x, y)) {
+		return EDOM;
+	}
+
+	int err;
+	bool alias_x = x.digits == diff->digits;
+	bool alias_y = y.digits == diff->digits;
+	size_t n = x.ndigits;
+	uint32_t borrow;
+
+	err = dgtvec_resize(diff, n);
+	if (err != 0) {
+		return err;
+	}
+	if (alias_x) {
+		x.digits = diff->digits;
+	}
+	if (alias_y) {
+		y.digits = diff->digits;
+	}
+
+	borrow = digits_sub_n(diff->digits, x.digits, y.digits, y.ndigits);
+	(void)digits_sub_1(diff->digits + y.ndigits, x.digits + y.ndigits,
+			   n - y.ndigits, borrow);
+	bignat_norm(diff);
+	return 0;
+}
+
+int
+bignat_sub_digit_into(bignat *diff, bignat x, uint32_t y)
+{
+	if (x.ndigits == 0 ? y != 0 : x.ndigits == 1 && x.digits[0] < y) {
+		return EDOM;
+	}
+
+	int err;
+	bool alias = x.digits == diff->digits;
+
+	err = dgtvec_resize(diff, x.ndigits);
+	if (err != 0) {
+		return err;
+	}
+	if (alias) {
+		x.digits = diff->digits;
+	}
+
+	(void)digits_sub_1(diff->digits, x.digits, x.ndigits, y);
+	bignat_norm(diff);
+	return 0;
+}
+
+/*
+ * 積は入力と重ならない領域に求める必要があるので、prodがxかyと同じ場合
+ * はその桁を作業領域に退避してから積を書き込む。
+ */
+int
+bignat_mul_into(bignat *prod, bignat x, bignat y)
+{
+	if (x.ndigits < y.ndigits) {
+		return bignat_mul_into(prod, y, x);
+	}
+
+	if (y.ndigits <= 1) {
+		return bignat_mul_digit_into(prod, x,
+					     y.ndigits == 0 ? 0 : y.digits[0]);
+	}
+
+	int err;
+	bool alias_x = x.digits == prod->digits;
+	bool alias_y = y.digits == prod->digits;
+	size_t n = prod->ndigits;
+	uint32_t *sp = NULL;
+
+	if (alias_x || alias_y) {
+		sp = digits_alloc(n);
+		if (sp == NULL) {
+			return ENOMEM;
+		}
+		for (size_t i = 0; i < n; i++) {
+			sp[i] = prod->digits[i];
+		}
+		if (alias_x) {
+			x.digits = sp;
+		}
+		if (alias_y) {
+			y.digits = sp;
+		}
+	}
+
+	err = dgtvec_resize(prod, x.ndigits + y.ndigits);
+	if (err != 0) {
+		goto fail;
+	}
+
+	err = digits_mul(prod->digits, x.digits, x.ndigits,
+			 y.digits, y.ndigits);
+	if (err != 0) {
+		if (sp == NULL) {
+			prod->ndigits = 0;
+			goto fail;
+		}
+
+		/* 縮めるだけなので失敗しない */
+		(void)dgtvec_resize(prod, n);
+		for (size_t i = 0; i < n; i++) {
+			prod->digits[i] = sp[i];
+		}
+		goto fail;
+	}
+
+	bignat_norm(prod);
+	err = 0;
+fail:
+	digits_free(sp);
+	return err;
+}
+
+int
+bignat_mul_digit_into(bignat *prod, bignat x, uint32_t y)
+{
+	if (x.ndigits == 0 || y == 0) {
+		prod->ndigits = 0;
+		return 0;
+	}
+
+	int err;
+	bool alias = x.digits == prod->digits;
+	size_t n = x.ndigits;
+
+	err = dgtvec_resize(prod, n + 1);
+	if (err != 0) {
+		return err;
+	}
+	if (alias) {
+		x.digits = prod->digits;
+	}
+
+	prod->digits[n] = digits_mul_1(prod->digits, x.digits, n, y);
+	bignat_norm(prod);
+	return 0;
+}
+
+int
+bignat_sqr_into(bignat *sq, bignat x)
+{
+	return bignat_mul_into(sq, x, x);
+}
+
+int
+bignat_divmod_digit_into(bignat *quot, uint32_t *rem, bignat x, uint32_t y)
+{
+	if (y == 0) {
+		return EDOM;
+	}
+
+	int err;
+	bool alias = x.digits == quot->digits;
+
+	err = dgtvec_resize(quot, x.ndigits);
+	if (err != 0) {
+		return err;
+	}
+	if (alias) {
+		x.digits = quot->digits;
+	}
+
+	*rem = digits_divmod_1(quot->digits, x.digits, x.ndigits, y);
+	bignat_norm(quot);
+	return 0;
+}
+
+/*
+ * 失敗したbignat_divmod_intoの書き込み先を元に戻す。srcは書き込み先と
+ * 同じだった入力の写しで、なければNULL。
+ */
+static void
+bignat_divmod_undo(bignat *out, const bignat *src)
+{
+	if (src == NULL) {
+		out->ndigits = 0;
+		return;
+	}
+
+	/* 元の桁数は容量に収まるので失敗しない */
+	(void)dgtvec_resize(out, src->ndigits);
+	for (size_t i = 0; i < src->ndigits; i++) {
+		out->digits[i] = src->digits[i];
+	}
+}
+
+/*
+ * quotとremは別のbignatでなければならない。書き込み先がx, yと同じ場合
+ * は、除算の作業領域と一緒に確保した領域へ入力を退避し、失敗したときに
+ * はそこから書き込み先を元に戻す。
+ */
+int
+bignat_divmod_into(bignat *quot, bignat *rem, bignat x, bignat y)
+{
+	if (y.ndigits == 0) {
+		return EDOM;
+	}
+
+	if (quot == rem) {
+		return EINVAL;
+	}
+
+	int err;
+	size_t xn = x.ndigits;
+	size_t yn = y.ndigits;
+
+	if (xn < yn) {
+		bool alias = x.digits == rem->digits;
+
+		err = dgtvec_resize(rem, xn);
+		if (err != 0) {
+			return err;
+		}
+		if (!alias) {
+			for (size_t i = 0; i < xn; i++) {
+				rem->digits[i] = x.digits[i];
+			}
+		}
+
+		quot->ndigits = 0;
+		return 0;
+	}
+
+	const bignat *qsrc = quot->digits == x.digits ? &x :
+			     quot->digits == y.digits ? &y : NULL;
+	const bignat *rsrc = rem->digits == x.digits ? &x :
+			     rem->digits == y.digits ? &y : NULL;
+	size_t tn = yn > 1 ? digits_divmod_itch(xn, yn) : 0;
+	size_t sn = qsrc != NULL || rsrc != NULL ? xn + yn : 0;
+	uint32_t *tp = NULL;
+
+	if (tn + sn > 0) {
+		tp = digits_alloc(tn + sn);
+		if (tp == NULL) {
+			return ENOMEM;
+		}
+	}
+
+	if (sn > 0) {
+		uint32_t *sp = tp + tn;
+
+		for (size_t i = 0; i < xn; i++) {
+			sp[i] = x.digits[i];
+		}
+		for (size_t i = 0; i < yn; i++) {
+			sp[xn + i] = y.digits[i];
+		}
+		x.digits = sp;
+		y.digits = sp + xn;
+	}
+
+	err = dgtvec_reserve(quot, xn - yn + 1);
+	if (err != 0) {
+		goto out;
+	}
+
+	err = dgtvec_reserve(rem, yn);
+	if (err != 0) {
+		goto out;
+	}
+
+	/* 容量は確保済みなので失敗しない */
+	(void)dgtvec_resize(quot, xn - yn + 1);
+	(void)dgtvec_resize(rem, yn);
+
+	if (yn == 1) {
+		rem->digits[0] = digits_divmod_1(quot->digits, x.digits, xn,
+						 y.digits[0]);
+	} else {
+		err = digits_divmod_tp(quot->digits, rem->digits, x.digits, xn,
+				       y.digits, yn, tp);
+		if (err != 0) {
+			bignat_divmod_undo(quot, qsrc);
+			bignat_divmod_undo(rem, rsrc);
+			goto out;
+		}
+	}
+
+	bignat_norm(quot);
+	bignat_norm(rem);
+
+out:
+	digits_free(tp);
+	return err;
+}
+
+int
+bignat_add_inplace(bignat *acc, bignat x)
+{
+	return bignat_add_into(acc, *acc, x);
+}
+
+int
+bignat_add_digit_inplace(bignat *acc, uint32_t x)
+{
+	return bignat_add_digit_into(acc, *acc, x);
+}
+
+int
+bignat_sub_inplace(bignat *acc, bignat x)
+{
+	return bignat_sub_into(acc, *acc, x);
+}
+
+int
+bignat_sub_digit_inplace(bignat *acc, uint32_t x)
+{
+	return bignat_sub_digit_into(acc, *acc, x);
+}
+
+int
+bignat_mul_inplace(bignat *acc, bignat x)
+{
+	return bignat_mul_into(acc, *acc, x);
+}
+
+int
+bignat_mul_digit_inplace(bignat *acc, uint32_t x)
+{
+	return bignat_mul_digit_into(acc, *acc, x);
+}
+
+int
+bignat_sqr(bignat *sq, bignat x)
+{
+	if (x.ndigits == 0) {
+		*sq = bignat_new_zero();
+		return 0;
+	}
+
+	int err = -1;
+	bignat tmp_sq = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp_sq, 2 * x.ndigits);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_sqr(tmp_sq.digits, x.digits, x.ndigits);
+	if (err != 0) {
+		bignat_del(tmp_sq);
+		return err;
+	}
+
+	bignat_norm(&tmp_sq);
+	*sq = tmp_sq;
+	return 0;
 }
 
 int
 bignat_divmod(bignat *quot, bignat *rem, bignat x, bignat y)
 {
-	if (y.ndigits == 0) {
+	if (y.ndigits == 0) {
+		return EDOM;
+	}
+
+	int err = -1;
+	bignat tmp_quot = bignat_new_zero();
+	bignat tmp_rem = bignat_new_zero();
+
+	if (y.ndigits == 1) {
+		uint32_t r;
+
+		err = bignat_divmod_digit(&tmp_quot, &r, x, y.digits[0]);
+		if (err != 0) {
+			return err;
+		}
+
+		err = bignat_from_digit(&tmp_rem, r);
+		if (err != 0) {
+			bignat_del(tmp_quot);
+			return err;
+		}
+
+		*quot = tmp_quot;
+		*rem = tmp_rem;
+		return 0;
+	}
+
+	if (x.ndigits < y.ndigits) {
+		err = bignat_copy(&tmp_rem, x);
+		if (err != 0) {
+			return err;
+		}
+
+		*quot = tmp_quot;
+		*rem = tmp_rem;
+		return 0;
+	}
+
+	err = dgtvec_resize(&tmp_quot, x.ndigits - y.ndigits + 1);
+	if (err != 0) {
+		goto fail;
+	}
+
+	err = dgtvec_resize(&tmp_rem, y.ndigits);
+	if (err != 0) {
+		goto fail;
+	}
+
+	err = digits_divmod(tmp_quot.digits, tmp_rem.digits,
+			    x.digits, x.ndigits, y.digits, y.ndigits);
+	if (err != 0) {
+		goto fail;
+	}
+
+	bignat_norm(&tmp_quot);
+	bignat_norm(&tmp_rem);
+	*quot = tmp_quot;
+	*rem = tmp_rem;
+	return 0;
+
+fail:
+	bignat_del(tmp_quot);
+	bignat_del(tmp_rem);
+	return err;
+}
+
+int
+bignat_divmod_digit(bignat *quot, uint32_t *rem, bignat x, uint32_t y)
+{
+	if (y == 0) {
 		return EDOM;
 	}
 
 	int err = -1;
 	bignat tmp_quot = bignat_new_zero();
-	bignat tmp_rem = bignat_new_zero();
+	uint32_t tmp_rem;
 
-	err = bignat_copy(&tmp_rem, x);
+	err = dgtvec_resize(&tmp_quot, x.ndigits);
 	if (err != 0) {
-		goto fail;
+		return err;
+	}
+
+	tmp_rem = digits_divmod_1(tmp_quot.digits, x.digits, x.ndigits, y);
+	bignat_norm(&tmp_quot);
+	*quot = tmp_quot;
+	*rem = tmp_rem;
+	return 0;
+}
+
+/*
+ * inv = floor(B^2n / x)。B = 2^32、nはxの桁数。
+ *
+ * 正規化した除数 x * 2^c の逆数 r0 と剰余 e0 から、
+ * floor(B^2n / x) = r0 * 2^c + floor(e0 / x) として求める。
+ */
+int
+bignat_invert(bignat *inv, bignat x)
+{
+	if (x.ndigits == 0) {
+		return EDOM;
 	}
 
-	for (size_t cur_rem_ndigits = tmp_rem.ndigits;
-	     cur_rem_ndigits >= y.ndigits;
-	     cur_rem_ndigits--) {
-		uint64_t x_digit, qd;
-		uint32_t quot_digit;
+	int err;
+	size_t n = x.ndigits;
+	unsigned cnt = digit_clz(x.digits[n - 1]);
+	bignat tmp = bignat_new_zero();
+	uint32_t *tp = digits_alloc(3 * n + 1);
+	uint32_t *dp = tp;
+	uint32_t *ep = dp + n;
+	uint32_t *rp = ep + n;
 
-		x_digit = cur_rem_ndigits < tmp_rem.ndigits
-			? (uint64_t)tmp_rem.digits[cur_rem_ndigits] << 32
-			: 0;
-		x_digit += tmp_rem.digits[cur_rem_ndigits - 1];
+	if (tp == NULL) {
+		return ENOMEM;
+	}
 
-		qd = x_digit / y.digits[y.ndigits - 1];
-		quot_digit = min(qd, UINT32_MAX);
+	err = dgtvec_resize(&tmp, n + 2);
+	if (err != 0) {
+		goto fail;
+	}
 
-		bignat quot_digit_view;
-		bignat prod;
-		size_t y_exp;
-	asymp:
-		quot_digit_view = bignat_view_from_digit(&quot_digit);
-		err = bignat_mul(&prod, y, quot_digit_view);
+	if (cnt == 0) {
+		err = digits_invert(tmp.digits, NULL, x.digits, n);
 		if (err != 0) {
 			goto fail;
 		}
+	} else {
+		uint32_t q;
 
-		y_exp = cur_rem_ndigits - y.ndigits;
-		err = bignat_accsub(&tmp_rem, prod, y_exp);
-		bignat_del(prod);
-		if (err == EDOM) {
-			quot_digit--;
-			goto asymp;
-		} else if (err != 0) {
+		(void)digits_lshift(dp, x.digits, n, cnt);
+		err = digits_invert(rp, ep, dp, n);
+		if (err != 0) {
 			goto fail;
 		}
+		tmp.digits[n + 1] = digits_lshift(tmp.digits, rp, n + 1,
+						  cnt);
 
-		err = bignat_accadd(&tmp_quot, quot_digit_view, y_exp);
+		err = digits_divmod(&q, dp, ep, n, x.digits, n);
 		if (err != 0) {
 			goto fail;
 		}
+		(void)digits_add_1(tmp.digits, tmp.digits, n + 2, q);
 	}
 
-	*quot = tmp_quot;
-	*rem = tmp_rem;
+	digits_free(tp);
+	bignat_norm(&tmp);
+	*inv = tmp;
 	return 0;
 
 fail:
-	bignat_del(tmp_quot);
-	bignat_del(tmp_rem);
+	digits_free(tp);
+	bignat_del(tmp);
 	return err;
 }
 
-/* Euclidean algorithm */
+/* Lehmer's algorithm */
 int
 bignat_gcd(bignat *gcd, bignat x, bignat y)
 {
-	if (bignat_lt(x, y)) {
-		return bignat_gcd(gcd, y, x);
+	if (y.ndigits == 0) {
+		return bignat_copy(gcd, x);
+	}
+
+	if (x.ndigits == 0) {
+		return bignat_copy(gcd, y);
 	}
 
 	int err;
-	bignat tmp_x = bignat_new_zero();
-	bignat tmp_y = bignat_new_zero();
-	bignat tmp_quot = bignat_new_zero();
-	bignat tmp_rem = bignat_new_zero();
+	size_t n = max(x.ndigits, y.ndigits);
+	size_t gn;
+	bignat tmp_gcd = bignat_new_zero();
+	uint32_t *tp = digits_alloc(4 * n + 1);
+	uint32_t *ap = tp;
+	uint32_t *bp = ap + n;
+
+	if (tp == NULL) {
+		return ENOMEM;
+	}
 
-	err = bignat_copy(&tmp_x, x);
+	err = dgtvec_resize(&tmp_gcd, max(n, 2));
 	if (err != 0) {
 		goto fail;
 	}
 
-	err = bignat_copy(&tmp_y, y);
+	for (size_t i = 0; i < n; i++) {
+		ap[i] = i < x.ndigits ? x.digits[i] : 0;
+		bp[i] = i < y.ndigits ? y.digits[i] : 0;
+	}
+
+	err = digits_gcd(tmp_gcd.digits, &gn, ap, bp, n, bp + n);
 	if (err != 0) {
 		goto fail;
 	}
 
-	while (tmp_y.ndigits != 0) {
-		err = bignat_divmod(&tmp_quot, &tmp_rem, tmp_x, tmp_y);
+	digits_free(tp);
+	(void)dgtvec_resize(&tmp_gcd, gn);
+	*gcd = tmp_gcd;
+	return 0;
+
+fail:
+	digits_free(tp);
+	bignat_del(tmp_gcd);
+	return err;
+}
+
+/*
+ * gcdとともに、s * x ≡ gcd (mod y)、0 <= s < y / gcd を満たすsを求める。
+ * yが0の場合、sはxが0なら0、そうでなければ1とする。
+ */
+int
+bignat_gcdext(bignat *gcd, bignat *s, bignat x, bignat y)
+{
+	int err;
+	bignat tmp_gcd = bignat_new_zero();
+	bignat tmp_s = bignat_new_zero();
+
+	if (x.ndigits == 0 || y.ndigits == 0) {
+		err = bignat_copy(&tmp_gcd, y.ndigits == 0 ? x : y);
 		if (err != 0) {
-			goto fail;
+			return err;
+		}
+
+		err = bignat_from_digit(&tmp_s,
+					y.ndigits == 0 && x.ndigits != 0);
+		if (err != 0) {
+			bignat_del(tmp_gcd);
+			return err;
 		}
-		bignat_del(tmp_quot);
-		tmp_quot = bignat_new_zero();
 
-		bignat_del(tmp_x);
-		tmp_x = tmp_y;
-		tmp_y = tmp_rem;
-		tmp_rem = bignat_new_zero();
+		*gcd = tmp_gcd;
+		*s = tmp_s;
+		return 0;
 	}
 
-	bignat_del(tmp_y);
-	bignat_del(tmp_quot);
-	bignat_del(tmp_rem);
-	*gcd = tmp_x;
+	size_t n = max(x.ndigits, y.ndigits);
+	size_t gn, sn;
+	uint32_t *tp = digits_alloc(2 * n);
+	uint32_t *ap = tp;
+	uint32_t *bp = ap + n;
+
+	if (tp == NULL) {
+		return ENOMEM;
+	}
+
+	err = dgtvec_resize(&tmp_gcd, max(n, 2));
+	if (err != 0) {
+		goto fail;
+	}
+
+	err = dgtvec_resize(&tmp_s, n);
+	if (err != 0) {
+		goto fail;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		ap[i] = i < x.ndigits ? x.digits[i] : 0;
+		bp[i] = i < y.ndigits ? y.digits[i] : 0;
+	}
+
+	err = digits_gcdext(tmp_gcd.digits, &gn, tmp_s.digits, &sn, ap, bp, n);
+	if (err != 0) {
+		goto fail;
+	}
+
+	digits_free(tp);
+	(void)dgtvec_resize(&tmp_gcd, gn);
+	(void)dgtvec_resize(&tmp_s, sn);
+	*gcd = tmp_gcd;
+	*s = tmp_s;
 	return 0;
 
 fail:
-	bignat_del(tmp_x);
-	bignat_del(tmp_y);
-	bignat_del(tmp_quot);
-	bignat_del(tmp_rem);
+	digits_free(tp);
+	bignat_del(tmp_gcd);
+	bignat_del(tmp_s);
+	return err;
+}
+
+/*
+ * powm = base^exp mod mod。modが0の場合はEDOMを返す。奇数の法では
+ * Montgomery乗算を、偶数の法ではBarrett法を用いる。乗算の作業領域は
+ * digits_mod_initで一度だけ確保し、各乗算で使い回す。
+ */
+int
+bignat_powm(bignat *powm, bignat base, bignat exp, bignat mod)
+{
+	if (mod.ndigits == 0) {
+		return EDOM;
+	}
+
+	if (mod.ndigits == 1 && mod.digits[0] == 1) {
+		return bignat_from_digit(powm, 0);
+	}
+
+	if (exp.ndigits == 0) {
+		return bignat_from_digit(powm, 1);
+	}
+
+	if (base.ndigits == 0) {
+		return bignat_from_digit(powm, 0);
+	}
+
+	int err;
+	digits_mod m;
+	bignat tmp = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp, mod.ndigits);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_mod_init(&m, mod.digits, mod.ndigits,
+			      (mod.digits[0] & 1) != 0);
+	if (err != 0) {
+		goto fail;
+	}
+
+	err = digits_powm(tmp.digits, base.digits, base.ndigits, exp.digits,
+			  exp.ndigits, &m);
+	digits_mod_del(&m);
+	if (err != 0) {
+		goto fail;
+	}
+
+	bignat_norm(&tmp);
+	*powm = tmp;
+	return 0;
+
+fail:
+	bignat_del(tmp);
+	return err;
+}
+
+/*
+ * 秘密の指数のためのbignat_powm。処理の流れとメモリアクセスはbase, exp
+ * の値によらず、各引数の桁数だけで決まる。modが奇数でなければEDOMを返
+ * す。
+ */
+int
+bignat_powm_sec(bignat *powm, bignat base, bignat exp, bignat mod)
+{
+	if (mod.ndigits == 0 || (mod.digits[0] & 1) == 0) {
+		return EDOM;
+	}
+
+	if (exp.ndigits == 0) {
+		/* modが1のときだけ0になる */
+		return bignat_from_digit(powm,
+					 mod.ndigits > 1 || mod.digits[0] != 1);
+	}
+
+	int err;
+	bignat tmp = bignat_new_zero();
+
+	err = dgtvec_resize(&tmp, mod.ndigits);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_powm_sec(tmp.digits, base.digits, base.ndigits,
+			      exp.digits, exp.ndigits, mod.digits,
+			      mod.ndigits);
+	if (err != 0) {
+		bignat_del(tmp);
+		return err;
+	}
+
+	bignat_norm(&tmp);
+	*powm = tmp;
+	return 0;
+}
+
+int
+bignat_mont_init(bignat_mont_ctx *ctx, bignat mod)
+{
+	if (mod.ndigits == 0 || (mod.digits[0] & 1) == 0) {
+		return EDOM;
+	}
+
+	int err;
+	size_t n = mod.ndigits;
+	bignat tmp_mod = bignat_new_zero();
+	bignat tmp_r2 = bignat_new_zero();
+	uint32_t *scratch = digits_alloc(4 * n + digits_mod_mul_itch(n));
+
+	if (scratch == NULL) {
+		return ENOMEM;
+	}
+
+	err = bignat_copy(&tmp_mod, mod);
+	if (err != 0) {
+		goto fail;
+	}
+
+	err = dgtvec_resize(&tmp_r2, n);
+	if (err != 0) {
+		goto fail;
+	}
+
+	err = digits_mont_r2(tmp_r2.digits, mod.digits, n);
+	if (err != 0) {
+		goto fail;
+	}
+
+	*ctx = (bignat_mont_ctx){
+		.mod=tmp_mod,
+		.r2=tmp_r2,
+		.minv=digit_montgomery_inverse(mod.digits[0]),
+		.scratch=scratch
+	};
+	return 0;
+
+fail:
+	digits_free(scratch);
+	bignat_del(tmp_mod);
+	bignat_del(tmp_r2);
 	return err;
 }
+
+void
+bignat_mont_del(bignat_mont_ctx ctx)
+{
+	bignat_del(ctx.mod);
+	bignat_del(ctx.r2);
+	digits_free(ctx.scratch);
+}
+
+/*
+ * *out = x y R^-1 mod m。x, yは法未満。x, yの桁は作業領域に写してから
+ * 使うので、outはx, yと同じでもよい。
+ */
+static int
+bignat_mont_redc_mul(bignat *out, bignat x, bignat y, bool sqr,
+		     bignat_mont_ctx *ctx)
+{
+	size_t n = ctx->mod.ndigits;
+	uint32_t *tp = ctx->scratch;
+	uint32_t *ap = tp + 2 * n;
+	uint32_t *bp = ap + n;
+	digits_mod mod = {
+		.mp=ctx->mod.digits,
+		.n=n,
+		.montgomery=true,
+		.minv=ctx->minv,
+		.tp=tp,
+		.wp=bp + n
+	};
+	int err;
+
+	for (size_t i = 0; i < n; i++) {
+		ap[i] = i < x.ndigits ? x.digits[i] : 0;
+		bp[i] = i < y.ndigits ? y.digits[i] : 0;
+	}
+
+	err = dgtvec_resize(out, n);
+	if (err != 0) {
+		return err;
+	}
+
+	digits_mod_mul(out->digits, ap, sqr ? ap : bp, &mod);
+	bignat_norm(out);
+	return 0;
+}
+
+int
+bignat_mont_to(bignat *mont, bignat x, bignat_mont_ctx *ctx)
+{
+	if (bignat_lt(x, ctx->mod)) {
+		/* x R = x R^2 R^-1 */
+		return bignat_mont_redc_mul(mont, x, ctx->r2, false, ctx);
+	}
+
+	int err;
+	size_t n = ctx->mod.ndigits;
+	digits_mod mod = {
+		.mp=ctx->mod.digits,
+		.n=n,
+		.montgomery=true,
+		.minv=ctx->minv,
+		.tp=ctx->scratch
+	};
+
+	err = dgtvec_resize(mont, n);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_mod_to(mont->digits, x.digits, x.ndigits, &mod);
+	if (err != 0) {
+		return err;
+	}
+
+	bignat_norm(mont);
+	return 0;
+}
+
+int
+bignat_mont_from(bignat *x, bignat mont, bignat_mont_ctx *ctx)
+{
+	/* x = x R * 1 * R^-1 */
+	bignat one = {
+		.digits=(uint32_t[]){1},
+		.ndigits=1,
+		.cap=0
+	};
+
+	if (bignat_ge(mont, ctx->mod)) {
+		return EDOM;
+	}
+
+	return bignat_mont_redc_mul(x, mont, one, false, ctx);
+}
+
+int
+bignat_mont_mul(bignat *prod, bignat x, bignat y, bignat_mont_ctx *ctx)
+{
+	if (bignat_ge(x, ctx->mod) || bignat_ge(y, ctx->mod)) {
+		return EDOM;
+	}
+
+	return bignat_mont_redc_mul(prod, x, y, false, ctx);
+}
+
+int
+bignat_mont_sqr(bignat *sq, bignat x, bignat_mont_ctx *ctx)
+{
+	if (bignat_ge(x, ctx->mod)) {
+		return EDOM;
+	}
+
+	return bignat_mont_redc_mul(sq, x, x, true, ctx);
+}
+
+int
+bignat_barrett_init(bignat_barrett_ctx *ctx, bignat mod)
+{
+	if (mod.ndigits == 0) {
+		return EDOM;
+	}
+
+	int err;
+	size_t n = mod.ndigits;
+	bignat tmp_mod = bignat_new_zero();
+	digits_mod m;
+
+	err = bignat_copy(&tmp_mod, mod);
+	if (err != 0) {
+		return err;
+	}
+
+	err = digits_mod_init(&m, tmp_mod.digits, n, false);
+	if (err != 0) {
+		bignat_del(tmp_mod);
+		return err;
+	}
+
+	*ctx = (bignat_barrett_ctx){
+		.mod=tmp_mod,
+		.scratch=m.dp
+	};
+	return 0;
+}
+
+void
+bignat_barrett_del(bignat_barrett_ctx ctx)
+{
+	bignat_del(ctx.mod);
+	digits_free(ctx.scratch);
+}
+
+int
+bignat_barrett_reduce(bignat *rem, bignat x, bignat_barrett_ctx *ctx)
+{
+	int err;
+	size_t n = ctx->mod.ndigits;
+	digits_mod m;
+
+	digits_mod_set(&m, ctx->mod.digits, n, false, ctx->scratch);
+
+	if (x.ndigits < n) {
+		/* 法より桁数が少なければ法未満 */
+		uint32_t *digits = x.digits;
+
+		err = dgtvec_resize(rem, x.ndigits);
+		if (err != 0) {
+			return err;
+		}
+		if (rem->digits != digits) {
+			for (size_t i = 0; i < x.ndigits; i++) {
+				rem->digits[i] = digits[i];
+			}
+		}
+		return 0;
+	}
+
+	/* remがxと同じでもよいように、結果は作業領域に置いてから写す */
+	digits_barrett_reduce(m.rp, x.digits, x.ndigits, &m);
+
+	err = dgtvec_resize(rem, n);
+	if (err != 0) {
+		return err;
+	}
+	for (size_t i = 0; i < n; i++) {
+		rem->digits[i] = m.rp[i];
+	}
+
+	bignat_norm(rem);
+	return 0;
+}
@@ -5,10 +5,78 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/*
+ * bignat, bigint, bigratの直列化形式。値ごとの記録は、タグ1バイト、桁
+ * 数のLEB128符号、4の倍数のバイト数になるまでの0埋め、リトルエンディア
+ * ンの桁の並びからなる。タグは BIGNUM_FORMAT_VERSION << 1 で、負の数で
+ * は最下位ビットを立てる。bigratは分子と分母の記録を続けて並べる。
+ *
+ * 記録の長さは常に4の倍数なので、4バイト境界から書き始めた記録の桁の
+ * 並びはすべて境界に揃い、*_import_viewで複製せずに参照できる。
+ */
+#define BIGNUM_FORMAT_VERSION 1
+
+/* allocator */
+
+/*
+ * 領域の確保と解放に使う関数の組。allocはsizeバイトを確保し、reallocは
+ * old_sizeバイトの領域pをnew_sizeバイトに広げ、freeはsizeバイトの領域p
+ * を解放する。allocとreallocは失敗した場合NULLを返し、reallocはその場
+ * 合pを変えない。ctxは各関数の第1引数にそのまま渡す。
+ *
+ * 確保した領域は、確保したときと同じ関数の組で解放しなければならない。
+ * 値が残っている間に関数の組を切り替えてはならない。
+ */
+typedef struct bignum_allocator {
+	void *(*alloc)(void *ctx, size_t size);
+	void *(*realloc)(void *ctx, void *p, size_t old_size, size_t new_size);
+	void (*free)(void *ctx, void *p, size_t size);
+	void *ctx;
+} bignum_allocator;
+
+void bignum_set_allocator(const bignum_allocator *alloc);
+void bignum_set_thread_allocator(const bignum_allocator *alloc);
+void bignum_get_allocator(bignum_allocator *alloc);
+
+/*
+ * 一時的な値のための領域。bignum_arena_beginからbignum_arena_endまでの
+ * 間に呼び出したスレッドで確保する領域は、arenaのチャンクから順に切り
+ * 出され、個別には解放されずにbignum_arena_clearでまとめて返却される。
+ * その間に作った値は、bignum_arena_endの後もbignum_arena_clearまでは使
+ * ったり解放したりできるが、その後に使ったり解放したりしてはならない。
+ * bignum_arena_endの後に通常の領域へ写してから返却するとよい。arenaは
+ * bignum_arena_clearかbignum_arena_delまで動かしてはならない。
+ *
+ * bignum_thread_arenaはライブラリが演算の途中の値に使うスレッドごとの
+ * arenaで、チャンクはスレッドの終了時かdgtvec_flush_cacheで解放され
+ * る。終了時の解放を登録できないスレッドではNULLを返す。ライブラリが
+ * これを使うのは桁数の少ないbigratの演算だけである。bignat、bigintの
+ * 除算、gcd、文字列との変換などは1回の呼び出しで何度も確保することが
+ * あり、それを避けたい場合は呼び出し側でarenaを使う。
+ */
+typedef struct bignum_arena {
+	struct bignum_arena_chunk *chunk;
+	bignum_allocator prev;
+	bignum_allocator saved;
+	bool active;
+	struct bignum_arena *next;
+} bignum_arena;
+
+bignum_arena bignum_arena_new_empty(void);
+void bignum_arena_del(bignum_arena arena);
+void bignum_arena_begin(bignum_arena *arena);
+void bignum_arena_end(bignum_arena *arena);
+void bignum_arena_clear(bignum_arena *arena);
+bignum_arena *bignum_thread_arena(void);
+
 /* dgtvec */
 
 /*
  * uint32_t型の値を要素する可変長配列。
+ *
+ * 容量の小さい領域は解放せずにスレッドごとに取っておき、次の確保で再利
+ * 用する。取っておいた領域はスレッドの終了時に解放される。
+ * dgtvec_flush_cacheで先に解放することもできる。
  */
 typedef struct dgtvec {
 	uint32_t *digits;
@@ -19,9 +87,12 @@ typedef struct dgtvec {
 int dgtvec_init(dgtvec *v, uint32_t *digits, size_t ndigits);
 dgtvec dgtvec_new_empty(void);
 void dgtvec_del(dgtvec v);
+void dgtvec_flush_cache(void);
 void dgtvec_dump(dgtvec v);
 int dgtvec_push(dgtvec *v, uint32_t n);
 uint32_t dgtvec_pop(dgtvec *v);
+int dgtvec_reserve(dgtvec *v, size_t cap);
+int dgtvec_resize(dgtvec *v, size_t ndigits);
 
 /* bignat */
 
@@ -40,6 +111,15 @@ int bignat_init(bignat *nat, uint32_t *digits, size_t ndigits);
 bignat bignat_new_zero(void);
 int bignat_from_digit(bignat *nat, uint32_t n);
 int bignat_copy(bignat *dst, bignat src);
+int bignat_reserve(bignat *nat, size_t ndigits);
+int bignat_from_str(bignat *nat, const char *str, int base);
+int bignat_from_strn(bignat *nat, const char *str, size_t len, int base);
+size_t bignat_str_size(bignat x, int base);
+int bignat_to_str(char *str, size_t size, bignat x, int base);
+size_t bignat_export_size(bignat x);
+int bignat_export(void *buf, size_t size, bignat x);
+int bignat_import(bignat *nat, size_t *len, const void *buf, size_t size);
+int bignat_import_view(bignat *nat, size_t *len, void *buf, size_t size);
 void bignat_del(bignat n);
 
 int bignat_cmp(bignat x, bignat y);
@@ -51,11 +131,96 @@ bool bignat_le(bignat x, bignat y);
 bool bignat_ge(bignat x, bignat y);
 
 int bignat_add(bignat *sum, bignat x, bignat y);
+int bignat_add_digit(bignat *sum, bignat x, uint32_t y);
 int bignat_sub(bignat *diff, bignat x, bignat y);
+int bignat_sub_digit(bignat *diff, bignat x, uint32_t y);
 int bignat_mul(bignat *prod, bignat x, bignat y);
+int bignat_mul_digit(bignat *prod, bignat x, uint32_t y);
+int bignat_sqr(bignat *sq, bignat x);
 int bignat_divmod(bignat *quot, bignat *rem, bignat x, bignat y);
+int bignat_divmod_digit(bignat *quot, uint32_t *rem, bignat x, uint32_t y);
+int bignat_invert(bignat *inv, bignat x);
+
+/*
+ * 結果を書き込むbignatの既存の領域を再利用し、足りない場合だけ再確保す
+ * る版。書き込み先は初期化済みでビューでないbignatでなければならず、入
+ * 力と同じでもよいが、入力と一部だけ重なっていてはならない。
+ * bignat_reserveで容量を確保しておけば、繰り返し使っても確保と解放は
+ * 起きない(作業領域を要する乗算と除算を除く)。bignat_divmod_intoの商
+ * と剰余の書き込み先は別のbignatでなければならない。
+ *
+ * 失敗した場合、書き込み先の値は変わらないか0になる。書き込み先が入力
+ * と同じ場合は変わらない。
+ *
+ * *_inplaceは書き込み先を第1入力とする略記で、*acc += x などを計算す
+ * る。
+ */
+int bignat_add_into(bignat *sum, bignat x, bignat y);
+int bignat_add_digit_into(bignat *sum, bignat x, uint32_t y);
+int bignat_sub_into(bignat *diff, bignat x, bignat y);
+int bignat_sub_digit_into(bignat *diff, bignat x, uint32_t y);
+int bignat_mul_into(bignat *prod, bignat x, bignat y);
+int bignat_mul_digit_into(bignat *prod, bignat x, uint32_t y);
+int bignat_sqr_into(bignat *sq, bignat x);
+int bignat_divmod_into(bignat *quot, bignat *rem, bignat x, bignat y);
+int bignat_divmod_digit_into(bignat *quot, uint32_t *rem, bignat x,
+			     uint32_t y);
+int bignat_add_inplace(bignat *acc, bignat x);
+int bignat_add_digit_inplace(bignat *acc, uint32_t x);
+int bignat_sub_inplace(bignat *acc, bignat x);
+int bignat_sub_digit_inplace(bignat *acc, uint32_t x);
+int bignat_mul_inplace(bignat *acc, bignat x);
+int bignat_mul_digit_inplace(bignat *acc, uint32_t x);
 
 int bignat_gcd(bignat *gcd, bignat x, bignat y);
+int bignat_gcdext(bignat *gcd, bignat *s, bignat x, bignat y);
+int bignat_powm(bignat *powm, bignat base, bignat exp, bignat mod);
+int bignat_powm_sec(bignat *powm, bignat base, bignat exp, bignat mod);
+
+/*
+ * 奇数の法modに対するMontgomery乗算の文脈。nをmodの桁数、R = 2^(32n)
+ * として、法未満の値xを x R mod mod で表す。法ごとの前計算 -mod^-1 mod
+ * 2^32 と R^2 mod mod、作業領域を保持する。
+ *
+ * bignat_mont_to、bignat_mont_from、bignat_mont_mul、bignat_mont_sqrは、
+ * 他の関数と異なり、結果を書き込むbignatの既存の領域を再利用し、足りな
+ * い場合だけ再確保する。結果の書き込み先は初期化済みでビューでない
+ * bignatでなければならず、入力と同じでもよい。作業領域は文脈が持つの
+ * で、結果の領域が足りていればbignat_mont_mulとbignat_mont_sqrは法の
+ * 桁数によらず領域を確保しない。同じ文脈を複数のスレッドから同時に使っ
+ * てはならない。
+ */
+typedef struct bignat_mont_ctx {
+	bignat mod;
+	bignat r2;
+	uint32_t minv;
+	uint32_t *scratch;
+} bignat_mont_ctx;
+
+int bignat_mont_init(bignat_mont_ctx *ctx, bignat mod);
+void bignat_mont_del(bignat_mont_ctx ctx);
+int bignat_mont_to(bignat *mont, bignat x, bignat_mont_ctx *ctx);
+int bignat_mont_from(bignat *x, bignat mont, bignat_mont_ctx *ctx);
+int bignat_mont_mul(bignat *prod, bignat x, bignat y, bignat_mont_ctx *ctx);
+int bignat_mont_sqr(bignat *sq, bignat x, bignat_mont_ctx *ctx);
+
+/*
+ * 法modに対するBarrett法の文脈。法を正規化した値 d = mod 2^c とその逆
+ * 数 floor(2^(64n) / d) (nはmodの桁数)を前計算して保持し、剰余を積2回
+ * で求める。modは奇数でも偶数でもよい。
+ *
+ * bignat_barrett_reduceはbignat_mont_mulと同じく結果の領域を再利用す
+ * る。積の作業領域も文脈が持つので、結果の領域が足りていれば領域を確保
+ * しない。
+ */
+typedef struct bignat_barrett_ctx {
+	bignat mod;
+	uint32_t *scratch;
+} bignat_barrett_ctx;
+
+int bignat_barrett_init(bignat_barrett_ctx *ctx, bignat mod);
+void bignat_barrett_del(bignat_barrett_ctx ctx);
+int bignat_barrett_reduce(bignat *rem, bignat x, bignat_barrett_ctx *ctx);
 
 /* bigint */
 
@@ -76,6 +241,14 @@ int bigint_init(bigint *int_, int sign, uint32_t *digits, size_t ndigits);
 bigint bigint_new_zero(void);
 int bigint_from_digit(bigint *int_, int32_t x);
 int bigint_copy(bigint *dst, bigint src);
+int bigint_from_str(bigint *int_, const char *str, int base);
+int bigint_from_strn(bigint *int_, const char *str, size_t len, int base);
+size_t bigint_str_size(bigint x, int base);
+int bigint_to_str(char *str, size_t size, bigint x, int base);
+size_t bigint_export_size(bigint x);
+int bigint_export(void *buf, size_t size, bigint x);
+int bigint_import(bigint *int_, size_t *len, const void *buf, size_t size);
+int bigint_import_view(bigint *int_, size_t *len, void *buf, size_t size);
 void bigint_del(bigint int_);
 
 int bigint_cmp(bigint x, bigint y);
@@ -87,11 +260,31 @@ bool bigint_le(bigint x, bigint y);
 bool bigint_ge(bigint x, bigint y);
 
 int bigint_add(bigint *sum, bigint x, bigint y);
+int bigint_add_digit(bigint *sum, bigint x, int32_t y);
 int bigint_sub(bigint *diff, bigint x, bigint y);
+int bigint_sub_digit(bigint *diff, bigint x, int32_t y);
 int bigint_mul(bigint *prod, bigint x, bigint y);
+int bigint_mul_digit(bigint *prod, bigint x, int32_t y);
+int bigint_sqr(bigint *sq, bigint x);
 int bigint_divtrn(bigint *quot, bigint *rem, bigint x, bigint y);
+int bigint_divtrn_digit(bigint *quot, int32_t *rem, bigint x, int32_t y);
 int bigint_divflr(bigint *quot, bigint *rem, bigint x, bigint y);
 int bigint_diveuc(bigint *quot, bigint *rem, bigint x, bigint y);
+int bigint_gcdext(bigint *gcd, bigint *s, bigint *t, bigint x, bigint y);
+int bigint_invmod(bigint *inv, bigint x, bigint m);
+int bigint_powm(bigint *powm, bigint base, bigint exp, bigint mod);
+
+/*
+ * bignat_add_intoなどと同じく、結果を書き込むbigintの既存の領域を再利
+ * 用する版。
+ */
+int bigint_add_into(bigint *sum, bigint x, bigint y);
+int bigint_sub_into(bigint *diff, bigint x, bigint y);
+int bigint_mul_into(bigint *prod, bigint x, bigint y);
+int bigint_divtrn_into(bigint *quot, bigint *rem, bigint x, bigint y);
+int bigint_add_inplace(bigint *acc, bigint x);
+int bigint_sub_inplace(bigint *acc, bigint x);
+int bigint_mul_inplace(bigint *acc, bigint x);
 
 /* bigrat */
 
@@ -115,6 +308,13 @@ int bigrat_init(bigrat *rat,
 		int deno_sign, uint32_t *deno_digits, size_t deno_ndigits);
 int bigrat_from_digit(bigrat *rat, int32_t nume, int32_t deno);
 int bigrat_copy(bigrat *dst, bigrat src);
+int bigrat_from_str(bigrat *rat, const char *str, int base);
+size_t bigrat_str_size(bigrat x, int base);
+int bigrat_to_str(char *str, size_t size, bigrat x, int base);
+size_t bigrat_export_size(bigrat x);
+int bigrat_export(void *buf, size_t size, bigrat x);
+int bigrat_import(bigrat *rat, size_t *len, const void *buf, size_t size);
+int bigrat_import_view(bigrat *rat, size_t *len, void *buf, size_t size);
 void bigrat_del(bigrat rat);
 
 int bigrat_cmp(int *cmp, bigrat x, bigrat y);
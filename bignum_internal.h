@@ -0,0 +1,17 @@
+#ifndef BIGNUM_INTERNAL_H
+#define BIGNUM_INTERNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bignum.h"
+
+/*
+ * ライブラリの翻訳単位の間で共有する関数。bignum.hの利用者には公開しな
+ * い。
+ */
+
+int bignat_import_record(bignat *nat, int *sign, size_t *len, const void *buf,
+			 size_t size, bool view);
+
+#endif
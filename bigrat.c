@@ -1,8 +1,18 @@
 #include <errno.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "bignum.h"
 
+/*
+ * 途中の値をスレッドごとのarenaに置くのは、すべての成分の桁数がこれ未
+ * 満の場合に限る。大きい値では確保の手間は演算に比べて小さく、arenaの
+ * チャンクが大きく育ってスレッドに残ってしまう。
+ */
+#ifndef BIGRAT_ARENA_THRESHOLD
+#define BIGRAT_ARENA_THRESHOLD 64
+#endif
+
 int
 bigrat_norm(bigrat *rat)
 {
@@ -153,6 +163,199 @@ bigrat_copy(bigrat *dst, bigrat src)
 	return 0;
 }
 
+/*
+ * "分子/分母" か "分子" の形の文字列を読む。分子はbigint_from_strと、分
+ * 母は符号を付けられない点を除いて同じ形式である。分母が0の場合は
+ * EINVALを返す。結果は正規化される。
+ */
+int
+bigrat_from_str(bigrat *rat, const char *str, int base)
+{
+	const char *slash = strchr(str, '/');
+	size_t len = slash != NULL ? (size_t)(slash - str) : strlen(str);
+
+	int err;
+	bigint nume;
+	err = bigint_from_strn(&nume, str, len, base);
+	if (err != 0) {
+		return err;
+	}
+
+	bigint deno;
+	if (slash == NULL) {
+		err = bigint_from_digit(&deno, 1);
+	} else {
+		bignat abs;
+		err = bignat_from_str(&abs, slash + 1, base);
+		if (err == 0 && abs.ndigits == 0) {
+			bignat_del(abs);
+			err = EINVAL;
+		}
+		if (err == 0) {
+			deno = (bigint){
+				.sign=1,
+				.abs=abs
+			};
+		}
+	}
+	if (err != 0) {
+		bigint_del(nume);
+		return err;
+	}
+
+	bigrat tmp_rat = (bigrat){
+		.nume=nume,
+		.deno=deno
+	};
+	err = bigrat_norm(&tmp_rat);
+	if (err != 0) {
+		bigrat_del(tmp_rat);
+		return err;
+	}
+
+	*rat = tmp_rat;
+	return 0;
+}
+
+size_t
+bigrat_str_size(bigrat x, int base)
+{
+	size_t nume_size = bigint_str_size(x.nume, base);
+
+	if (nume_size == 0) {
+		return 0;
+	}
+
+	/* 分子の終端の分を'/'に使う */
+	return nume_size + bigint_str_size(x.deno, base);
+}
+
+/*
+ * xを "分子/分母" の形の文字列としてstrに書き込む。分母が1の場合も省略
+ * しない。その他はbigint_to_strと同じ。
+ */
+int
+bigrat_to_str(char *str, size_t size, bigrat x, int base)
+{
+	if (base < 2 || base > 36) {
+		return EINVAL;
+	}
+
+	if (size < bigrat_str_size(x, base)) {
+		return ERANGE;
+	}
+
+	int err;
+	size_t len;
+	err = bigint_to_str(str, size, x.nume, base);
+	if (err != 0) {
+		return err;
+	}
+
+	len = strlen(str);
+	str[len] = '/';
+	return bigint_to_str(str + len + 1, size - len - 1, x.deno, base);
+}
+
+size_t
+bigrat_export_size(bigrat x)
+{
+	return bigint_export_size(x.nume) + bignat_export_size(x.deno.abs);
+}
+
+/* 分子をbigintの記録として、分母をbignatの記録として続けて書き込む。 */
+int
+bigrat_export(void *buf, size_t size, bigrat x)
+{
+	if (size < bigrat_export_size(x)) {
+		return ERANGE;
+	}
+
+	size_t len = bigint_export_size(x.nume);
+	int err = bigint_export(buf, len, x.nume);
+	if (err != 0) {
+		return err;
+	}
+
+	return bignat_export((uint8_t *)buf + len, size - len, x.deno.abs);
+}
+
+/*
+ * 分子と分母の記録を読む。分母が0の場合はEINVALを返す。既約であるかは
+ * 確かめないので、bigrat_exportで書き込んだものでなければ正規化されて
+ * いるとは限らない。
+ */
+int
+bigrat_import(bigrat *rat, size_t *len, const void *buf, size_t size)
+{
+	int err;
+	size_t nume_len, deno_len;
+	bigint nume;
+	err = bigint_import(&nume, &nume_len, buf, size);
+	if (err != 0) {
+		return err;
+	}
+
+	bignat deno;
+	err = bignat_import(&deno, &deno_len,
+			    (const uint8_t *)buf + nume_len, size - nume_len);
+	if (err == 0 && deno.ndigits == 0) {
+		bignat_del(deno);
+		err = EINVAL;
+	}
+	if (err != 0) {
+		bigint_del(nume);
+		return err;
+	}
+
+	*rat = (bigrat){
+		.nume=nume,
+		.deno=(bigint){
+			.sign=1,
+			.abs=deno
+		}
+	};
+	*len = nume_len + deno_len;
+	return 0;
+}
+
+/*
+ * bigrat_importと同じだが、分子と分母はbuf内を指すビューになる。
+ * bigint_import_viewと同じ条件を満たす必要がある。結果はbigrat_delに
+ * 渡してはならない。
+ */
+int
+bigrat_import_view(bigrat *rat, size_t *len, void *buf, size_t size)
+{
+	int err;
+	size_t nume_len, deno_len;
+	bigint nume;
+	err = bigint_import_view(&nume, &nume_len, buf, size);
+	if (err != 0) {
+		return err;
+	}
+
+	bignat deno;
+	err = bignat_import_view(&deno, &deno_len, (uint8_t *)buf + nume_len,
+				 size - nume_len);
+	if (err != 0) {
+		return err;
+	}
+	if (deno.ndigits == 0) {
+		return EINVAL;
+	}
+
+	*rat = (bigrat){
+		.nume=nume,
+		.deno=(bigint){
+			.sign=1,
+			.abs=deno
+		}
+	};
+	*len = nume_len + deno_len;
+	return 0;
+}
+
 void
 bigrat_del(bigrat rat)
 {
@@ -160,6 +363,50 @@ bigrat_del(bigrat rat)
 	bigint_del(rat.deno);
 }
 
+static bool
+bigrat_is_small(bigrat x)
+{
+	return x.nume.abs.ndigits < BIGRAT_ARENA_THRESHOLD &&
+	       x.deno.abs.ndigits < BIGRAT_ARENA_THRESHOLD;
+}
+
+/*
+ * x, yの演算の途中の値をスレッドごとのarenaに置けるなら、arenaを使い始
+ * めて真を返す。既にarenaを使っている間や、値が大きい場合は偽を返す。
+ */
+static bool
+bigrat_arena_enter(bigrat x, bigrat y)
+{
+	bignum_arena *arena = bignum_thread_arena();
+
+	if (arena == NULL || arena->active || !bigrat_is_small(x) ||
+	    !bigrat_is_small(y)) {
+		return false;
+	}
+
+	bignum_arena_begin(arena);
+	return true;
+}
+
+/*
+ * bigrat_arena_enterで使い始めたarenaを閉じて返却する。resultがNULLで
+ * なければ、arenaに置いた*resultを返却する前に通常の領域の*outに写す。
+ */
+static int
+bigrat_arena_leave(bigrat *out, const bigrat *result)
+{
+	bignum_arena *arena = bignum_thread_arena();
+	int err = 0;
+
+	bignum_arena_end(arena);
+	if (result != NULL) {
+		err = bigrat_copy(out, *result);
+	}
+
+	bignum_arena_clear(arena);
+	return err;
+}
+
 int
 bigrat_cmp(int *cmp, bigrat x, bigrat y)
 {
@@ -169,24 +416,29 @@ bigrat_cmp(int *cmp, bigrat x, bigrat y)
 	}
 
 	int err;
-	bigint norm_x;
+	bool use_arena = bigrat_arena_enter(x, y);
+	bigint norm_x = bigint_new_zero();
+	bigint norm_y = bigint_new_zero();
+
 	err = bigint_mul(&norm_x, x.nume, y.deno);
 	if (err != 0) {
-		return err;
+		goto out;
 	}
 
-	bigint norm_y;
 	err = bigint_mul(&norm_y, y.nume, x.deno);
 	if (err != 0) {
-		bigint_del(norm_x);
-		return err;
+		goto out;
 	}
 
-	int tmp_cmp = bigint_cmp(norm_x, norm_y);
+	*cmp = bigint_cmp(norm_x, norm_y);
+	err = 0;
+out:
 	bigint_del(norm_x);
 	bigint_del(norm_y);
-	*cmp = tmp_cmp;
-	return 0;
+	if (use_arena) {
+		(void)bigrat_arena_leave(NULL, NULL);
+	}
+	return err;
 }
 
 int
@@ -273,8 +525,28 @@ bigrat_ge(bool *ge, bigrat x, bigrat y)
 	return 0;
 }
 
-int
-bigrat_add(bigrat *sum, bigrat x, bigrat y)
+/*
+ * 値が小さければ途中の値をスレッドごとのarenaに置いてopを呼び、結果だ
+ * けを通常の領域に写す。途中の値の確保と解放がチャンクからの切り出しだ
+ * けで済む。
+ */
+static int
+bigrat_with_arena(bigrat *out, bigrat x, bigrat y,
+		  int (*op)(bigrat *, bigrat, bigrat))
+{
+	if (!bigrat_arena_enter(x, y)) {
+		return op(out, x, y);
+	}
+
+	bigrat tmp_out;
+	int err = op(&tmp_out, x, y);
+	int leave_err = bigrat_arena_leave(out, err == 0 ? &tmp_out : NULL);
+
+	return err != 0 ? err : leave_err;
+}
+
+static int
+bigrat_do_add(bigrat *sum, bigrat x, bigrat y)
 {
 	if (bigint_eq(x.deno, y.deno)) {
 		int err;
@@ -357,6 +629,12 @@ fail:
 	return err;
 }
 
+int
+bigrat_add(bigrat *sum, bigrat x, bigrat y)
+{
+	return bigrat_with_arena(sum, x, y, bigrat_do_add);
+}
+
 int
 bigrat_sub(bigrat *diff, bigrat x, bigrat y)
 {
@@ -364,8 +642,8 @@ bigrat_sub(bigrat *diff, bigrat x, bigrat y)
 	return bigrat_add(diff, x, y);
 }
 
-int
-bigrat_mul(bigrat *prod, bigrat x, bigrat y)
+static int
+bigrat_do_mul(bigrat *prod, bigrat x, bigrat y)
 {
 	int err;
 	bigint nume_prod = bigint_new_zero();
@@ -400,6 +678,12 @@ fail:
 	return err;
 }
 
+int
+bigrat_mul(bigrat *prod, bigrat x, bigrat y)
+{
+	return bigrat_with_arena(prod, x, y, bigrat_do_mul);
+}
+
 int
 bigrat_div(bigrat *quot, bigrat x, bigrat y)
 {
@@ -1,14 +1,445 @@
-/* for reallocarray */
-#define _DEFAULT_SOURCE
-
 #include <errno.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <threads.h>
 
 #include "bignum.h"
 
+/*
+ * 1桁や2桁の値は頻繁に作られては捨てられるので、容量が
+ * DGTVEC_SMALL_CAP 以下の領域は解放せずに容量ごとに
+ * DGTVEC_CACHE_SIZE 個までスレッドごとに取っておき、次の確保で再利用す
+ * る。0を指定すると取っておかない。
+ */
+#ifndef DGTVEC_SMALL_CAP
+#define DGTVEC_SMALL_CAP 2
+#endif
+
+#ifndef DGTVEC_CACHE_SIZE
+#define DGTVEC_CACHE_SIZE 64
+#endif
+
+#if DGTVEC_SMALL_CAP > 0 && DGTVEC_CACHE_SIZE > 0
+static _Thread_local struct {
+	size_t n;
+	uint32_t *p[DGTVEC_CACHE_SIZE];
+} small_cache[DGTVEC_SMALL_CAP];
+
+/* small_cacheの領域を確保した関数の組。 */
+static _Thread_local bignum_allocator small_cache_allocator;
+#endif
+
+/*
+ * スレッドが終了するときに、そのスレッドが取っておいた領域と
+ * bignum_thread_arenaのチャンクをdgtvec_flush_cacheで解放する。デスト
+ * ラクタは値を設定したスレッドでだけ呼ばれるので、どちらも使う前に
+ * thread_cleanup_registerで登録する。登録できないスレッドでは使わない。
+ */
+static tss_t thread_cleanup_key;
+static bool thread_cleanup_key_ok;
+static once_flag thread_cleanup_once = ONCE_FLAG_INIT;
+static _Thread_local bool thread_cleanup_registered;
+
+static void
+thread_cleanup(void *p)
+{
+	(void)p;
+	/* 他のデストラクタがまた取っておいた場合は、登録し直させる */
+	thread_cleanup_registered = false;
+	dgtvec_flush_cache();
+}
+
+static void
+thread_cleanup_init(void)
+{
+	thread_cleanup_key_ok =
+		tss_create(&thread_cleanup_key, thread_cleanup) == thrd_success;
+}
+
+static bool
+thread_cleanup_register(void)
+{
+	if (thread_cleanup_registered) {
+		return true;
+	}
+
+	call_once(&thread_cleanup_once, thread_cleanup_init);
+	if (!thread_cleanup_key_ok ||
+	    tss_set(thread_cleanup_key, &thread_cleanup_registered) !=
+	    thrd_success) {
+		return false;
+	}
+
+	thread_cleanup_registered = true;
+	return true;
+}
+
+static void *
+default_alloc(void *ctx, size_t size)
+{
+	(void)ctx;
+	return malloc(size);
+}
+
+static void *
+default_realloc(void *ctx, void *p, size_t old_size, size_t new_size)
+{
+	(void)ctx;
+	(void)old_size;
+	return realloc(p, new_size);
+}
+
+static void
+default_free(void *ctx, void *p, size_t size)
+{
+	(void)ctx;
+	(void)size;
+	free(p);
+}
+
+static bignum_allocator global_allocator = {
+	.alloc=default_alloc,
+	.realloc=default_realloc,
+	.free=default_free,
+	.ctx=NULL
+};
+
+/* allocがNULLであれば、global_allocatorに従う。 */
+static _Thread_local bignum_allocator thread_allocator;
+
+static const bignum_allocator *
+current_allocator(void)
+{
+	return thread_allocator.alloc != NULL
+		? &thread_allocator
+		: &global_allocator;
+}
+
+/*
+ * 以降の確保と解放に使う関数の組を設定する。NULLを指定すると既定の
+ * malloc、realloc、freeに戻す。呼び出したスレッドが取っておいた領域は
+ * 先に解放する。他のスレッドが取っておいた領域は、そのスレッドが次に
+ * 確保か解放をするときに元の関数の組で解放される。他のスレッドが
+ * bignumを使っていない間に呼ぶ。
+ */
+void
+bignum_set_allocator(const bignum_allocator *alloc)
+{
+	dgtvec_flush_cache();
+	global_allocator = alloc != NULL
+		? *alloc
+		: (bignum_allocator){
+			.alloc=default_alloc,
+			.realloc=default_realloc,
+			.free=default_free,
+			.ctx=NULL
+		};
+}
+
+/*
+ * 呼び出したスレッドでだけ使う関数の組を設定する。NULLを指定すると
+ * bignum_set_allocatorの設定に従う。
+ */
+void
+bignum_set_thread_allocator(const bignum_allocator *alloc)
+{
+	dgtvec_flush_cache();
+	thread_allocator = alloc != NULL ? *alloc : (bignum_allocator){0};
+}
+
+/* 呼び出したスレッドで使われる関数の組を得る。 */
+void
+bignum_get_allocator(bignum_allocator *alloc)
+{
+	*alloc = *current_allocator();
+}
+
+/*
+ * arenaの領域は、前の関数の組で確保したチャンクから先頭から順に切り出
+ * す。チャンクが足りなくなると、より大きいチャンクを確保して連結する。
+ */
+struct bignum_arena_chunk {
+	struct bignum_arena_chunk *next;
+	size_t size;
+	size_t used;
+	max_align_t data[];
+};
+
+/* 最初に確保するチャンクのバイト数。 */
+#ifndef BIGNUM_ARENA_CHUNK_SIZE
+#define BIGNUM_ARENA_CHUNK_SIZE 4096
+#endif
+
+static _Thread_local bignum_arena thread_arena;
+
+/*
+ * bignum_arena_endの後でまだ返却していないarenaの並び。そこから切り出し
+ * た値の解放と再確保は、その間に使われている関数の組ではなく元のarena
+ * に任せる。
+ */
+static _Thread_local bignum_arena *ended_arenas;
+
+/* 切り上げで溢れた場合は0を返す。 */
+static size_t
+arena_align(size_t size)
+{
+	size_t a = sizeof(max_align_t);
+	return size > SIZE_MAX - (a - 1) ? 0 : (size + a - 1) / a * a;
+}
+
+static bool
+arena_owns(const bignum_arena *arena, const void *p)
+{
+	for (struct bignum_arena_chunk *c = arena->chunk; c != NULL;
+	     c = c->next) {
+		uintptr_t begin = (uintptr_t)c->data;
+		if ((uintptr_t)p >= begin && (uintptr_t)p < begin + c->size) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void *
+arena_alloc(void *ctx, size_t size)
+{
+	bignum_arena *arena = ctx;
+	struct bignum_arena_chunk *c = arena->chunk;
+	size_t n = arena_align(size + !size);
+
+	if (n == 0) {
+		return NULL;
+	}
+
+	if (c == NULL || c->size - c->used < n) {
+		size_t csize = BIGNUM_ARENA_CHUNK_SIZE;
+
+		if (c != NULL && c->size > csize / 2 &&
+		    c->size <= SIZE_MAX / 2) {
+			csize = 2 * c->size;
+		}
+		csize = csize > n ? csize : n;
+		if (csize > SIZE_MAX - sizeof(*c)) {
+			return NULL;
+		}
+
+		c = arena->prev.alloc(arena->prev.ctx, sizeof(*c) + csize);
+		if (c == NULL) {
+			return NULL;
+		}
+
+		c->next = arena->chunk;
+		c->size = csize;
+		c->used = 0;
+		arena->chunk = c;
+	}
+
+	void *p = (unsigned char *)c->data + c->used;
+	c->used += n;
+	return p;
+}
+
+/* 最後に切り出した領域であれば返却し、その他のarenaの領域は何もしない。 */
+static void
+arena_free(void *ctx, void *p, size_t size)
+{
+	bignum_arena *arena = ctx;
+	struct bignum_arena_chunk *c = arena->chunk;
+
+	if (!arena_owns(arena, p)) {
+		arena->prev.free(arena->prev.ctx, p, size);
+		return;
+	}
+
+	size_t n = arena_align(size + !size);
+	if ((unsigned char *)p + n == (unsigned char *)c->data + c->used) {
+		c->used -= n;
+	}
+}
+
+static void *
+arena_realloc(void *ctx, void *p, size_t old_size, size_t new_size)
+{
+	bignum_arena *arena = ctx;
+	struct bignum_arena_chunk *c = arena->chunk;
+
+	if (!arena_owns(arena, p)) {
+		return arena->prev.realloc(arena->prev.ctx, p, old_size,
+					   new_size);
+	}
+
+	/* 最後に切り出した領域は、その場で広げられればそうする */
+	uintptr_t begin = (uintptr_t)c->data;
+	size_t n = arena_align(new_size);
+	if ((uintptr_t)p >= begin && (uintptr_t)p < begin + c->size) {
+		size_t off = (uintptr_t)p - begin;
+
+		if (off + arena_align(old_size + !old_size) == c->used &&
+		    n != 0 && c->size - off >= n) {
+			c->used = off + n;
+			return p;
+		}
+	}
+
+	void *q = arena_alloc(arena, new_size);
+	if (q == NULL) {
+		return NULL;
+	}
+
+	memcpy(q, p, old_size < new_size ? old_size : new_size);
+	return q;
+}
+
+/* 呼び出したスレッドでarenaを使っている間は真。 */
+static bool
+arena_active(void)
+{
+	return thread_allocator.alloc == arena_alloc;
+}
+
+/* チャンクがchunkから始まるarenaをended_arenasから外す。 */
+static void
+arena_unlink_ended(const struct bignum_arena_chunk *chunk)
+{
+	for (bignum_arena **a = &ended_arenas; *a != NULL; a = &(*a)->next) {
+		if ((*a)->chunk == chunk) {
+			*a = (*a)->next;
+			return;
+		}
+	}
+}
+
+/* pを切り出した、ended_arenasにあるarenaを探す。なければNULLを返す。 */
+static bignum_arena *
+arena_find_ended(const void *p)
+{
+	for (bignum_arena *a = ended_arenas; a != NULL; a = a->next) {
+		if (arena_owns(a, p)) {
+			return a;
+		}
+	}
+
+	return NULL;
+}
+
+bignum_arena
+bignum_arena_new_empty(void)
+{
+	return (bignum_arena){
+		.chunk=NULL,
+		.active=false,
+		.next=NULL
+	};
+}
+
+/* arenaのチャンクをすべて解放する。arenaは使用中であってはならない。 */
+void
+bignum_arena_del(bignum_arena arena)
+{
+	struct bignum_arena_chunk *c = arena.chunk;
+
+	if (c != NULL) {
+		arena_unlink_ended(c);
+	}
+
+	while (c != NULL) {
+		struct bignum_arena_chunk *next = c->next;
+		arena.prev.free(arena.prev.ctx, c, sizeof(*c) + c->size);
+		c = next;
+	}
+}
+
+/*
+ * 呼び出したスレッドでの以降の確保をarenaから切り出す。arenaの外で確
+ * 保した領域の再確保と解放は、元の関数の組に任せる。
+ */
+void
+bignum_arena_begin(bignum_arena *arena)
+{
+	bignum_allocator prev = *current_allocator();
+
+	if (arena->chunk != NULL) {
+		arena_unlink_ended(arena->chunk);
+	}
+
+	if (arena->chunk != NULL &&
+	    (prev.alloc != arena->prev.alloc || prev.ctx != arena->prev.ctx)) {
+		/* チャンクは確保したときの関数の組で解放する */
+		bignum_arena_del(*arena);
+		arena->chunk = NULL;
+	}
+
+	arena->prev = prev;
+	arena->saved = thread_allocator;
+	arena->active = true;
+	thread_allocator = (bignum_allocator){
+		.alloc=arena_alloc,
+		.realloc=arena_realloc,
+		.free=arena_free,
+		.ctx=arena
+	};
+}
+
+/*
+ * bignum_arena_beginの前の関数の組に戻す。arenaから切り出した領域は
+ * bignum_arena_clearを呼ぶまで使える。その間に解放したり広げたりした
+ * 領域はarenaに返す。
+ */
+void
+bignum_arena_end(bignum_arena *arena)
+{
+	thread_allocator = arena->saved;
+	arena->active = false;
+	if (arena->chunk != NULL) {
+		arena->next = ended_arenas;
+		ended_arenas = arena;
+	}
+}
+
+/*
+ * arenaから切り出した領域をまとめて返却する。最後に確保したチャンクだ
+ * けを次に使うために残す。ただし、チャンクを別のarenaから切り出してい
+ * た場合はすべて返却する。
+ */
+void
+bignum_arena_clear(bignum_arena *arena)
+{
+	struct bignum_arena_chunk *c = arena->chunk;
+
+	if (c == NULL) {
+		return;
+	}
+
+	arena_unlink_ended(c);
+	if (arena->prev.alloc == arena_alloc) {
+		bignum_arena_del(*arena);
+		arena->chunk = NULL;
+		return;
+	}
+
+	bignum_arena_del((bignum_arena){
+		.chunk=c->next,
+		.prev=arena->prev
+	});
+	c->next = NULL;
+	c->used = 0;
+}
+
+/*
+ * ライブラリが一時的な値に使う、スレッドごとのarenaを返す。スレッドの
+ * 終了時に解放するよう登録できなければNULLを返す。
+ */
+bignum_arena *
+bignum_thread_arena(void)
+{
+	return thread_cleanup_register() ? &thread_arena : NULL;
+}
+
 /* 切り上げで桁が溢れた場合は0を返す。 */
 static size_t
 roundup_pow2(size_t n)
@@ -21,6 +452,114 @@ roundup_pow2(size_t n)
 	return n;
 }
 
+#if DGTVEC_SMALL_CAP > 0 && DGTVEC_CACHE_SIZE > 0
+/* 取っておいた領域を、確保したときの関数の組ですべて解放する。 */
+static void
+small_cache_release(void)
+{
+	const bignum_allocator *a = &small_cache_allocator;
+
+	for (size_t i = 0; i < DGTVEC_SMALL_CAP; i++) {
+		while (small_cache[i].n > 0) {
+			a->free(a->ctx, small_cache[i].p[--small_cache[i].n],
+				(i + 1) * sizeof(uint32_t));
+		}
+	}
+}
+
+/*
+ * 取っておいた領域を関数の組aのものにそろえる。他のスレッドが
+ * bignum_set_allocatorで切り替えた後は、前の組の領域を先に解放する。
+ */
+static void
+small_cache_sync(const bignum_allocator *a)
+{
+	if (a->alloc != small_cache_allocator.alloc ||
+	    a->ctx != small_cache_allocator.ctx) {
+		small_cache_release();
+		small_cache_allocator = *a;
+	}
+}
+#endif
+
+/* 容量capの領域を確保する。cap > 0。 */
+static uint32_t *
+dgtvec_alloc(size_t cap)
+{
+#if DGTVEC_SMALL_CAP > 0 && DGTVEC_CACHE_SIZE > 0
+	/* arenaの値はまとめて返却するので、取っておいた領域を渡さない */
+	if (cap <= DGTVEC_SMALL_CAP && !arena_active()) {
+		small_cache_sync(current_allocator());
+		if (small_cache[cap - 1].n > 0) {
+			return small_cache[cap - 1].p[--small_cache[cap - 1].n];
+		}
+	}
+#endif
+
+	const bignum_allocator *a = current_allocator();
+
+	if (cap > SIZE_MAX / sizeof(uint32_t)) {
+		return NULL;
+	}
+
+	return a->alloc(a->ctx, cap * sizeof(uint32_t));
+}
+
+/* dgtvec_allocで確保した容量capの領域pを容量new_capに広げる。 */
+static uint32_t *
+dgtvec_realloc(uint32_t *p, size_t cap, size_t new_cap)
+{
+	const bignum_allocator *a = current_allocator();
+
+	if (p == NULL) {
+		return dgtvec_alloc(new_cap);
+	}
+
+	if (new_cap > SIZE_MAX / sizeof(uint32_t)) {
+		return NULL;
+	}
+
+	bignum_arena *arena = ended_arenas != NULL ? arena_find_ended(p) : NULL;
+	if (arena != NULL) {
+		return arena_realloc(arena, p, cap * sizeof(uint32_t),
+				     new_cap * sizeof(uint32_t));
+	}
+
+	return a->realloc(a->ctx, p, cap * sizeof(uint32_t),
+			  new_cap * sizeof(uint32_t));
+}
+
+/* dgtvec_allocで確保した容量capの領域pを解放する。 */
+static void
+dgtvec_free(uint32_t *p, size_t cap)
+{
+	/* 終了したarenaの領域は、取っておかずにarenaに返す */
+	if (ended_arenas != NULL && p != NULL) {
+		bignum_arena *arena = arena_find_ended(p);
+
+		if (arena != NULL) {
+			arena_free(arena, p, cap * sizeof(uint32_t));
+			return;
+		}
+	}
+
+#if DGTVEC_SMALL_CAP > 0 && DGTVEC_CACHE_SIZE > 0
+	if (cap > 0 && cap <= DGTVEC_SMALL_CAP && !arena_active() &&
+	    thread_cleanup_register()) {
+		small_cache_sync(current_allocator());
+		if (small_cache[cap - 1].n < DGTVEC_CACHE_SIZE) {
+			small_cache[cap - 1].p[small_cache[cap - 1].n++] = p;
+			return;
+		}
+	}
+#endif
+
+	if (p != NULL) {
+		const bignum_allocator *a = current_allocator();
+		a->free(a->ctx, p, cap * sizeof(uint32_t));
+	}
+}
+
 int
 dgtvec_init(dgtvec *v, uint32_t *digits, size_t ndigits)
 {
@@ -39,7 +578,7 @@ dgtvec_init(dgtvec *v, uint32_t *digits, size_t ndigits)
 		return ENOMEM;
 	}
 
-	tv.digits = reallocarray(NULL, tv.cap, sizeof(*tv.digits));
+	tv.digits = dgtvec_alloc(tv.cap);
 	if (tv.digits == NULL) {
 		return ENOMEM;
 	}
@@ -65,7 +604,22 @@ dgtvec_new_empty(void)
 void
 dgtvec_del(dgtvec v)
 {
-	free(v.digits);
+	dgtvec_free(v.digits, v.cap);
+}
+
+/*
+ * 呼び出したスレッドが取っておいた小さい領域と、bignum_thread_arenaの
+ * チャンクをすべて解放する。スレッドの終了時には自動で呼ばれる。
+ */
+void
+dgtvec_flush_cache(void)
+{
+	bignum_arena_del(thread_arena);
+	thread_arena = bignum_arena_new_empty();
+
+#if DGTVEC_SMALL_CAP > 0 && DGTVEC_CACHE_SIZE > 0
+	small_cache_release();
+#endif
 }
 
 void
@@ -99,7 +653,7 @@ dgtvec_push(dgtvec *v, uint32_t n)
 			return ENOMEM;
 		}
 
-		digits = reallocarray(v->digits, cap, sizeof(*v->digits));
+		digits = dgtvec_realloc(v->digits, v->cap, cap);
 		if (digits == NULL) {
 			return ENOMEM;
 		}
@@ -112,6 +666,53 @@ dgtvec_push(dgtvec *v, uint32_t n)
 	return 0;
 }
 
+/*
+ * 容量をcap以上にする。要素は変えない。容量が足りない場合のみ再確保す
+ * る。
+ */
+int
+dgtvec_reserve(dgtvec *v, size_t cap)
+{
+	if (cap > v->cap) {
+		size_t tcap;
+		void *digits;
+
+		tcap = roundup_pow2(cap);
+		if (tcap == 0) {
+			return ENOMEM;
+		}
+
+		digits = dgtvec_realloc(v->digits, v->cap, tcap);
+		if (digits == NULL) {
+			return ENOMEM;
+		}
+
+		v->digits = digits;
+		v->cap = tcap;
+	}
+
+	return 0;
+}
+
+/*
+ * 要素数をndigitsに変更する。増えた要素は0で埋める。容量が足りない場合
+ * のみ再確保する。
+ */
+int
+dgtvec_resize(dgtvec *v, size_t ndigits)
+{
+	int err = dgtvec_reserve(v, ndigits);
+	if (err != 0) {
+		return err;
+	}
+
+	for (size_t i = v->ndigits; i < ndigits; i++) {
+		v->digits[i] = 0;
+	}
+	v->ndigits = ndigits;
+	return 0;
+}
+
 uint32_t
 dgtvec_pop(dgtvec *v)
 {
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 
 #include "bignum.h"
 
@@ -150,6 +151,507 @@ test_dgtvec_pop(void)
 	dgtvec_del(v);
 }
 
+void
+test_dgtvec_resize(void)
+{
+	dgtvec v = dgtvec_new_empty();
+
+	test_assert(dgtvec_push(&v, 7) == 0);
+	test_assert(dgtvec_resize(&v, 5) == 0);
+	test_assert(v.ndigits == 5);
+	test_assert(v.cap >= 5);
+	test_assert(v.digits[0] == 7);
+	test_assert(v.digits[1] == 0);
+	test_assert(v.digits[4] == 0);
+	test_assert(dgtvec_resize(&v, 1) == 0);
+	test_assert(v.ndigits == 1);
+	test_assert(v.digits[0] == 7);
+	test_assert(dgtvec_resize(&v, 2) == 0);
+	test_assert(v.ndigits == 2);
+	test_assert(v.digits[1] == 0);
+
+	dgtvec_del(v);
+}
+
+void
+test_dgtvec_flush_cache(void)
+{
+	{
+		/* 取っておいた領域を再利用しても値は正しい */
+		dgtvec v, w;
+		test_assert(dgtvec_init(&v, (uint32_t[]){1}, 1) == 0);
+		dgtvec_del(v);
+
+		test_assert(dgtvec_init(&w, (uint32_t[]){2}, 1) == 0);
+		test_assert(w.digits[0] == 2);
+		test_assert(dgtvec_push(&w, 3) == 0);
+		test_assert(w.ndigits == 2);
+		test_assert(w.digits[0] == 2 && w.digits[1] == 3);
+		dgtvec_del(w);
+	}
+	{
+		dgtvec v = dgtvec_new_empty();
+		test_assert(dgtvec_resize(&v, 2) == 0);
+		test_assert(v.ndigits == 2);
+		test_assert(v.digits[0] == 0 && v.digits[1] == 0);
+		test_assert(dgtvec_resize(&v, 3) == 0);
+		test_assert(v.cap >= 3);
+		dgtvec_del(v);
+	}
+
+	dgtvec_flush_cache();
+	dgtvec_flush_cache();
+}
+
+struct alloc_stat {
+	size_t nallocs;
+	size_t live;
+	size_t nmismatches;
+};
+
+/* 大きさを領域の前に記録し、解放時に渡された大きさと照合する */
+static void *
+tracking_alloc(void *ctx, size_t size)
+{
+	struct alloc_stat *st = ctx;
+	size_t *p = malloc(sizeof(max_align_t) + size);
+	if (p == NULL) {
+		return NULL;
+	}
+
+	*p = size;
+	st->nallocs++;
+	st->live += size;
+	return (max_align_t *)p + 1;
+}
+
+static void *
+tracking_realloc(void *ctx, void *p, size_t old_size, size_t new_size)
+{
+	struct alloc_stat *st = ctx;
+	size_t *q = (size_t *)((max_align_t *)p - 1);
+	if (*q != old_size) {
+		st->nmismatches++;
+	}
+
+	q = realloc(q, sizeof(max_align_t) + new_size);
+	if (q == NULL) {
+		return NULL;
+	}
+
+	*q = new_size;
+	st->nallocs++;
+	st->live += new_size - old_size;
+	return (max_align_t *)q + 1;
+}
+
+static void
+tracking_free(void *ctx, void *p, size_t size)
+{
+	struct alloc_stat *st = ctx;
+	size_t *q = (size_t *)((max_align_t *)p - 1);
+	if (*q != size) {
+		st->nmismatches++;
+	}
+
+	st->live -= size;
+	free(q);
+}
+
+static int
+set_allocator_thread(void *arg)
+{
+	bignum_set_allocator(arg);
+	return 0;
+}
+
+/*
+ * 小さい値を作っては捨て、取っておいた領域とarenaのチャンクを残したま
+ * ま終了する
+ */
+static int
+small_values_thread(void *arg)
+{
+	(void)arg;
+	for (uint32_t i = 0; i < 100; i++) {
+		bignat x, y;
+		if (bignat_from_digit(&x, i) != 0) {
+			return 1;
+		}
+		if (bignat_mul_digit(&y, x, ~(uint32_t)0) != 0) {
+			bignat_del(x);
+			return 1;
+		}
+		bignat_del(x);
+		bignat_del(y);
+	}
+
+	/* bigratの演算はスレッドごとのarenaにチャンクを残す */
+	bigrat x, y, sum;
+	if (bigrat_from_digit(&x, 3, 7) != 0) {
+		return 1;
+	}
+	if (bigrat_from_digit(&y, -5, 11) != 0) {
+		bigrat_del(x);
+		return 1;
+	}
+	int err = bigrat_add(&sum, x, y);
+	bigrat_del(x);
+	bigrat_del(y);
+	if (err != 0) {
+		return 1;
+	}
+	bigrat_del(sum);
+	return bignum_thread_arena()->chunk != NULL ? 0 : 1;
+}
+
+void
+test_bignum_set_allocator(void)
+{
+	{
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		}, got;
+		size_t n = 3000;
+		uint32_t *ds = calloc(n, sizeof(uint32_t));
+		test_assert(ds != NULL);
+		for (size_t i = 0; i < n; i++) {
+			ds[i] = (uint32_t)(i * 2654435761u) | 1;
+		}
+
+		bignum_set_allocator(&a);
+		bignum_get_allocator(&got);
+		test_assert(got.alloc == tracking_alloc && got.ctx == &st);
+
+		bignat x, y, prod, quot, rem, gcd;
+		bigint i;
+		char *str;
+		test_assert(bignat_init(&x, ds, n) == 0);
+		test_assert(bignat_init(&y, ds, n / 3) == 0);
+		test_assert(bignat_mul(&prod, x, y) == 0);
+		test_assert(bignat_divmod(&quot, &rem, prod, y) == 0);
+		test_assert(bignat_eq(quot, x));
+		test_assert(rem.ndigits == 0);
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_mul_inplace(&x, x) == 0);
+		test_assert(bignat_add_digit_inplace(&x, 1) == 0);
+		test_assert(bigint_from_digit(&i, -7) == 0);
+		test_assert(bigint_mul_inplace(&i, i) == 0);
+
+		str = malloc(bignat_str_size(y, 10));
+		test_assert(str != NULL);
+		test_assert(bignat_to_str(str, bignat_str_size(y, 10),
+					  y, 10) == 0);
+		bignat_del(rem);
+		test_assert(bignat_from_str(&rem, str, 10) == 0);
+		test_assert(bignat_eq(rem, y));
+		free(str);
+
+		test_assert(st.nallocs > 0);
+		test_assert(st.live > 0);
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(prod);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(gcd);
+		bigint_del(i);
+		bignum_set_allocator(NULL);
+		free(ds);
+
+		test_assert(st.live == 0);
+		test_assert(st.nmismatches == 0);
+
+		bignum_get_allocator(&got);
+		test_assert(got.alloc != tracking_alloc && got.ctx == NULL);
+	}
+	{
+		/* スレッドごとの設定はbignum_set_allocatorより優先される */
+		struct alloc_stat st = {0}, tst = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		}, ta = a;
+		ta.ctx = &tst;
+
+		bignum_set_allocator(&a);
+		bignum_set_thread_allocator(&ta);
+
+		bignat x;
+		test_assert(bignat_from_digit(&x, 5) == 0);
+		test_assert(bignat_mul_digit_inplace(&x, ~(uint32_t)0) == 0);
+		test_assert(st.nallocs == 0);
+		test_assert(tst.nallocs > 0);
+		bignat_del(x);
+
+		bignum_set_thread_allocator(NULL);
+		test_assert(bignat_from_digit(&x, 5) == 0);
+		test_assert(st.nallocs > 0);
+		bignat_del(x);
+
+		bignum_set_allocator(NULL);
+		test_assert(st.live == 0 && tst.live == 0);
+		test_assert(st.nmismatches == 0 && tst.nmismatches == 0);
+	}
+	{
+		/*
+		 * 他のスレッドが関数の組を切り替えても、取っておいた領域は確
+		 * 保したときの組で解放される
+		 */
+		struct alloc_stat st = {0}, st2 = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		}, a2 = a;
+		a2.ctx = &st2;
+
+		bignum_set_allocator(&a);
+		bignat x, y;
+		test_assert(bignat_from_digit(&x, 5) == 0);
+		test_assert(bignat_from_digit(&y, 6) == 0);
+		bignat_del(x);
+		bignat_del(y);
+
+		thrd_t t;
+		test_assert(thrd_create(&t, set_allocator_thread, &a2) ==
+			    thrd_success);
+		test_assert(thrd_join(t, NULL) == thrd_success);
+
+		test_assert(bignat_from_digit(&x, 7) == 0);
+		test_assert(st.live == 0);
+		test_assert(st2.live > 0);
+		bignat_del(x);
+
+		bignum_set_allocator(NULL);
+		test_assert(st.live == 0 && st2.live == 0);
+		test_assert(st.nmismatches == 0 && st2.nmismatches == 0);
+	}
+	{
+		/*
+		 * 終了したスレッドが取っておいた領域とarenaのチャンクは自
+		 * 動で解放される
+		 */
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		};
+		bignum_set_allocator(&a);
+
+		thrd_t ts[4];
+		for (size_t i = 0; i < countof(ts); i++) {
+			test_assert(thrd_create(&ts[i], small_values_thread,
+						NULL) == thrd_success);
+		}
+		for (size_t i = 0; i < countof(ts); i++) {
+			int res;
+			test_assert(thrd_join(ts[i], &res) == thrd_success);
+			test_assert(res == 0);
+		}
+
+		test_assert(st.nallocs > 0);
+		test_assert(st.live == 0);
+		bignum_set_allocator(NULL);
+		test_assert(st.nmismatches == 0);
+	}
+}
+
+void
+test_bignum_arena(void)
+{
+	{
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		};
+		bignum_set_allocator(&a);
+
+		bignum_arena arena = bignum_arena_new_empty();
+		bignat acc, x, y, prod, sum, result;
+		uint32_t xds[] = {1, 2, 3, 4}, yds[] = {5, 6, 7};
+		test_assert(bignat_init(&acc, xds, countof(xds)) == 0);
+
+		bignum_arena_begin(&arena);
+		test_assert(arena.active);
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_mul(&prod, x, y) == 0);
+		test_assert(bignat_add(&sum, prod, x) == 0);
+		bignat_del(prod);
+
+		/* arenaの外で確保した値は元の関数の組で広げられる */
+		test_assert(bignat_mul_inplace(&acc, acc) == 0);
+		test_assert(bignat_mul_inplace(&acc, acc) == 0);
+		size_t nallocs = st.nallocs;
+		bignum_arena_end(&arena);
+		test_assert(!arena.active);
+
+		test_assert(bignat_copy(&result, sum) == 0);
+		test_assert(st.nallocs == nallocs + 1);
+		bignum_arena_clear(&arena);
+
+		/* 同じ値を通常の領域で求めて比べる */
+		bignat expected;
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_mul(&prod, x, y) == 0);
+		test_assert(bignat_add(&expected, prod, x) == 0);
+		test_assert(bignat_eq(result, expected));
+		bignat_del(expected);
+		test_assert(bignat_sqr(&expected, x) == 0);
+		test_assert(bignat_sqr_into(&expected, expected) == 0);
+		test_assert(bignat_eq(acc, expected));
+
+		bignat_del(expected);
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(prod);
+		bignat_del(acc);
+		bignat_del(result);
+
+		/* 再利用したチャンクから切り出せる */
+		bignum_arena_begin(&arena);
+		nallocs = st.nallocs;
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(st.nallocs == nallocs);
+		bignum_arena_end(&arena);
+		bignum_arena_clear(&arena);
+
+		bignum_arena_del(arena);
+		bignum_set_allocator(NULL);
+		test_assert(st.live == 0);
+		test_assert(st.nmismatches == 0);
+	}
+	{
+		/* bignum_arena_endの後に解放したり広げたりした値はarenaに返る */
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		};
+		bignum_set_allocator(&a);
+
+		bignum_arena arena = bignum_arena_new_empty();
+		bignat small, large, grown;
+		uint32_t ds[] = {1, 2, 3, 4, 5};
+		bignum_arena_begin(&arena);
+		test_assert(bignat_from_digit(&small, 7) == 0);
+		test_assert(bignat_init(&large, ds, countof(ds)) == 0);
+		test_assert(bignat_init(&grown, ds, 2) == 0);
+		bignum_arena_end(&arena);
+
+		bignat_del(small);
+		bignat_del(large);
+		test_assert(bignat_mul_digit_inplace(&grown, ~(uint32_t)0) ==
+			    0);
+		test_assert(bignat_mul_inplace(&grown, grown) == 0);
+		bignat_del(grown);
+		bignum_arena_clear(&arena);
+
+		/* 取っておいた領域にarenaの領域が混ざっていない */
+		bignat xs[70];
+		for (size_t i = 0; i < countof(xs); i++) {
+			test_assert(bignat_from_digit(&xs[i], i + 1) == 0);
+		}
+		for (size_t i = 0; i < countof(xs); i++) {
+			test_assert(xs[i].digits[0] == i + 1);
+			bignat_del(xs[i]);
+		}
+
+		bignum_arena_del(arena);
+		dgtvec_flush_cache();
+		bignum_set_allocator(NULL);
+		test_assert(st.live == 0);
+		test_assert(st.nmismatches == 0);
+	}
+	{
+		/* bigratの演算では途中の値をスレッドごとのarenaに置く */
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		};
+		bigrat x, y, sum, expected;
+		int cmp;
+		bignum_set_allocator(&a);
+
+		test_assert(bigrat_from_str(&x,
+			"12345678901234567890123456789/98765432109876543210987",
+			10) == 0);
+		test_assert(bigrat_from_str(&y,
+			"98765432109876543210987654321/12345678901234567890123",
+			10) == 0);
+		test_assert(bigrat_add(&sum, x, y) == 0);
+		bigrat_del(sum);
+
+		size_t nallocs = st.nallocs;
+		test_assert(bigrat_add(&sum, x, y) == 0);
+		test_assert(st.nallocs == nallocs + 2);
+		test_assert(!bignum_thread_arena()->active);
+		test_assert(bigrat_cmp(&cmp, x, y) == 0);
+		test_assert(cmp < 0);
+		test_assert(st.nallocs == nallocs + 2);
+
+		test_assert(bigrat_from_str(&expected,
+			"1100780707487002321486384850146137704307236846179986/"
+			"135480701263357550251310792704032984469153489",
+			10) == 0);
+		bool eq;
+		test_assert(bigrat_eq(&eq, sum, expected) == 0);
+		test_assert(eq);
+
+		bigrat_del(x);
+		bigrat_del(y);
+		bigrat_del(sum);
+		bigrat_del(expected);
+		dgtvec_flush_cache();
+		test_assert(st.live == 0);
+		bignum_set_allocator(NULL);
+		test_assert(st.nmismatches == 0);
+	}
+	{
+		/* 大きい値の演算ではスレッドごとのarenaを使わない */
+		size_t n = 200;
+		uint32_t *ds = calloc(n, sizeof(uint32_t));
+		test_assert(ds != NULL);
+		for (size_t i = 0; i < n; i++) {
+			ds[i] = (uint32_t)(i * 2654435761u) | 1;
+		}
+
+		bigrat x, y, sum;
+		test_assert(bigrat_init(&x, 1, ds, n, 1, ds, n - 1) == 0);
+		ds[0]++;
+		test_assert(bigrat_init(&y, 1, ds, n, 1, ds, n - 1) == 0);
+
+		dgtvec_flush_cache();
+		test_assert(bigrat_add(&sum, x, y) == 0);
+		test_assert(bignum_thread_arena()->chunk == NULL);
+
+		bigrat_del(x);
+		bigrat_del(y);
+		bigrat_del(sum);
+		free(ds);
+	}
+}
+
 void
 test_bignat_view()
 {
@@ -260,6 +762,345 @@ test_bignat_copy(void)
 	}
 }
 
+void
+test_bignat_from_str(void)
+{
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "0", 10) == 0);
+		test_assert(n.ndigits == 0);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "000", 16) == 0);
+		test_assert(n.ndigits == 0);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "4294967295", 10) == 0);
+		test_assert(n.ndigits == 1);
+		test_assert(n.digits[0] == 0xffffffff);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "4294967296", 10) == 0);
+		test_assert(n.ndigits == 2);
+		test_assert(n.digits[0] == 0);
+		test_assert(n.digits[1] == 1);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "0012345678901234567890123456789",
+					    10) == 0);
+		test_assert(n.ndigits == 3);
+		test_assert(n.digits[0] == 0x6e398115);
+		test_assert(n.digits[1] == 0x46bec9b1);
+		test_assert(n.digits[2] == 0x27e41b32);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "1fFfFfFfFfFfFfFfF", 16) == 0);
+		test_assert(n.ndigits == 3);
+		test_assert(n.digits[0] == 0xffffffff);
+		test_assert(n.digits[1] == 0xffffffff);
+		test_assert(n.digits[2] == 1);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "101", 2) == 0);
+		test_assert(n.ndigits == 1);
+		test_assert(n.digits[0] == 5);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "Zz", 36) == 0);
+		test_assert(n.ndigits == 1);
+		test_assert(n.digits[0] == 1295);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_strn(&n, "123xyz", 3, 10) == 0);
+		test_assert(n.ndigits == 1);
+		test_assert(n.digits[0] == 123);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		test_assert(bignat_from_str(&n, "", 10) == EINVAL);
+		test_assert(bignat_from_str(&n, "12a", 10) == EINVAL);
+		test_assert(bignat_from_str(&n, "102", 2) == EINVAL);
+		test_assert(bignat_from_str(&n, "-1", 10) == EINVAL);
+		test_assert(bignat_from_str(&n, " 1", 10) == EINVAL);
+		test_assert(bignat_from_str(&n, "0x1", 16) == EINVAL);
+		test_assert(bignat_from_str(&n, "0", 1) == EINVAL);
+		test_assert(bignat_from_str(&n, "0", 37) == EINVAL);
+		test_assert(bignat_from_strn(&n, "123", 0, 10) == EINVAL);
+	}
+	{
+		/* 分割統治法で変換する長さ */
+		char str[1001];
+		bignat n;
+		for (size_t i = 0; i < 1000; i++) {
+			str[i] = 'f';
+		}
+		str[1000] = '\0';
+		test_assert(bignat_from_str(&n, str, 16) == 0);
+		test_assert(n.ndigits == 125);
+		for (size_t i = 0; i < 125; i++) {
+			test_assert(n.digits[i] == 0xffffffff);
+		}
+		bignat_del(n);
+	}
+	{
+		/* 10^2000 = (10^1000)^2, 10^2000 - 1 = 99...9 */
+		char str[2002];
+		bignat x, sq, pow, nines, expected;
+		str[0] = '1';
+		for (size_t i = 1; i <= 2000; i++) {
+			str[i] = '0';
+		}
+		str[2001] = '\0';
+		test_assert(bignat_from_str(&pow, str, 10) == 0);
+		str[1001] = '\0';
+		test_assert(bignat_from_str(&x, str, 10) == 0);
+		test_assert(bignat_sqr(&sq, x) == 0);
+		test_assert(bignat_eq(sq, pow));
+
+		for (size_t i = 0; i < 2000; i++) {
+			str[i] = '9';
+		}
+		str[2000] = '\0';
+		test_assert(bignat_from_str(&nines, str, 10) == 0);
+		test_assert(bignat_sub_digit(&expected, pow, 1) == 0);
+		test_assert(bignat_eq(nines, expected));
+
+		bignat_del(x);
+		bignat_del(sq);
+		bignat_del(pow);
+		bignat_del(nines);
+		bignat_del(expected);
+	}
+}
+
+void
+test_bignat_to_str(void)
+{
+	{
+		bignat n = bignat_new_zero();
+		char str[2];
+		test_assert(bignat_str_size(n, 10) == 2);
+		test_assert(bignat_to_str(str, sizeof(str), n, 10) == 0);
+		test_assert(strcmp(str, "0") == 0);
+	}
+	{
+		bignat n;
+		char str[40];
+		test_assert(bignat_from_digit(&n, 0xffffffff) == 0);
+		test_assert(bignat_str_size(n, 10) >= 11);
+		test_assert(bignat_to_str(str, sizeof(str), n, 10) == 0);
+		test_assert(strcmp(str, "4294967295") == 0);
+		test_assert(bignat_to_str(str, sizeof(str), n, 16) == 0);
+		test_assert(strcmp(str, "ffffffff") == 0);
+		test_assert(bignat_str_size(n, 2) == 33);
+		test_assert(bignat_to_str(str, sizeof(str), n, 2) == 0);
+		test_assert(strcmp(str, "11111111111111111111111111111111") == 0);
+		test_assert(bignat_to_str(str, sizeof(str), n, 36) == 0);
+		test_assert(strcmp(str, "1z141z3") == 0);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		char str[40];
+		test_assert(bignat_from_str(&n, "12345678901234567890123456789",
+					    10) == 0);
+		test_assert(bignat_to_str(str, sizeof(str), n, 10) == 0);
+		test_assert(strcmp(str, "12345678901234567890123456789") == 0);
+		test_assert(bignat_to_str(str, sizeof(str), n, 16) == 0);
+		test_assert(strcmp(str, "27e41b3246bec9b16e398115") == 0);
+		bignat_del(n);
+	}
+	{
+		bignat n;
+		char str[40];
+		test_assert(bignat_from_digit(&n, 100) == 0);
+		test_assert(bignat_to_str(str, bignat_str_size(n, 10) - 1, n,
+					  10) == ERANGE);
+		test_assert(bignat_to_str(str, sizeof(str), n, 1) == EINVAL);
+		test_assert(bignat_to_str(str, sizeof(str), n, 37) == EINVAL);
+		test_assert(bignat_str_size(n, 37) == 0);
+		bignat_del(n);
+	}
+	{
+		/* 2の冪の基数では過不足ない大きさを返す */
+		bignat n;
+		char str[40];
+		test_assert(bignat_from_str(&n, "2000000000000000000000", 8) == 0);
+		test_assert(n.ndigits == 3);
+		test_assert(n.digits[0] == 0);
+		test_assert(n.digits[1] == 0);
+		test_assert(n.digits[2] == 1);
+		test_assert(bignat_str_size(n, 8) == 23);
+		test_assert(bignat_to_str(str, 23, n, 8) == 0);
+		test_assert(strcmp(str, "2000000000000000000000") == 0);
+		test_assert(bignat_str_size(n, 32) == 14);
+		test_assert(bignat_to_str(str, 14, n, 32) == 0);
+		test_assert(strcmp(str, "g000000000000") == 0);
+		test_assert(bignat_str_size(n, 4) == 34);
+		test_assert(bignat_to_str(str, 34, n, 4) == 0);
+		test_assert(strcmp(str, "100000000000000000000000000000000") == 0);
+		bignat_del(n);
+	}
+	{
+		/* 分割統治法で変換する長さ */
+		static char str[2002];
+		bignat pow, nines, back;
+		str[0] = '1';
+		for (size_t i = 1; i <= 2000; i++) {
+			str[i] = '0';
+		}
+		str[2001] = '\0';
+		test_assert(bignat_from_str(&pow, str, 10) == 0);
+		test_assert(bignat_sub_digit(&nines, pow, 1) == 0);
+
+		test_assert(bignat_str_size(pow, 10) <= sizeof(str));
+		test_assert(bignat_to_str(str, sizeof(str), pow, 10) == 0);
+		test_assert(strlen(str) == 2001);
+		test_assert(str[0] == '1');
+		test_assert(strspn(str + 1, "0") == 2000);
+
+		test_assert(bignat_to_str(str, sizeof(str), nines, 10) == 0);
+		test_assert(strlen(str) == 2000);
+		test_assert(strspn(str, "9") == 2000);
+
+		test_assert(bignat_to_str(str, sizeof(str), nines, 16) == 0);
+		test_assert(bignat_from_str(&back, str, 16) == 0);
+		test_assert(bignat_eq(back, nines));
+
+		bignat_del(pow);
+		bignat_del(nines);
+		bignat_del(back);
+	}
+}
+
+void
+test_bignat_export(void)
+{
+	{
+		bignat x = bignat_new_zero(), y;
+		uint32_t buf[1];
+		size_t len;
+		test_assert(bignat_export_size(x) == 4);
+		test_assert(bignat_export(buf, sizeof(buf), x) == 0);
+		test_assert(memcmp(buf, "\x02\x00\x00\x00", 4) == 0);
+		test_assert(bignat_import(&y, &len, buf, sizeof(buf)) == 0);
+		test_assert(len == 4);
+		test_assert(y.ndigits == 0);
+		bignat_del(y);
+	}
+	{
+		bignat x, y;
+		uint32_t buf[4];
+		size_t len;
+		test_assert(bignat_init(&x, (uint32_t[]){0x04030201, 0x08070605},
+					2) == 0);
+		test_assert(bignat_export_size(x) == 12);
+		test_assert(bignat_export(buf, 11, x) == ERANGE);
+		test_assert(bignat_export(buf, sizeof(buf), x) == 0);
+		test_assert(memcmp(buf, "\x02\x02\x00\x00"
+				   "\x01\x02\x03\x04\x05\x06\x07\x08", 12) == 0);
+
+		test_assert(bignat_import(&y, &len, buf, sizeof(buf)) == 0);
+		test_assert(len == 12);
+		test_assert(bignat_eq(x, y));
+		bignat_del(y);
+
+		/* 桁の並びが途中で切れている */
+		test_assert(bignat_import(&y, &len, buf, 11) == EINVAL);
+
+		bignat_del(x);
+	}
+	{
+		/* 桁数の符号が2バイトになる */
+		uint32_t ds[200], buf[52];
+		bignat x, y, v;
+		size_t len;
+		for (size_t i = 0; i < countof(ds); i++) {
+			ds[i] = i + 1;
+		}
+		test_assert(bignat_view(&x, ds, 50) == 0);
+		test_assert(bignat_export_size(x) == 4 + 200);
+		test_assert(bignat_export(buf, sizeof(buf), x) == 0);
+		test_assert(bignat_import_view(&v, &len, buf, sizeof(buf)) == 0);
+		test_assert(len == 204);
+		test_assert(v.digits == buf + 1);
+		test_assert(bignat_eq(x, v));
+
+		test_assert(bignat_view(&x, ds, 200) == 0);
+		test_assert(bignat_export_size(x) == 4 + 800);
+		test_assert(bignat_export(buf, sizeof(buf), x) == ERANGE);
+		{
+			uint32_t big[201];
+			test_assert(bignat_export(big, sizeof(big), x) == 0);
+			test_assert(((uint8_t *)big)[1] == 0xc8);
+			test_assert(((uint8_t *)big)[2] == 0x01);
+			test_assert(bignat_import(&y, &len, big, sizeof(big)) == 0);
+			test_assert(len == 804);
+			test_assert(bignat_eq(x, y));
+			bignat_del(y);
+		}
+	}
+	{
+		/* 壊れた記録 */
+		bignat y;
+		size_t len;
+		uint32_t buf[2];
+		memcpy(buf, "\x04\x01\x00\x00\x01\x00\x00\x00", 8);
+		test_assert(bignat_import(&y, &len, buf, 8) == EINVAL);
+		memcpy(buf, "\x03\x01\x00\x00\x01\x00\x00\x00", 8);
+		test_assert(bignat_import(&y, &len, buf, 8) == EINVAL);
+		memcpy(buf, "\x02\x01\x01\x00\x01\x00\x00\x00", 8);
+		test_assert(bignat_import(&y, &len, buf, 8) == EINVAL);
+		memcpy(buf, "\x02\x01\x00\x00\x00\x00\x00\x00", 8);
+		test_assert(bignat_import(&y, &len, buf, 8) == EINVAL);
+		test_assert(bignat_import_view(&y, &len, buf, 8) == EINVAL);
+		memcpy(buf, "\x02\x81\x80\x80", 4);
+		test_assert(bignat_import(&y, &len, buf, 4) == EINVAL);
+		test_assert(bignat_import(&y, &len, buf, 3) == EINVAL);
+
+		/* 桁数の符号は最短でなければならない */
+		memcpy(buf, "\x02\x80\x00\x00", 4);
+		test_assert(bignat_import(&y, &len, buf, 4) == EINVAL);
+		memcpy(buf, "\x02\x81\x80\x00\x01\x00\x00\x00", 8);
+		test_assert(bignat_import(&y, &len, buf, 8) == EINVAL);
+		test_assert(bignat_import_view(&y, &len, buf, 8) == EINVAL);
+		memcpy(buf, "\x02\x81\x00\x00\x01\x00\x00\x00", 8);
+		test_assert(bignat_import(&y, &len, buf, 8) == EINVAL);
+	}
+	{
+		/* ビューは桁の並びが境界に揃っている必要がある */
+		uint32_t buf[4];
+		bignat x, v;
+		size_t len;
+		test_assert(bignat_from_digit(&x, 7) == 0);
+		test_assert(bignat_export((uint8_t *)buf + 1, 12, x) == 0);
+		test_assert(bignat_import_view(&v, &len, (uint8_t *)buf + 1,
+					       12) == EINVAL);
+		test_assert(bignat_import(&v, &len, (uint8_t *)buf + 1, 12) == 0);
+		test_assert(len == 8);
+		test_assert(bignat_eq(x, v));
+		bignat_del(v);
+		bignat_del(x);
+	}
+}
+
 /* for memory leak detection */
 void
 test_bignat_del(void)
@@ -647,47 +1488,129 @@ test_bignat_add(void)
 }
 
 void
-test_bignat_sub(void)
+test_bignat_add_digit(void)
 {
 	{
-		bignat x, y, diff, expected;
+		bignat x, sum, expected;
 		test_assert(bignat_from_digit(&x, 0) == 0);
-		test_assert(bignat_from_digit(&y, 0) == 0);
 		test_assert(bignat_from_digit(&expected, 0) == 0);
 
-		test_assert(bignat_sub(&diff, x, y) == 0);
-		test_assert(bignat_eq(diff, expected));
+		test_assert(bignat_add_digit(&sum, x, 0) == 0);
+		test_assert(bignat_eq(sum, expected));
 
 		bignat_del(x);
-		bignat_del(y);
-		bignat_del(diff);
+		bignat_del(sum);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, diff, expected;
-		test_assert(bignat_from_digit(&x, 3) == 0);
-		test_assert(bignat_from_digit(&y, 2) == 0);
-		test_assert(bignat_from_digit(&expected, 1) == 0);
+		bignat x, sum, expected;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&expected, 5) == 0);
 
-		test_assert(bignat_sub(&diff, x, y) == 0);
-		test_assert(bignat_eq(diff, expected));
+		test_assert(bignat_add_digit(&sum, x, 5) == 0);
+		test_assert(bignat_eq(sum, expected));
 
 		bignat_del(x);
-		bignat_del(y);
-		bignat_del(diff);
+		bignat_del(sum);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, diff, expected;
-		test_assert(bignat_from_digit(&x, 3) == 0);
-		test_assert(bignat_from_digit(&y, 3) == 0);
-		test_assert(bignat_from_digit(&expected, 0) == 0);
+		bignat x, sum, expected;
+		test_assert(bignat_from_digit(&x, 1) == 0);
+		test_assert(bignat_from_digit(&expected, 3) == 0);
 
-		test_assert(bignat_sub(&diff, x, y) == 0);
-		test_assert(bignat_eq(diff, expected));
+		test_assert(bignat_add_digit(&sum, x, 2) == 0);
+		test_assert(bignat_eq(sum, expected));
 
 		bignat_del(x);
-		bignat_del(y);
+		bignat_del(sum);
+		bignat_del(expected);
+	}
+	{
+		bignat x, sum, expected;
+		uint32_t eds[] = {0, 1};
+		test_assert(bignat_from_digit(&x, 0xffffffff) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_add_digit(&sum, x, 1) == 0);
+		test_assert(bignat_eq(sum, expected));
+
+		bignat_del(x);
+		bignat_del(sum);
+		bignat_del(expected);
+	}
+	{
+		bignat x, sum, expected;
+		uint32_t xds[] = {0xffffffff, 0xffffffff, 0xffffffff},
+			eds[] = {0, 0, 0, 1};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_add_digit(&sum, x, 1) == 0);
+		test_assert(bignat_eq(sum, expected));
+
+		bignat_del(x);
+		bignat_del(sum);
+		bignat_del(expected);
+	}
+	{
+		bignat x, sum, expected;
+		uint32_t xds[] = {0xffffffff, 0x76543210, 0xfedcba98},
+			eds[] = {0x12345677, 0x76543211, 0xfedcba98};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_add_digit(&sum, x, 0x12345678) == 0);
+		test_assert(bignat_eq(sum, expected));
+
+		bignat_del(x);
+		bignat_del(sum);
+		bignat_del(expected);
+	}
+}
+
+void
+test_bignat_sub(void)
+{
+	{
+		bignat x, y, diff, expected;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&y, 0) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_sub(&diff, x, y) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(diff);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, diff, expected;
+		test_assert(bignat_from_digit(&x, 3) == 0);
+		test_assert(bignat_from_digit(&y, 2) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_sub(&diff, x, y) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(diff);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, diff, expected;
+		test_assert(bignat_from_digit(&x, 3) == 0);
+		test_assert(bignat_from_digit(&y, 3) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_sub(&diff, x, y) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(y);
 		bignat_del(diff);
 		bignat_del(expected);
 	}
@@ -795,6 +1718,83 @@ test_bignat_sub(void)
 	}
 }
 
+void
+test_bignat_sub_digit(void)
+{
+	{
+		bignat x, diff, expected;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_sub_digit(&diff, x, 0) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(diff);
+		bignat_del(expected);
+	}
+	{
+		bignat x, diff, expected;
+		test_assert(bignat_from_digit(&x, 3) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_sub_digit(&diff, x, 3) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(diff);
+		bignat_del(expected);
+	}
+	{
+		bignat x, diff, expected;
+		test_assert(bignat_from_digit(&x, 5) == 0);
+		test_assert(bignat_from_digit(&expected, 3) == 0);
+
+		test_assert(bignat_sub_digit(&diff, x, 2) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(diff);
+		bignat_del(expected);
+	}
+	{
+		bignat x, diff;
+		test_assert(bignat_from_digit(&x, 2) == 0);
+
+		test_assert(bignat_sub_digit(&diff, x, 5) == EDOM);
+
+		bignat_del(x);
+	}
+	{
+		bignat x, diff, expected;
+		uint32_t xds[] = {0, 0, 1},
+			eds[] = {0xffffffff, 0xffffffff};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_sub_digit(&diff, x, 1) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(diff);
+		bignat_del(expected);
+	}
+	{
+		bignat x, diff, expected;
+		uint32_t xds[] = {0xffffffff, 0x76543210, 0xfedcba98},
+			eds[] = {0xedcba987, 0x76543210, 0xfedcba98};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_sub_digit(&diff, x, 0x12345678) == 0);
+		test_assert(bignat_eq(diff, expected));
+
+		bignat_del(x);
+		bignat_del(diff);
+		bignat_del(expected);
+	}
+}
+
 void
 test_bignat_mul(void)
 {
@@ -918,114 +1918,708 @@ test_bignat_mul(void)
 		bignat_del(prod);
 		bignat_del(expected);
 	}
-}
-
-void
-test_bignat_divmod(void)
-{
 	{
-		bignat x, y, quot, rem, expected_q, expected_r;
-		test_assert(bignat_from_digit(&x, 13) == 0);
-		test_assert(bignat_from_digit(&y, 3) == 0);
-		test_assert(bignat_from_digit(&expected_q, 4) == 0);
-		test_assert(bignat_from_digit(&expected_r, 1) == 0);
+		/* (B^100 - 1)^2 = B^200 - 2 * B^100 + 1 */
+		bignat x, prod, expected;
+		uint32_t xds[100], eds[200];
+		for (size_t i = 0; i < countof(xds); i++) {
+			xds[i] = UINT32_MAX;
+		}
+		for (size_t i = 0; i < countof(eds); i++) {
+			eds[i] = i < 100 ? 0 : UINT32_MAX;
+		}
+		eds[0] = 1;
+		eds[100] = UINT32_MAX - 1;
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
 
-		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
-		test_assert(bignat_eq(quot, expected_q));
-		test_assert(bignat_eq(rem, expected_r));
+		test_assert(bignat_mul(&prod, x, x) == 0);
+		test_assert(bignat_eq(prod, expected));
 
 		bignat_del(x);
-		bignat_del(y);
-		bignat_del(quot);
-		bignat_del(rem);
-		bignat_del(expected_q);
-		bignat_del(expected_r);
+		bignat_del(prod);
+		bignat_del(expected);
 	}
 	{
-		bignat x, y, quot, rem, expected_q, expected_r;
-		test_assert(bignat_from_digit(&x, 0) == 0);
-		test_assert(bignat_from_digit(&y, 1) == 0);
-		test_assert(bignat_from_digit(&expected_q, 0) == 0);
-		test_assert(bignat_from_digit(&expected_r, 0) == 0);
+		/* (B^150 - 1)(B^40 - 1) = B^190 - B^150 - B^40 + 1 */
+		bignat x, y, prod, expected;
+		uint32_t xds[150], yds[40], eds[190];
+		for (size_t i = 0; i < countof(xds); i++) {
+			xds[i] = UINT32_MAX;
+		}
+		for (size_t i = 0; i < countof(yds); i++) {
+			yds[i] = UINT32_MAX;
+		}
+		for (size_t i = 0; i < countof(eds); i++) {
+			eds[i] = i < 40 ? 0 : UINT32_MAX;
+		}
+		eds[0] = 1;
+		eds[150] = UINT32_MAX - 1;
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
 
-		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
-		test_assert(bignat_eq(quot, expected_q));
-		test_assert(bignat_eq(rem, expected_r));
+		test_assert(bignat_mul(&prod, x, y) == 0);
+		test_assert(bignat_eq(prod, expected));
+		bignat_del(prod);
+
+		test_assert(bignat_mul(&prod, y, x) == 0);
+		test_assert(bignat_eq(prod, expected));
 
 		bignat_del(x);
 		bignat_del(y);
-		bignat_del(quot);
-		bignat_del(rem);
-		bignat_del(expected_q);
-		bignat_del(expected_r);
+		bignat_del(prod);
+		bignat_del(expected);
 	}
 	{
-		bignat x, y, quot, rem, expected_q, expected_r;
-		uint32_t xds[] = {0, 1},
-			yds[] = {1},
-			edsq[] = {0, 1};
-		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
-		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
-		test_assert(bignat_init(&expected_q, edsq, countof(edsq)) == 0);
-		test_assert(bignat_from_digit(&expected_r, 0) == 0);
+		/*
+		 * (B^n - 1)(B^m - 1) = B^(n+m) - B^n - B^m + 1
+		 * Toom-Cook法の各分割、大きく不均衡な場合、NTT
+		 */
+		static uint32_t xds[5000], yds[3000], eds[8000];
+		size_t sizes[][2] = {{500, 500}, {600, 400}, {900, 400},
+				     {2000, 300}, {3000, 3000}, {5000, 2600}};
+		for (size_t i = 0; i < countof(sizes); i++) {
+			bignat x, y, prod, expected;
+			size_t n = sizes[i][0], m = sizes[i][1];
+			for (size_t j = 0; j < n; j++) {
+				xds[j] = UINT32_MAX;
+			}
+			for (size_t j = 0; j < m; j++) {
+				yds[j] = UINT32_MAX;
+			}
+			for (size_t j = 0; j < n + m; j++) {
+				eds[j] = j < m ? 0 : UINT32_MAX;
+			}
+			eds[0] = 1;
+			eds[n] = UINT32_MAX - 1;
+			test_assert(bignat_init(&x, xds, n) == 0);
+			test_assert(bignat_init(&y, yds, m) == 0);
+			test_assert(bignat_init(&expected, eds, n + m) == 0);
+
+			test_assert(bignat_mul(&prod, x, y) == 0);
+			test_assert(bignat_eq(prod, expected));
+
+			bignat_del(x);
+			bignat_del(y);
+			bignat_del(prod);
+			bignat_del(expected);
+		}
+	}
+	{
+		/*
+		 * 各アルゴリズムの境界の前後で、線形合同法で埋めた桁の積と平
+		 * 方を筆算の結果と比べる。桁がすべて等しいと打ち消し合う誤り
+		 * も検出する。
+		 */
+		static uint32_t xds[5000], yds[3000], eds[10000];
+		size_t sizes[][2] = {{31, 31}, {32, 32}, {159, 100},
+				     {160, 160}, {240, 160}, {320, 160},
+				     {399, 399}, {400, 400}, {600, 400},
+				     {800, 400}, {1000, 250}, {2000, 300},
+				     {2499, 2499}, {2500, 2500}, {5000, 2600}};
+		uint32_t seed = 1;
+		for (size_t i = 0; i < countof(sizes); i++) {
+			size_t n = sizes[i][0], m = sizes[i][1];
+			for (size_t j = 0; j < n; j++) {
+				seed = seed * 1664525 + 1013904223;
+				xds[j] = seed;
+			}
+			for (size_t j = 0; j < m; j++) {
+				seed = seed * 1664525 + 1013904223;
+				yds[j] = seed;
+			}
+			xds[n - 1] |= 1;
+			yds[m - 1] |= 1;
+
+			for (int sqr = 0; sqr <= 1; sqr++) {
+				uint32_t *bp = sqr ? xds : yds;
+				size_t bn = sqr ? n : m;
+				bignat x, y, prod, expected;
+
+				for (size_t j = 0; j < n + bn; j++) {
+					eds[j] = 0;
+				}
+				for (size_t j = 0; j < bn; j++) {
+					uint64_t carry = 0;
+					for (size_t k = 0; k < n; k++) {
+						uint64_t t = (uint64_t)xds[k] *
+							bp[j] + eds[j + k] +
+							carry;
+						eds[j + k] = t;
+						carry = t >> 32;
+					}
+					eds[j + n] = carry;
+				}
+
+				test_assert(bignat_init(&x, xds, n) == 0);
+				test_assert(bignat_init(&y, bp, bn) == 0);
+				test_assert(bignat_init(&expected, eds,
+							n + bn -
+							(eds[n + bn - 1] == 0))
+					    == 0);
+
+				if (sqr) {
+					test_assert(bignat_sqr(&prod, x) == 0);
+				} else {
+					test_assert(bignat_mul(&prod, x, y)
+						    == 0);
+				}
+				test_assert(bignat_eq(prod, expected));
+
+				bignat_del(x);
+				bignat_del(y);
+				bignat_del(prod);
+				bignat_del(expected);
+			}
+		}
+	}
+}
 
-		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
-		test_assert(bignat_eq(quot, expected_q));
-		test_assert(bignat_eq(rem, expected_r));
+void
+test_bignat_mul_digit(void)
+{
+	{
+		bignat x, prod, expected;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_mul_digit(&prod, x, 7) == 0);
+		test_assert(bignat_eq(prod, expected));
 
 		bignat_del(x);
-		bignat_del(y);
-		bignat_del(quot);
-		bignat_del(rem);
-		bignat_del(expected_q);
-		bignat_del(expected_r);
+		bignat_del(prod);
+		bignat_del(expected);
 	}
 	{
-		bignat x, y, quot, rem, expected_q, expected_r;
-		uint32_t xds[] = {0, 1},
-			yds[] = {2},
-			edsq[] = {((uint64_t)1 << 32) / 2};
-		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
-		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
-		test_assert(bignat_init(&expected_q, edsq, countof(edsq)) == 0);
-		test_assert(bignat_from_digit(&expected_r, 0) == 0);
+		bignat x, prod, expected;
+		test_assert(bignat_from_digit(&x, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
 
-		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
-		test_assert(bignat_eq(quot, expected_q));
-		test_assert(bignat_eq(rem, expected_r));
+		test_assert(bignat_mul_digit(&prod, x, 0) == 0);
+		test_assert(bignat_eq(prod, expected));
 
 		bignat_del(x);
-		bignat_del(y);
-		bignat_del(quot);
-		bignat_del(rem);
-		bignat_del(expected_q);
-		bignat_del(expected_r);
+		bignat_del(prod);
+		bignat_del(expected);
 	}
 	{
-		bignat x, y, quot, rem, expected_q, expected_r;
-		uint32_t xds[] = {0, 0, 1},
-			yds[] = {0, 0, 0, 1},
-			edsr[] = {0, 0, 1};
-		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
-		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
-		test_assert(bignat_from_digit(&expected_q, 0) == 0);
-		test_assert(bignat_init(&expected_r, edsr, countof(edsr)) == 0);
+		bignat x, prod, expected;
+		test_assert(bignat_from_digit(&x, 2) == 0);
+		test_assert(bignat_from_digit(&expected, 6) == 0);
 
-		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
-		test_assert(bignat_eq(quot, expected_q));
-		test_assert(bignat_eq(rem, expected_r));
+		test_assert(bignat_mul_digit(&prod, x, 3) == 0);
+		test_assert(bignat_eq(prod, expected));
 
 		bignat_del(x);
-		bignat_del(y);
-		bignat_del(quot);
-		bignat_del(rem);
-		bignat_del(expected_q);
-		bignat_del(expected_r);
+		bignat_del(prod);
+		bignat_del(expected);
 	}
 	{
-		bignat x, y, quot, rem, expected_q, expected_r;
-		uint32_t xds[] = {0, 0, 1},
-			yds[] = {3},
+		bignat x, prod, expected;
+		uint32_t eds[] = {1, 0xfffffffe};
+		test_assert(bignat_from_digit(&x, 0xffffffff) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_mul_digit(&prod, x, 0xffffffff) == 0);
+		test_assert(bignat_eq(prod, expected));
+
+		bignat_del(x);
+		bignat_del(prod);
+		bignat_del(expected);
+	}
+	{
+		bignat x, prod, expected;
+		uint32_t xds[] = {0xffffffff, 0x76543210, 0xfedcba98},
+			eds[] = {0xedcba988, 0x1dbd2df7, 0x3d70a3d7, 0x121fa00a};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_mul_digit(&prod, x, 0x12345678) == 0);
+		test_assert(bignat_eq(prod, expected));
+
+		bignat_del(x);
+		bignat_del(prod);
+		bignat_del(expected);
+	}
+}
+
+void
+test_bignat_inplace(void)
+{
+	{
+		bignat acc, x, expected;
+		uint32_t xds[] = {~(uint32_t)0, ~(uint32_t)0},
+			eds[] = {~(uint32_t)0 - 1, ~(uint32_t)0, 1};
+		test_assert(bignat_init(&acc, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_add_inplace(&acc, x) == 0);
+		test_assert(bignat_eq(acc, expected));
+
+		test_assert(bignat_sub_inplace(&acc, x) == 0);
+		test_assert(bignat_eq(acc, x));
+
+		bignat_del(acc);
+		bignat_del(x);
+		bignat_del(expected);
+	}
+	{
+		/* 容量が足りる間は領域を再利用する */
+		bignat acc, x;
+		uint32_t *digits, *xdigits;
+		test_assert(bignat_from_digit(&acc, 1) == 0);
+		test_assert(bignat_reserve(&acc, 5) == 0);
+		test_assert(acc.ndigits == 1 && acc.digits[0] == 1);
+		digits = acc.digits;
+
+		for (int i = 0; i < 100; i++) {
+			test_assert(bignat_add_inplace(&acc, acc) == 0);
+			test_assert(bignat_add_digit_inplace(&acc, 1) == 0);
+		}
+		test_assert(acc.digits == digits);
+		test_assert(acc.ndigits == 4);
+		test_assert(acc.digits[3] == 31);
+
+		x = bignat_new_zero();
+		test_assert(bignat_reserve(&x, 4) == 0);
+		xdigits = x.digits;
+		for (int i = 0; i < 100; i++) {
+			uint32_t r;
+			test_assert(bignat_sub_digit_inplace(&acc, 1) == 0);
+			test_assert(bignat_divmod_digit_into(&x, &r,
+							     acc, 2) == 0);
+			test_assert(r == 0);
+			test_assert(bignat_sub_inplace(&acc, x) == 0);
+		}
+		test_assert(acc.digits == digits);
+		test_assert(x.digits == xdigits);
+		test_assert(acc.ndigits == 1 && acc.digits[0] == 1);
+
+		bignat_del(acc);
+		bignat_del(x);
+	}
+	{
+		bignat acc, x;
+		test_assert(bignat_from_digit(&acc, 1) == 0);
+		test_assert(bignat_from_digit(&x, 2) == 0);
+
+		test_assert(bignat_sub_inplace(&acc, x) == EDOM);
+		test_assert(acc.ndigits == 1 && acc.digits[0] == 1);
+		test_assert(bignat_sub_digit_inplace(&acc, 2) == EDOM);
+		test_assert(acc.ndigits == 1 && acc.digits[0] == 1);
+
+		test_assert(bignat_sub_inplace(&acc, acc) == 0);
+		test_assert(acc.ndigits == 0);
+		test_assert(bignat_sub_digit_inplace(&acc, 1) == EDOM);
+		test_assert(bignat_sub_digit_inplace(&acc, 0) == 0);
+		test_assert(acc.ndigits == 0);
+
+		bignat_del(acc);
+		bignat_del(x);
+	}
+	{
+		/* 3^k を累積した積と、bignat_mulで求めた積を比べる */
+		bignat acc, x, prod, tmp;
+		test_assert(bignat_from_digit(&acc, 1) == 0);
+		test_assert(bignat_from_digit(&x, 3) == 0);
+		test_assert(bignat_from_digit(&prod, 1) == 0);
+
+		for (int i = 0; i < 12; i++) {
+			test_assert(bignat_mul_inplace(&acc, x) == 0);
+			test_assert(bignat_mul(&tmp, prod, x) == 0);
+			bignat_del(prod);
+			prod = tmp;
+			test_assert(bignat_eq(acc, prod));
+
+			test_assert(bignat_mul_inplace(&x, x) == 0);
+		}
+		test_assert(bignat_mul_digit_inplace(&acc, 7) == 0);
+		test_assert(bignat_mul_digit(&tmp, prod, 7) == 0);
+		test_assert(bignat_eq(acc, tmp));
+		bignat_del(tmp);
+
+		test_assert(bignat_mul_digit_inplace(&acc, 0) == 0);
+		test_assert(acc.ndigits == 0);
+		test_assert(bignat_mul_inplace(&x, acc) == 0);
+		test_assert(x.ndigits == 0);
+
+		bignat_del(acc);
+		bignat_del(x);
+		bignat_del(prod);
+	}
+}
+
+void
+test_bignat_into(void)
+{
+	{
+		bignat x, y, out, expected;
+		uint32_t xds[] = {1, 2, 3}, yds[] = {~(uint32_t)0, 5},
+			sds[] = {0, 8, 3}, dds[] = {2, ~(uint32_t)0 - 3, 2},
+			pds[] = {~(uint32_t)0, 3, 9, 18},
+			qds[] = {2, 4, 6}, ods[] = {7, 7, 7, 7, 7, 7, 7, 7};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&out, ods, countof(ods)) == 0);
+
+		test_assert(bignat_add_into(&out, x, y) == 0);
+		test_assert(bignat_init(&expected, sds, countof(sds)) == 0);
+		test_assert(bignat_eq(out, expected));
+		bignat_del(expected);
+
+		test_assert(bignat_sub_into(&out, x, y) == 0);
+		test_assert(bignat_init(&expected, dds, countof(dds)) == 0);
+		test_assert(bignat_eq(out, expected));
+		bignat_del(expected);
+
+		test_assert(bignat_mul_into(&out, x, y) == 0);
+		test_assert(bignat_init(&expected, pds, countof(pds)) == 0);
+		test_assert(bignat_eq(out, expected));
+		bignat_del(expected);
+
+		test_assert(bignat_mul_digit_into(&out, x, 2) == 0);
+		test_assert(bignat_init(&expected, qds, countof(qds)) == 0);
+		test_assert(bignat_eq(out, expected));
+
+		test_assert(bignat_sub_into(&out, y, x) == EDOM);
+		test_assert(bignat_eq(out, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(out);
+		bignat_del(expected);
+	}
+	{
+		/* 書き込み先が第2入力と同じ場合 */
+		bignat x, y, expected;
+		uint32_t xds[] = {1, 2, 3}, yds[] = {~(uint32_t)0, 5},
+			sds[] = {0, 8, 3}, dds[] = {2, ~(uint32_t)0 - 3, 2},
+			pds[] = {~(uint32_t)0, 3, 9, 18};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_add_into(&y, x, y) == 0);
+		test_assert(bignat_init(&expected, sds, countof(sds)) == 0);
+		test_assert(bignat_eq(y, expected));
+		bignat_del(expected);
+		bignat_del(y);
+
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_sub_into(&y, x, y) == 0);
+		test_assert(bignat_init(&expected, dds, countof(dds)) == 0);
+		test_assert(bignat_eq(y, expected));
+		bignat_del(expected);
+		bignat_del(y);
+
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_mul_into(&y, x, y) == 0);
+		test_assert(bignat_init(&expected, pds, countof(pds)) == 0);
+		test_assert(bignat_eq(y, expected));
+		bignat_del(expected);
+		bignat_del(y);
+
+		bignat_del(x);
+	}
+	{
+		bignat x, sq, expected;
+		uint32_t xds[] = {1, 2, 3}, eds[] = {1, 4, 10, 12, 9};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		sq = bignat_new_zero();
+		test_assert(bignat_sqr_into(&sq, x) == 0);
+		test_assert(bignat_eq(sq, expected));
+
+		test_assert(bignat_sqr_into(&x, x) == 0);
+		test_assert(bignat_eq(x, expected));
+
+		test_assert(bignat_sqr_into(&sq, bignat_new_zero()) == 0);
+		test_assert(sq.ndigits == 0);
+
+		bignat_del(x);
+		bignat_del(sq);
+		bignat_del(expected);
+	}
+	{
+		/* bignat_divmodと同じ商と剰余を、書き込み先の領域を再利用して求める */
+		static uint32_t xds[300], yds[300];
+		size_t sizes[][2] = {{3, 2}, {3, 1}, {2, 3}, {300, 120}};
+		for (size_t i = 0; i < countof(sizes); i++) {
+			bignat x, y, quot, rem, eq, er;
+			uint32_t *qdigits, *rdigits;
+			size_t xn = sizes[i][0], yn = sizes[i][1];
+			for (size_t j = 0; j < xn; j++) {
+				xds[j] = (uint32_t)(j * 2654435761u + 5);
+			}
+			for (size_t j = 0; j < yn; j++) {
+				yds[j] = (uint32_t)(j * 2246822519u + 3);
+			}
+			test_assert(bignat_init(&x, xds, xn) == 0);
+			test_assert(bignat_init(&y, yds, yn) == 0);
+			test_assert(bignat_divmod(&eq, &er, x, y) == 0);
+
+			quot = bignat_new_zero();
+			rem = bignat_new_zero();
+			test_assert(bignat_reserve(&quot, xn) == 0);
+			test_assert(bignat_reserve(&rem, yn) == 0);
+			qdigits = quot.digits;
+			rdigits = rem.digits;
+			for (int j = 0; j < 2; j++) {
+				test_assert(bignat_divmod_into(&quot, &rem, x,
+							       y) == 0);
+				test_assert(bignat_eq(quot, eq));
+				test_assert(bignat_eq(rem, er));
+			}
+			test_assert(quot.digits == qdigits);
+			test_assert(rem.digits == rdigits);
+			bignat_del(quot);
+			bignat_del(rem);
+
+			/* 書き込み先が入力と同じ場合 */
+			test_assert(bignat_copy(&quot, x) == 0);
+			test_assert(bignat_copy(&rem, y) == 0);
+			test_assert(bignat_divmod_into(&quot, &rem, quot,
+						       rem) == 0);
+			test_assert(bignat_eq(quot, eq));
+			test_assert(bignat_eq(rem, er));
+			bignat_del(quot);
+			bignat_del(rem);
+
+			test_assert(bignat_copy(&quot, y) == 0);
+			test_assert(bignat_copy(&rem, x) == 0);
+			test_assert(bignat_divmod_into(&quot, &rem, rem,
+						       quot) == 0);
+			test_assert(bignat_eq(quot, eq));
+			test_assert(bignat_eq(rem, er));
+			bignat_del(quot);
+			bignat_del(rem);
+
+			bignat_del(x);
+			bignat_del(y);
+			bignat_del(eq);
+			bignat_del(er);
+		}
+	}
+	{
+		bignat x, quot, rem;
+		uint32_t xds[] = {1, 2, 3};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_from_digit(&quot, 4) == 0);
+		test_assert(bignat_from_digit(&rem, 5) == 0);
+
+		test_assert(bignat_divmod_into(&quot, &rem, x,
+					       bignat_new_zero()) == EDOM);
+		test_assert(quot.ndigits == 1 && quot.digits[0] == 4);
+		test_assert(rem.ndigits == 1 && rem.digits[0] == 5);
+		test_assert(bignat_divmod_into(&quot, &quot, x, rem) == EINVAL);
+		test_assert(quot.ndigits == 1 && quot.digits[0] == 4);
+
+		test_assert(bignat_divmod_into(&quot, &rem, bignat_new_zero(),
+					       x) == 0);
+		test_assert(quot.ndigits == 0 && rem.ndigits == 0);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(rem);
+	}
+	{
+		bignat nat;
+		uint32_t ds[] = {1, 2};
+		test_assert(bignat_init(&nat, ds, countof(ds)) == 0);
+
+		test_assert(bignat_reserve(&nat, 100) == 0);
+		test_assert(nat.cap >= 100);
+		test_assert(nat.ndigits == 2);
+		test_assert(nat.digits[0] == 1 && nat.digits[1] == 2);
+
+		test_assert(bignat_reserve(&nat, 1) == 0);
+		test_assert(nat.cap >= 100);
+		test_assert(nat.ndigits == 2);
+
+		bignat_del(nat);
+	}
+}
+
+void
+test_bignat_sqr(void)
+{
+	{
+		bignat x, sq, expected;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_sqr(&sq, x) == 0);
+		test_assert(bignat_eq(sq, expected));
+
+		bignat_del(x);
+		bignat_del(sq);
+		bignat_del(expected);
+	}
+	{
+		bignat x, sq, expected;
+		test_assert(bignat_from_digit(&x, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 49) == 0);
+
+		test_assert(bignat_sqr(&sq, x) == 0);
+		test_assert(bignat_eq(sq, expected));
+
+		bignat_del(x);
+		bignat_del(sq);
+		bignat_del(expected);
+	}
+	{
+		bignat x, sq, expected;
+		uint32_t xds[] = {3, 2}, eds[] = {9, 12, 4};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_sqr(&sq, x) == 0);
+		test_assert(bignat_eq(sq, expected));
+
+		bignat_del(x);
+		bignat_del(sq);
+		bignat_del(expected);
+	}
+	{
+		/* (B^n - 1)^2 = B^2n - 2 * B^n + 1 */
+		static uint32_t xds[3000], eds[6000];
+		size_t sizes[] = {2, 60, 500, 3000};
+		for (size_t i = 0; i < countof(sizes); i++) {
+			bignat x, sq, expected;
+			size_t n = sizes[i];
+			for (size_t j = 0; j < n; j++) {
+				xds[j] = UINT32_MAX;
+			}
+			for (size_t j = 0; j < 2 * n; j++) {
+				eds[j] = j < n ? 0 : UINT32_MAX;
+			}
+			eds[0] = 1;
+			eds[n] = UINT32_MAX - 1;
+			test_assert(bignat_init(&x, xds, n) == 0);
+			test_assert(bignat_init(&expected, eds, 2 * n) == 0);
+
+			test_assert(bignat_sqr(&sq, x) == 0);
+			test_assert(bignat_eq(sq, expected));
+			bignat_del(sq);
+
+			test_assert(bignat_mul(&sq, x, x) == 0);
+			test_assert(bignat_eq(sq, expected));
+
+			bignat_del(x);
+			bignat_del(sq);
+			bignat_del(expected);
+		}
+	}
+}
+
+void
+test_bignat_divmod(void)
+{
+	{
+		bignat x, y, quot, rem, expected_q, expected_r;
+		test_assert(bignat_from_digit(&x, 13) == 0);
+		test_assert(bignat_from_digit(&y, 3) == 0);
+		test_assert(bignat_from_digit(&expected_q, 4) == 0);
+		test_assert(bignat_from_digit(&expected_r, 1) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, expected_q));
+		test_assert(bignat_eq(rem, expected_r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(expected_q);
+		bignat_del(expected_r);
+	}
+	{
+		bignat x, y, quot, rem, expected_q, expected_r;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&y, 1) == 0);
+		test_assert(bignat_from_digit(&expected_q, 0) == 0);
+		test_assert(bignat_from_digit(&expected_r, 0) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, expected_q));
+		test_assert(bignat_eq(rem, expected_r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(expected_q);
+		bignat_del(expected_r);
+	}
+	{
+		bignat x, y, quot, rem, expected_q, expected_r;
+		uint32_t xds[] = {0, 1},
+			yds[] = {1},
+			edsq[] = {0, 1};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected_q, edsq, countof(edsq)) == 0);
+		test_assert(bignat_from_digit(&expected_r, 0) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, expected_q));
+		test_assert(bignat_eq(rem, expected_r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(expected_q);
+		bignat_del(expected_r);
+	}
+	{
+		bignat x, y, quot, rem, expected_q, expected_r;
+		uint32_t xds[] = {0, 1},
+			yds[] = {2},
+			edsq[] = {((uint64_t)1 << 32) / 2};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected_q, edsq, countof(edsq)) == 0);
+		test_assert(bignat_from_digit(&expected_r, 0) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, expected_q));
+		test_assert(bignat_eq(rem, expected_r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(expected_q);
+		bignat_del(expected_r);
+	}
+	{
+		bignat x, y, quot, rem, expected_q, expected_r;
+		uint32_t xds[] = {0, 0, 1},
+			yds[] = {0, 0, 0, 1},
+			edsr[] = {0, 0, 1};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_from_digit(&expected_q, 0) == 0);
+		test_assert(bignat_init(&expected_r, edsr, countof(edsr)) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, expected_q));
+		test_assert(bignat_eq(rem, expected_r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(expected_q);
+		bignat_del(expected_r);
+	}
+	{
+		bignat x, y, quot, rem, expected_q, expected_r;
+		uint32_t xds[] = {0, 0, 1},
+			yds[] = {3},
 			edsq[] = {UINT32_MAX / 3, UINT32_MAX / 3},
 			edsr[] = {1};
 		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
@@ -1133,11 +2727,86 @@ test_bignat_divmod(void)
 		bignat_del(expected_r);
 	}
 	{
-		bignat x, y, quot, rem;
-		test_assert(bignat_from_digit(&x, 1) == 0);
-		test_assert(bignat_from_digit(&y, 0) == 0);
+		/* 商の見積もりが過大で、除数を足し戻す場合 */
+		bignat x, y, quot, rem, expected_q, expected_r;
+		uint32_t xds[] = {0xfffffffe, 1, 0x80000000, 0x7fffffff},
+			yds[] = {0x7fffffff, 0, 0xffffffff},
+			edsq[] = {0x7fffffff},
+			edsr[] = {0xfffffffd, 0xc0000002, 0xfffffffe};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected_q, edsq, countof(edsq)) == 0);
+		test_assert(bignat_init(&expected_r, edsr, countof(edsr)) == 0);
 
-		test_assert(bignat_divmod(&quot, &rem, x, y) == EDOM);
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, expected_q));
+		test_assert(bignat_eq(rem, expected_r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(expected_q);
+		bignat_del(expected_r);
+	}
+	{
+		bignat x, y, quot, rem, expected_q, expected_r;
+		uint32_t xds[] = {5, 6, 7, 8, 9, 10},
+			yds[] = {3, 0x10},
+			edsq[] = {0x5c020000, 0x6aa00000, 0x72000000, 0xa0000000},
+			edsr[] = {0xebfa0005, 4};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected_q, edsq, countof(edsq)) == 0);
+		test_assert(bignat_init(&expected_r, edsr, countof(edsr)) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, expected_q));
+		test_assert(bignat_eq(rem, expected_r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(quot);
+		bignat_del(rem);
+		bignat_del(expected_q);
+		bignat_del(expected_r);
+	}
+	{
+		/* ((B^n - 1)^2 + 5) / (B^n - 1) = B^n - 1 余り 5 */
+		static uint32_t yds[3000], xds[6000];
+		size_t sizes[] = {3, 300, 3000};
+		for (size_t i = 0; i < countof(sizes); i++) {
+			bignat x, y, quot, rem, expected_r;
+			size_t n = sizes[i];
+			for (size_t j = 0; j < n; j++) {
+				yds[j] = UINT32_MAX;
+			}
+			for (size_t j = 0; j < 2 * n; j++) {
+				xds[j] = j < n ? 0 : UINT32_MAX;
+			}
+			xds[0] = 6;
+			xds[n] = UINT32_MAX - 1;
+			test_assert(bignat_init(&x, xds, 2 * n) == 0);
+			test_assert(bignat_init(&y, yds, n) == 0);
+			test_assert(bignat_from_digit(&expected_r, 5) == 0);
+
+			test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+			test_assert(bignat_eq(quot, y));
+			test_assert(bignat_eq(rem, expected_r));
+
+			bignat_del(x);
+			bignat_del(y);
+			bignat_del(quot);
+			bignat_del(rem);
+			bignat_del(expected_r);
+		}
+	}
+	{
+		bignat x, y, quot, rem;
+		test_assert(bignat_from_digit(&x, 1) == 0);
+		test_assert(bignat_from_digit(&y, 0) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == EDOM);
 
 		bignat_del(x);
 		bignat_del(y);
@@ -1152,6 +2821,278 @@ test_bignat_divmod(void)
 		bignat_del(x);
 		bignat_del(y);
 	}
+	{
+		/* x = y * q + (y - 1) を割って商と剰余を取り出す */
+		static uint32_t yds[3000], qds[4100];
+		bignat x, y, q, r, one, prod, quot, rem;
+		for (size_t i = 0; i < countof(yds); i++) {
+			yds[i] = i * 0x9e3779b9 + 0x7f4a7c15;
+		}
+		for (size_t i = 0; i < countof(qds); i++) {
+			qds[i] = i * 0x85ebca6b + 0xc2b2ae35;
+		}
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&q, qds, countof(qds)) == 0);
+		test_assert(bignat_from_digit(&one, 1) == 0);
+		test_assert(bignat_sub(&r, y, one) == 0);
+		test_assert(bignat_mul(&prod, y, q) == 0);
+		test_assert(bignat_add(&x, prod, r) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, q));
+		test_assert(bignat_eq(rem, r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(q);
+		bignat_del(r);
+		bignat_del(one);
+		bignat_del(prod);
+		bignat_del(quot);
+		bignat_del(rem);
+	}
+	{
+		/* Newton法で割る桁数 */
+		static uint32_t yds[6500], qds[7000];
+		bignat x, y, q, r, one, prod, quot, rem;
+		for (size_t i = 0; i < countof(yds); i++) {
+			yds[i] = i * 0x9e3779b9 + 0x7f4a7c15;
+		}
+		for (size_t i = 0; i < countof(qds); i++) {
+			qds[i] = i * 0x85ebca6b + 0xc2b2ae35;
+		}
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&q, qds, countof(qds)) == 0);
+		test_assert(bignat_from_digit(&one, 1) == 0);
+		test_assert(bignat_sub(&r, y, one) == 0);
+		test_assert(bignat_mul(&prod, y, q) == 0);
+		test_assert(bignat_add(&x, prod, r) == 0);
+
+		test_assert(bignat_divmod(&quot, &rem, x, y) == 0);
+		test_assert(bignat_eq(quot, q));
+		test_assert(bignat_eq(rem, r));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(q);
+		bignat_del(r);
+		bignat_del(one);
+		bignat_del(prod);
+		bignat_del(quot);
+		bignat_del(rem);
+	}
+}
+
+void
+test_bignat_divmod_digit(void)
+{
+	{
+		bignat x, quot;
+		uint32_t rem;
+		test_assert(bignat_from_digit(&x, 5) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 0) == EDOM);
+
+		bignat_del(x);
+	}
+	{
+		bignat x, quot, expected;
+		uint32_t rem;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 3) == 0);
+		test_assert(bignat_eq(quot, expected));
+		test_assert(rem == 0);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(expected);
+	}
+	{
+		bignat x, quot, expected;
+		uint32_t rem;
+		test_assert(bignat_from_digit(&x, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 3) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 2) == 0);
+		test_assert(bignat_eq(quot, expected));
+		test_assert(rem == 1);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(expected);
+	}
+	{
+		bignat x, quot, expected;
+		uint32_t rem;
+		test_assert(bignat_from_digit(&x, 2) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 7) == 0);
+		test_assert(bignat_eq(quot, expected));
+		test_assert(rem == 2);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(expected);
+	}
+	{
+		bignat x, quot, expected;
+		uint32_t rem;
+		uint32_t xds[] = {0xffffffff, 0xffffffff},
+			eds[] = {1, 1};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 0xffffffff) == 0);
+		test_assert(bignat_eq(quot, expected));
+		test_assert(rem == 0);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(expected);
+	}
+	{
+		bignat x, quot, expected;
+		uint32_t rem;
+		uint32_t xds[] = {0xffffffff, 0x76543210, 0xfedcba98},
+			eds[] = {0x00000402, 0x00000077, 0x0000000e};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 0x12345678) == 0);
+		test_assert(bignat_eq(quot, expected));
+		test_assert(rem == 0x0a3d730f);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(expected);
+	}
+	{
+		bignat x, quot, expected;
+		uint32_t rem;
+		uint32_t xds[] = {0xffffffff, 0x76543210, 0xfedcba98},
+			eds[] = {0x55555555, 0xd21c10b0, 0x54f43e32};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 3) == 0);
+		test_assert(bignat_eq(quot, expected));
+		test_assert(rem == 0);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(expected);
+	}
+	{
+		bignat x, quot, expected;
+		uint32_t rem;
+		uint32_t xds[] = {0xffffffff, 0x76543210, 0xfedcba98},
+			eds[] = {0xeca86421, 0xfdb97530, 1};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_divmod_digit(&quot, &rem, x, 0x80000000) == 0);
+		test_assert(bignat_eq(quot, expected));
+		test_assert(rem == 0x7fffffff);
+
+		bignat_del(x);
+		bignat_del(quot);
+		bignat_del(expected);
+	}
+}
+
+void
+test_bignat_invert(void)
+{
+	{
+		bignat x = bignat_new_zero(), inv;
+		test_assert(bignat_invert(&inv, x) == EDOM);
+		bignat_del(x);
+	}
+	{
+		bignat x, inv, expected;
+		uint32_t eds[] = {0, 0, 1};
+		test_assert(bignat_from_digit(&x, 1) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_invert(&inv, x) == 0);
+		test_assert(bignat_eq(inv, expected));
+
+		bignat_del(x);
+		bignat_del(inv);
+		bignat_del(expected);
+	}
+	{
+		bignat x, inv, expected;
+		uint32_t eds[] = {0x55555555, 0x55555555};
+		test_assert(bignat_from_digit(&x, 3) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_invert(&inv, x) == 0);
+		test_assert(bignat_eq(inv, expected));
+
+		bignat_del(x);
+		bignat_del(inv);
+		bignat_del(expected);
+	}
+	{
+		bignat x, inv, expected;
+		uint32_t xds[] = {0, 0x80000000}, eds[] = {0, 0, 2};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_invert(&inv, x) == 0);
+		test_assert(bignat_eq(inv, expected));
+
+		bignat_del(x);
+		bignat_del(inv);
+		bignat_del(expected);
+	}
+	{
+		/* B^2n / (B^n - 1) = B^n + 1 余り 1 */
+		static uint32_t xds[3000], eds[3001];
+		size_t sizes[] = {2, 500, 3000};
+		for (size_t i = 0; i < countof(sizes); i++) {
+			bignat x, inv, expected;
+			size_t n = sizes[i];
+			for (size_t j = 0; j < n; j++) {
+				xds[j] = UINT32_MAX;
+				eds[j] = j == 0;
+			}
+			eds[n] = 1;
+			test_assert(bignat_init(&x, xds, n) == 0);
+			test_assert(bignat_init(&expected, eds, n + 1) == 0);
+
+			test_assert(bignat_invert(&inv, x) == 0);
+			test_assert(bignat_eq(inv, expected));
+
+			bignat_del(x);
+			bignat_del(inv);
+			bignat_del(expected);
+		}
+	}
+	{
+		/* B^2n / (3 * B^(n - 1)) = floor(B^(n + 1) / 3) */
+		static uint32_t xds[1000], eds[1001];
+		bignat x, inv, expected;
+		for (size_t i = 0; i < countof(xds); i++) {
+			xds[i] = i == countof(xds) - 1 ? 3 : 0;
+		}
+		for (size_t i = 0; i < countof(eds); i++) {
+			eds[i] = 0x55555555;
+		}
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_invert(&inv, x) == 0);
+		test_assert(bignat_eq(inv, expected));
+
+		bignat_del(x);
+		bignat_del(inv);
+		bignat_del(expected);
+	}
 }
 
 void
@@ -1166,122 +3107,1501 @@ test_bignat_gcd(void)
 		test_assert(bignat_gcd(&gcd, x, y) == 0);
 		test_assert(bignat_eq(gcd, expected));
 
-		bignat_del(x);
-		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&y, 1) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 1) == 0);
+		test_assert(bignat_from_digit(&y, 0) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 12) == 0);
+		test_assert(bignat_from_digit(&y, 30) == 0);
+		test_assert(bignat_from_digit(&expected, 6) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 30) == 0);
+		test_assert(bignat_from_digit(&y, 12) == 0);
+		test_assert(bignat_from_digit(&expected, 6) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 3) == 0);
+		test_assert(bignat_from_digit(&y, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 7) == 0);
+		test_assert(bignat_from_digit(&y, 3) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 1) == 0);
+		test_assert(bignat_from_digit(&y, 5) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		test_assert(bignat_from_digit(&x, 5) == 0);
+		test_assert(bignat_from_digit(&y, 1) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		uint32_t xds[] = {
+				0xb33e2e10, 0xf510e921, 0x486ee575, 0xef460a25,
+				0x41497bbb, 0xa39e1a17, 0x00008a4b
+			},
+			yds[] = {
+				0xccfd0f99, 0x87fc462a, 0xb31752fc, 0x0baf2cc2,
+				0xaff17386, 0xa6fdb0d4, 0x00005578
+			},
+			eds[] = {1};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		uint32_t xds[] = {
+				0xb48938d3, 0x1e90382f, 0x17484d3d, 0x0102911f,
+				0x2132a2c8, 0xa77106bc, 0xe94c080a, 0xca698cbd,
+				0xb7eb2baa, 0xb9b8294e, 0xd7f559b0, 0x65ba08c6,
+				0x00004d33
+			},
+			yds[] = {
+				0x56724607, 0xa4e62797, 0xd7bef7ee, 0xbeec8003,
+				0xadaab8ec, 0x2f1d73eb, 0xfb4feec7, 0x4ed90675,
+				0xabed5b79, 0x0030bd84, 0x1983a026, 0x00a666ae
+			},
+			eds[] = {
+				0x9f767c45, 0x4164d839, 0xbde5c099, 0x00000005
+			};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		bignat x, y, gcd, expected;
+		uint32_t xds[] = {
+				0x00000000, 0x00000000, 0x224e34c0, 0xa40e0bed,
+				0xd2134f47, 0x40a447c5, 0x4ca8b200, 0xdc41af08,
+				0x530202a9, 0x9a632f7a, 0xfacaeab2, 0x6e0a53ad,
+				0xfd566c2e, 0x6e8231b5, 0x00134cd9
+			},
+			yds[] = {
+				0x00000000, 0x3eecf88a, 0x82c9b073, 0x7bcb8132,
+				0x0000000b
+			},
+			eds[] = {
+				0x00000000, 0x3eecf88a, 0x82c9b073, 0x7bcb8132,
+				0x0000000b
+			};
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(expected);
+	}
+	{
+		/* half-GCDを使う桁数 */
+		static uint32_t gds[500];
+		bignat f0, f1, t, g, x, y, one, gcd;
+		int err = 0;
+		for (size_t i = 0; i < countof(gds); i++) {
+			gds[i] = i * 0x9e3779b9 + 0x7f4a7c15;
+		}
+		test_assert(bignat_init(&g, gds, countof(gds)) == 0);
+		test_assert(bignat_from_digit(&one, 1) == 0);
+
+		/* 隣り合うFibonacci数は互いに素で、互除法の商がすべて1になる */
+		test_assert(bignat_from_digit(&f0, 0) == 0);
+		test_assert(bignat_from_digit(&f1, 1) == 0);
+		for (int i = 0; i < 25000 && err == 0; i++) {
+			err = bignat_add(&t, f0, f1);
+			bignat_del(f0);
+			f0 = f1;
+			f1 = t;
+		}
+		test_assert(err == 0);
+
+		test_assert(bignat_gcd(&gcd, f1, f0) == 0);
+		test_assert(bignat_eq(gcd, one));
+		bignat_del(gcd);
+
+		test_assert(bignat_mul(&x, f1, g) == 0);
+		test_assert(bignat_mul(&y, f0, g) == 0);
+		test_assert(bignat_gcd(&gcd, x, y) == 0);
+		test_assert(bignat_eq(gcd, g));
+		bignat_del(gcd);
+
+		test_assert(bignat_gcd(&gcd, y, x) == 0);
+		test_assert(bignat_eq(gcd, g));
+
+		bignat_del(f0);
+		bignat_del(f1);
+		bignat_del(g);
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(one);
+		bignat_del(gcd);
+	}
+}
+
+void
+test_bignat_gcdext(void)
+{
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&y, 0) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 0) == 0);
+		test_assert(bignat_from_digit(&expected_s, 0) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 5) == 0);
+		test_assert(bignat_from_digit(&y, 0) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 5) == 0);
+		test_assert(bignat_from_digit(&expected_s, 1) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 0) == 0);
+		test_assert(bignat_from_digit(&y, 7) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 7) == 0);
+		test_assert(bignat_from_digit(&expected_s, 0) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 12) == 0);
+		test_assert(bignat_from_digit(&y, 30) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 6) == 0);
+		test_assert(bignat_from_digit(&expected_s, 3) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 30) == 0);
+		test_assert(bignat_from_digit(&y, 12) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 6) == 0);
+		test_assert(bignat_from_digit(&expected_s, 1) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 240) == 0);
+		test_assert(bignat_from_digit(&y, 46) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 2) == 0);
+		test_assert(bignat_from_digit(&expected_s, 14) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 7) == 0);
+		test_assert(bignat_from_digit(&y, 1) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 1) == 0);
+		test_assert(bignat_from_digit(&expected_s, 0) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		bignat x, y, gcd, s, expected_gcd, expected_s;
+		test_assert(bignat_from_digit(&x, 0xffffffff) == 0);
+		test_assert(bignat_from_digit(&y, 0xfffffffe) == 0);
+		test_assert(bignat_from_digit(&expected_gcd, 1) == 0);
+		test_assert(bignat_from_digit(&expected_s, 1) == 0);
+
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, expected_gcd));
+		test_assert(bignat_eq(s, expected_s));
+
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(expected_gcd);
+		bignat_del(expected_s);
+	}
+	{
+		/* half-GCDを使う桁数 */
+		static uint32_t gds[500];
+		bignat f0, f1, t, g, x, y, gcd, s, prod, quot, rem;
+		int err = 0;
+		for (size_t i = 0; i < countof(gds); i++) {
+			gds[i] = i * 0x9e3779b9 + 0x7f4a7c15;
+		}
+		test_assert(bignat_init(&g, gds, countof(gds)) == 0);
+
+		test_assert(bignat_from_digit(&f0, 0) == 0);
+		test_assert(bignat_from_digit(&f1, 1) == 0);
+		for (int i = 0; i < 25000 && err == 0; i++) {
+			err = bignat_add(&t, f0, f1);
+			bignat_del(f0);
+			f0 = f1;
+			f1 = t;
+		}
+		test_assert(err == 0);
+		test_assert(bignat_mul(&x, f1, g) == 0);
+		test_assert(bignat_mul(&y, f0, g) == 0);
+
+		/* s * x mod y = gcd、s < y / gcd */
+		test_assert(bignat_gcdext(&gcd, &s, x, y) == 0);
+		test_assert(bignat_eq(gcd, g));
+		test_assert(bignat_mul(&prod, s, x) == 0);
+		test_assert(bignat_divmod(&quot, &rem, prod, y) == 0);
+		test_assert(bignat_eq(rem, g));
+		test_assert(bignat_lt(s, f0));
+
+		bignat_del(f0);
+		bignat_del(f1);
+		bignat_del(g);
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(gcd);
+		bignat_del(s);
+		bignat_del(prod);
+		bignat_del(quot);
+		bignat_del(rem);
+	}
+}
+
+void
+test_bignat_powm(void)
+{
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 4) == 0);
+		test_assert(bignat_from_digit(&exp, 13) == 0);
+		test_assert(bignat_from_digit(&mod, 497) == 0);
+		test_assert(bignat_from_digit(&expected, 445) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 2) == 0);
+		test_assert(bignat_from_digit(&exp, 10) == 0);
+		test_assert(bignat_from_digit(&mod, 1000) == 0);
+		test_assert(bignat_from_digit(&expected, 24) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 3) == 0);
+		test_assert(bignat_from_digit(&exp, 0) == 0);
+		test_assert(bignat_from_digit(&mod, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 0) == 0);
+		test_assert(bignat_from_digit(&exp, 0) == 0);
+		test_assert(bignat_from_digit(&mod, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 0) == 0);
+		test_assert(bignat_from_digit(&exp, 5) == 0);
+		test_assert(bignat_from_digit(&mod, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 5) == 0);
+		test_assert(bignat_from_digit(&exp, 3) == 0);
+		test_assert(bignat_from_digit(&mod, 1) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm;
+		test_assert(bignat_from_digit(&base, 3) == 0);
+		test_assert(bignat_from_digit(&exp, 2) == 0);
+		test_assert(bignat_from_digit(&mod, 0) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == EDOM);
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x00000003
+			},
+			eds[] = {
+				0xfffffffe, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			mds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			rds[] = {
+				0x00000001
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x9f767c45, 0x4164d839, 0xbde5c099, 0x5bc8fbbc,
+				0xcb91ce37, 0xb0c11fde, 0x000000f1
+			},
+			eds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			mds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			rds[] = {
+				0x369a18b3, 0xa2e717f7, 0xbde5c27c, 0x5bc8fbbc
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x00000003
+			},
+			eds[] = {
+				0xfffffffe, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			mds[] = {
+				0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff
+			},
+			rds[] = {
+				0x00000001
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0xd76d4331, 0xbd69fe29, 0xa6eb8c9e, 0xec1d7da0,
+				0x87b0b125, 0x076ce2ef, 0xd7210dff, 0x77330bdb,
+				0xc6a53877, 0x00000f17
+			},
+			eds[] = {
+				0x00000001, 0x00000000, 0x00000001
+			},
+			mds[] = {
+				0x00000000, 0x00000000, 0x00000000, 0x00000001
+			},
+			rds[] = {
+				0xd76d4331, 0xbd69fe29, 0x002edc4e
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x3fc1ea37, 0xa6233255, 0x0d464138, 0xe6a16a3b,
+				0x2827688d, 0x1cfb10f6, 0x5f2dd97f, 0x7814e8a2,
+				0xde527100, 0x3f1f65a8, 0x617959ce, 0x8b33e968,
+				0x1a1afe87, 0x92edcf45, 0x3fd42359, 0x035b7399,
+				0xbb2edb20, 0x377b9aa2, 0x687c966c, 0x478c281d,
+				0x2e9c82b1, 0xea959c21, 0xde11cc9d, 0xc4069545,
+				0x63b229f1, 0x28dbd25e, 0xc30d8b76, 0xcc11d357,
+				0x126a1e48, 0x238642ea, 0x9e30691c, 0x0000009e
+			},
+			eds[] = {
+				0x71e0c07e, 0x206f5c66, 0x21da8978, 0x00745130,
+				0xf8eb18b9, 0xdf1461aa, 0x015c33b2, 0x359eeefb,
+				0xc60a3cab, 0x3729c619, 0xf5cae3bf, 0xfb7ff337,
+				0x2a759159, 0xdf561d80, 0x2a9eba0c, 0x4a0fe75d,
+				0x504b74ba, 0xf6236bf2, 0x32ea6928, 0x8a0a8c96,
+				0xe049548e, 0xad864c44, 0xa02fdaa1, 0x346c6e2b,
+				0x2e81d66d, 0xf0e3cd97, 0xf7f35634, 0xb0cde917,
+				0x3266aa3b, 0xf770c226, 0xf7108e96, 0x000000e4
+			},
+			mds[] = {
+				0x621aef57, 0x4c7d6df0, 0x0585a01c, 0x5c76f18a,
+				0x6a375391, 0x2a7c1880, 0xef901b93, 0x254cb864,
+				0x43892dfc, 0x10acff00, 0x54f46a69, 0x4d25deb3,
+				0xd1412584, 0x9a656aaf, 0x960d5a8f, 0x00ddb74d,
+				0x98921396, 0xad8d194a, 0xb52a43ab, 0x568068b9,
+				0x10e6d8e6, 0x4f596727, 0x5af84e6b, 0xd18a669a,
+				0x4e5a3a26, 0x7b121dc5, 0xb2489191, 0x50d7d13f,
+				0x2f4d4c86, 0x7b3120df, 0x78f845f5, 0x000000b4
+			},
+			rds[] = {
+				0x3aa22846, 0xf76d7dc3, 0x151a1e54, 0x91dc217c,
+				0x0543d2bb, 0x540c0cfe, 0x8897b51e, 0xf56e1338,
+				0x2fd5a75b, 0x16550597, 0xba6008c6, 0xe3d71813,
+				0x4a496b3d, 0x0f9447f7, 0x3153a95b, 0x2474bb03,
+				0xb94950ac, 0x6b968106, 0x66ba4c42, 0xe8e0ec1d,
+				0xc7461454, 0x33156223, 0x03b4e5c6, 0x920c1ddc,
+				0xce3f0e98, 0xc9ede4e2, 0xaca95fa3, 0xffe9b21a,
+				0x11c5e9da, 0xe6fff835, 0xddb02e46, 0x0000000c
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x2d1634b4, 0x0e979cf3, 0x419521fe, 0xf9a01fe8,
+				0xf06313ff, 0x05da8467, 0xf3001cee, 0xbff29101,
+				0x5b8e8fb2, 0xd84a1d3a, 0x677fd139, 0x04a012e8,
+				0x8c8f95ef, 0xc9a937a6, 0x6b384309, 0x5dbe4409,
+				0x60597bdc, 0x9419cf4d, 0xd75b1e24, 0x0252f615,
+				0x73ec28d0, 0x0bf64ef7, 0xb52fa53c, 0x2e50bd4e,
+				0x9faba827, 0xf486ab73, 0xf453324e, 0x324f3e81,
+				0x1e782196, 0xc177f113, 0x3eff8b3f, 0x000000ed
+			},
+			eds[] = {
+				0xd1ca4dc4, 0xf129c8c6, 0x76531737, 0x58296818,
+				0x8332f05a, 0x5ad3ba32, 0xe488b6c8, 0x8652dbd0,
+				0x403a960a, 0xc68deb5d, 0x767d5274, 0x1ba95a54,
+				0x96fabb7b, 0xbf9703c0, 0xc7eec61b, 0xcc170c31,
+				0x5e0730b3, 0xdc14ed57, 0x4bbdbb01, 0x0960afe9,
+				0x6ed78f5d, 0x0f21ff5e
+			},
+			mds[] = {
+				0xfa749692, 0x1757905e, 0x355f2af4, 0x573ac59a,
+				0x834c1b69, 0x9c5f319e, 0x5cd5061c, 0xeb07c30d,
+				0x25f02628, 0x57079670, 0x4692ba03, 0xec983704,
+				0xb3de08f9, 0x8b8e8f4e, 0x17921e6c, 0x4ffcbf42,
+				0xaf9b74f8, 0x5119cdcc, 0x4e613a36, 0x2d6f2efc,
+				0xcc7c6d81, 0x1404ab1e, 0xa07657d6, 0x261c374b,
+				0xb89c4e56, 0xb06dbee0, 0x4f2e84fc, 0xff297d0e,
+				0x7bd9e8a1, 0x2959fea3, 0xb85a5cd2, 0x0000008c
+			},
+			rds[] = {
+				0xd32e9b88, 0x953ba715, 0x09e17ff4, 0xcd4d44af,
+				0x6341f43b, 0x0b0509bf, 0x10fd42a6, 0xb77ca755,
+				0x95d03f94, 0x37527fce, 0x1708624f, 0x5eb0914d,
+				0xa49060d6, 0x965e229d, 0x2e222270, 0x3964d033,
+				0x811a2c2c, 0x921427c4, 0x790f7b51, 0x7f8fadf0,
+				0x9224f41b, 0x7000c5ae, 0x8099f03c, 0x8cedfa69,
+				0x66f6b654, 0x8f79ff9d, 0xbc23dfbd, 0x0dbff8d1,
+				0x00ccf35f, 0x769a071a, 0xba218f5f, 0x00000003
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		/* 確保の回数は指数の長さ(乗算の回数)によらない */
+		static const size_t ns[] = {32, 64, 128};
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		};
+		bignum_set_allocator(&a);
+
+		for (size_t k = 0; k < 2 * countof(ns); k++) {
+			size_t n = ns[k / 2];
+			uint32_t ds[128];
+			for (size_t i = 0; i < n; i++) {
+				ds[i] = (uint32_t)(i * 2654435761u + 3);
+			}
+			/* 奇数と偶数の法 */
+			ds[0] = k % 2 == 0 ? ds[0] | 1 : ds[0] & ~(uint32_t)1;
+
+			bignat base, exp, mod, powm;
+			test_assert(bignat_init(&mod, ds, n) == 0);
+			test_assert(bignat_init(&base, ds + 1, n - 1) == 0);
+
+			size_t counts[2];
+			for (size_t j = 0; j < 2; j++) {
+				test_assert(bignat_init(&exp, ds + 1,
+							j == 0 ? 2 : n - 1) ==
+					    0);
+				size_t nallocs = st.nallocs;
+				test_assert(bignat_powm(&powm, base, exp, mod) ==
+					    0);
+				counts[j] = st.nallocs - nallocs;
+				bignat_del(exp);
+				bignat_del(powm);
+			}
+			test_assert(counts[0] == counts[1]);
+
+			bignat_del(base);
+			bignat_del(mod);
+		}
+
+		dgtvec_flush_cache();
+		bignum_set_allocator(NULL);
+		test_assert(st.live == 0);
+		test_assert(st.nmismatches == 0);
+	}
+}
+
+void
+test_bignat_powm_sec(void)
+{
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 4) == 0);
+		test_assert(bignat_from_digit(&exp, 13) == 0);
+		test_assert(bignat_from_digit(&mod, 497) == 0);
+		test_assert(bignat_from_digit(&expected, 445) == 0);
+
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 3) == 0);
+		test_assert(bignat_from_digit(&exp, 0) == 0);
+		test_assert(bignat_from_digit(&mod, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 1) == 0);
+
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 0) == 0);
-		test_assert(bignat_from_digit(&y, 1) == 0);
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 0) == 0);
+		test_assert(bignat_from_digit(&exp, 0) == 0);
+		test_assert(bignat_from_digit(&mod, 7) == 0);
 		test_assert(bignat_from_digit(&expected, 1) == 0);
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
 
-		bignat_del(x);
-		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 1) == 0);
-		test_assert(bignat_from_digit(&y, 0) == 0);
-		test_assert(bignat_from_digit(&expected, 1) == 0);
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 0) == 0);
+		test_assert(bignat_from_digit(&exp, 5) == 0);
+		test_assert(bignat_from_digit(&mod, 7) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
 
-		bignat_del(x);
-		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 12) == 0);
-		test_assert(bignat_from_digit(&y, 30) == 0);
-		test_assert(bignat_from_digit(&expected, 6) == 0);
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 5) == 0);
+		test_assert(bignat_from_digit(&exp, 3) == 0);
+		test_assert(bignat_from_digit(&mod, 1) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
 
-		bignat_del(x);
-		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 30) == 0);
-		test_assert(bignat_from_digit(&y, 12) == 0);
-		test_assert(bignat_from_digit(&expected, 6) == 0);
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 5) == 0);
+		test_assert(bignat_from_digit(&exp, 0) == 0);
+		test_assert(bignat_from_digit(&mod, 1) == 0);
+		test_assert(bignat_from_digit(&expected, 0) == 0);
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
 
-		bignat_del(x);
-		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 3) == 0);
-		test_assert(bignat_from_digit(&y, 7) == 0);
-		test_assert(bignat_from_digit(&expected, 1) == 0);
+		bignat base, exp, mod, powm, expected;
+		test_assert(bignat_from_digit(&base, 4294967295) == 0);
+		test_assert(bignat_from_digit(&exp, 4294967295) == 0);
+		test_assert(bignat_from_digit(&mod, 4294967291) == 0);
+		test_assert(bignat_from_digit(&expected, 1024) == 0);
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
 
-		bignat_del(x);
-		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 7) == 0);
-		test_assert(bignat_from_digit(&y, 3) == 0);
-		test_assert(bignat_from_digit(&expected, 1) == 0);
+		bignat base, exp, mod, powm;
+		test_assert(bignat_from_digit(&base, 3) == 0);
+		test_assert(bignat_from_digit(&exp, 2) == 0);
+		test_assert(bignat_from_digit(&mod, 0) == 0);
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == EDOM);
 
-		bignat_del(x);
-		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+	}
+	{
+		bignat base, exp, mod, powm;
+		test_assert(bignat_from_digit(&base, 3) == 0);
+		test_assert(bignat_from_digit(&exp, 2) == 0);
+		test_assert(bignat_from_digit(&mod, 1000) == 0);
+
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == EDOM);
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x00000003
+			},
+			eds[] = {
+				0xfffffffe, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			mds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			rds[] = {
+				0x00000001
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
 		bignat_del(expected);
 	}
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 1) == 0);
-		test_assert(bignat_from_digit(&y, 5) == 0);
-		test_assert(bignat_from_digit(&expected, 1) == 0);
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0xcb1855fe, 0x92e5dfe8, 0xd26b9496, 0x14a03569,
+				0x7c2b3abe, 0xc320a473, 0x00000042
+			},
+			eds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			mds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			rds[] = {
+				0xc36ecb7a, 0x192728cf, 0xd26b951c, 0x14a03569
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x096d3737, 0x001d9a88, 0x254499c7, 0xa9ae7a34,
+				0x9623d7cf, 0x78629522, 0xf72c2c26, 0xc27db4ec,
+				0xbc1e3ac1, 0x5f877031, 0x51c34250, 0xc527e279,
+				0x059a91e1, 0x45cf8aa4, 0x7d24b396, 0xcd4a5557,
+				0x32b7228f, 0xbad5ccc2, 0xdf5ca32e, 0x69fc5360,
+				0xe91b4ad1, 0x89ce5ef7, 0x8a0c5100, 0xae9af169,
+				0x181e290a, 0x316774fe, 0x903c2ac9, 0x8db9b92c,
+				0xb313fc7e, 0xce1c9c17, 0xba98666a, 0x00000043
+			},
+			eds[] = {
+				0xa9b3d1a2, 0xcda95957, 0x9c2c0ac2, 0xaf895f5b,
+				0x168e5087, 0xd822e2f9, 0x6cb9185e, 0x55e8b3eb,
+				0xfd802060, 0x17d7ab26, 0x5cb53ec0, 0xccdf540b,
+				0x68f22599, 0xce06294d, 0x401fe4fc, 0x71f970cf,
+				0xb31a5bf3, 0x1801fd9a, 0xc16cf5c5, 0x32793637,
+				0xb3642b19, 0xa28a0aaa, 0xcbe19514, 0x4a8b0188,
+				0x18f918e2, 0xf38d2e64, 0x0bb1e330, 0x96ac828f,
+				0xe71b8703, 0x336c7fcd, 0xd3f18766, 0x000000a7
+			},
+			mds[] = {
+				0xe9a51fb3, 0x5c41d5c5, 0x7c9881b1, 0xeec7ddb5,
+				0xd52d5759, 0xe8d5b9e3, 0x3197d4e2, 0x83c02da8,
+				0x936d0e1e, 0xa502a86a, 0xf8540d95, 0xb2aa40b4,
+				0xe474e007, 0xce359204, 0x80f1de02, 0xf9f3b65b,
+				0xea9238eb, 0x0746a9ba, 0xa22ba4d7, 0x5c832a51,
+				0x3eb17c27, 0x9a0c1b76, 0x6e001281, 0x4de8344e,
+				0x5b7d3b0f, 0x96d2f9e0, 0x1e9d19e7, 0x16f5c1ee,
+				0x800a4c94, 0xe14cd8df, 0xadb9ce1b, 0x00000086
+			},
+			rds[] = {
+				0x070e7146, 0xaa938d60, 0x42d9b0a0, 0xd01f843e,
+				0xfe693073, 0xa2671d1c, 0x2d043083, 0x64642f58,
+				0x4b222387, 0xc2dfa6be, 0x26b6a60d, 0x8eb1b0d3,
+				0xe98f3b3a, 0xb5caae5a, 0x1207ced6, 0xe1017418,
+				0xc1f93de0, 0xc6cad763, 0x84082ce6, 0x5af652db,
+				0x71931359, 0xd5ef79c8, 0x8133d786, 0x90913ef6,
+				0x894322e6, 0xe055dbd9, 0x81ffca15, 0x99b6ac86,
+				0x4a0b3f68, 0x320231dd, 0xca2e69ae, 0x00000078
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+	{
+		bignat base, exp, mod, powm, expected;
+		uint32_t bds[] = {
+				0x32f9e2b0, 0x1de83405, 0x9bb38b9c, 0xa9a967c1,
+				0x44941663, 0x4ff1a001, 0xb8109a54, 0x323bbeaf,
+				0x613b030a, 0x7bd6aa42, 0x390567c2, 0x235ae280,
+				0x98eb7bce, 0x35bb0a85, 0xd581460b, 0xdd93fa0c,
+				0xe0408802, 0xb2beca81, 0x85ab0090, 0x0334b01b,
+				0x3051b390, 0xc72ec6f0, 0x2b4cf14c, 0x045df64a,
+				0xa5e27d6e, 0x5539b994, 0x8ec86d6c, 0xe7893d2b,
+				0xabddfcd9, 0x9ec9b42f, 0x9e5dc598, 0x4e5e2d41,
+				0x5fe7e49d, 0x609d99cc, 0x8701f8ad, 0x63a05b05,
+				0x4a05ae87, 0x20783d88, 0xadc1383d, 0xfff80b3b,
+				0x7d1f3b5c, 0x0dc749b0, 0x2f730730, 0x6c426e40,
+				0x980bcb4c, 0xbf0e5eee, 0x0ff9264f
+			},
+			eds[] = {
+				0x65d3e198, 0x18923f65, 0xfb2114c0, 0x70f5fafe,
+				0x3eccb44d, 0xce400e5a, 0xfab0861c, 0x16cc725c,
+				0xe46af459, 0x000009a6
+			},
+			mds[] = {
+				0xab935923, 0xded773c7, 0xe3b71827, 0x72346c38,
+				0x727b5109, 0xc8ae360c, 0xd4cd6c70, 0x6148e544,
+				0xcbcd2231, 0x13939704, 0x844593c9, 0x6d29e99b,
+				0x788edb0f, 0x4dafab5e, 0xb4a6fbe1, 0x000d1084
+			},
+			rds[] = {
+				0xdd55d6f2, 0xa0e0cff4, 0x1fcd6d43, 0x764f5874,
+				0x02175f95, 0x7276caf3, 0xbe425c69, 0xb7ea0d5b,
+				0x3db78dfb, 0x9bed94e5, 0xa996e62e, 0xaa7ad770,
+				0xb065ad8a, 0xa3c9a5a3, 0x4b0299ec, 0x0000629f
+			};
+		test_assert(bignat_init(&base, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&exp, eds, countof(eds)) == 0);
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&expected, rds, countof(rds)) == 0);
+
+		test_assert(bignat_powm_sec(&powm, base, exp, mod) == 0);
+		test_assert(bignat_eq(powm, expected));
+
+		bignat_del(base);
+		bignat_del(exp);
+		bignat_del(mod);
+		bignat_del(powm);
+		bignat_del(expected);
+	}
+}
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+void
+test_bignat_mont(void)
+{
+	{
+		bignat_mont_ctx ctx;
+		bignat mod = bignat_new_zero();
+
+		test_assert(bignat_mont_init(&ctx, mod) == EDOM);
+	}
+	{
+		bignat_mont_ctx ctx;
+		bignat mod;
+		test_assert(bignat_from_digit(&mod, 10) == 0);
+
+		test_assert(bignat_mont_init(&ctx, mod) == EDOM);
+
+		bignat_del(mod);
+	}
+	{
+		bignat_mont_ctx ctx;
+		bignat mod, x, y, big, expected;
+		bignat mx = bignat_new_zero();
+		bignat my = bignat_new_zero();
+		bignat mprod = bignat_new_zero();
+		bignat out = bignat_new_zero();
+		uint32_t mds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			xds[] = {
+				0xf71a1bfc, 0x357fbc5a, 0x02fbcd4f, 0x215d4188
+			},
+			yds[] = {
+				0xbc69f265, 0x0942dc06, 0x28738582, 0x3a6ed19a
+			},
+			bds[] = {
+				0xfc80be13, 0x3d2bd371, 0x04524a7c, 0x0e111600,
+				0xe12656f1, 0xce0c3f08, 0xae6cff55, 0x25b2116a,
+				0xdb7aca58, 0x00000b1d
+			},
+			mxds[] = {
+				0xee3437f8, 0x6aff78b5, 0x05f79a9e, 0x42ba8310
+			},
+			pds[] = {
+				0x00e40fd1, 0x74b27b16, 0xc32ecfb4, 0x419e6fa7
+			},
+			sds[] = {
+				0xf63603ed, 0x645b5500, 0xb6f97398, 0x0da916bc
+			},
+			bmds[] = {
+				0x2cb89555, 0xd9447dfb, 0x612c4927, 0x597538d5
+			};
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&big, bds, countof(bds)) == 0);
+		test_assert(bignat_mont_init(&ctx, mod) == 0);
+
+		test_assert(bignat_mont_to(&mx, x, &ctx) == 0);
+		test_assert(bignat_init(&expected, mxds, countof(mxds)) == 0);
+		test_assert(bignat_eq(mx, expected));
+		bignat_del(expected);
+
+		test_assert(bignat_mont_from(&out, mx, &ctx) == 0);
+		test_assert(bignat_eq(out, x));
+
+		test_assert(bignat_mont_to(&my, y, &ctx) == 0);
+		test_assert(bignat_mont_mul(&mprod, mx, my, &ctx) == 0);
+		test_assert(bignat_mont_from(&out, mprod, &ctx) == 0);
+		test_assert(bignat_init(&expected, pds, countof(pds)) == 0);
+		test_assert(bignat_eq(out, expected));
+		bignat_del(expected);
+
+		test_assert(bignat_mont_sqr(&mprod, mx, &ctx) == 0);
+		test_assert(bignat_mont_from(&out, mprod, &ctx) == 0);
+		test_assert(bignat_init(&expected, sds, countof(sds)) == 0);
+		test_assert(bignat_eq(out, expected));
+		bignat_del(expected);
+
+		/* 法以上の値は剰余を取って変換する */
+		test_assert(bignat_mont_to(&mprod, big, &ctx) == 0);
+		test_assert(bignat_mont_from(&out, mprod, &ctx) == 0);
+		test_assert(bignat_init(&expected, bmds, countof(bmds)) == 0);
+		test_assert(bignat_eq(out, expected));
+		bignat_del(expected);
 
+		test_assert(bignat_mont_mul(&mprod, mx, big, &ctx) == EDOM);
+		test_assert(bignat_mont_sqr(&mprod, mod, &ctx) == EDOM);
+		test_assert(bignat_mont_from(&out, mod, &ctx) == EDOM);
+
+		bignat_del(mod);
+		bignat_del(x);
+		bignat_del(y);
+		bignat_del(big);
+		bignat_del(mx);
+		bignat_del(my);
+		bignat_del(mprod);
+		bignat_del(out);
+		bignat_mont_del(ctx);
+	}
+	{
+		/* 結果の領域を再利用し、入力と同じ書き込み先も許す */
+		bignat_mont_ctx ctx;
+		bignat mod, x, y, expected;
+		bignat acc = bignat_new_zero();
+		bignat my = bignat_new_zero();
+		uint32_t *digits;
+		uint32_t mds[] = {
+				0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+			},
+			xds[] = {
+				0xf71a1bfc, 0x357fbc5a, 0x02fbcd4f, 0x215d4188
+			},
+			yds[] = {
+				0xbc69f265, 0x0942dc06, 0x28738582, 0x3a6ed19a
+			},
+			eds[] = {
+				0x886e7c6c, 0x9af67a6a, 0xd04000c4, 0x04ef5a8d
+			};
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+		test_assert(bignat_mont_init(&ctx, mod) == 0);
+
+		test_assert(bignat_mont_to(&acc, x, &ctx) == 0);
+		test_assert(bignat_mont_to(&my, y, &ctx) == 0);
+		digits = acc.digits;
+		for (int i = 0; i < 10; i++) {
+			test_assert(bignat_mont_mul(&acc, acc, my, &ctx) == 0);
+		}
+		test_assert(acc.digits == digits);
+		test_assert(bignat_mont_from(&acc, acc, &ctx) == 0);
+		test_assert(bignat_eq(acc, expected));
+
+		bignat_del(mod);
 		bignat_del(x);
 		bignat_del(y);
-		bignat_del(gcd);
 		bignat_del(expected);
+		bignat_del(acc);
+		bignat_del(my);
+		bignat_mont_del(ctx);
+	}
+	{
+		/* Karatsuba法以上の桁数でも乗算と平方で領域を確保しない */
+		static const size_t ns[] = {32, 64, 128};
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		};
+		bignum_set_allocator(&a);
+
+		for (size_t k = 0; k < countof(ns); k++) {
+			size_t n = ns[k];
+			uint32_t ds[3][128];
+			for (size_t i = 0; i < n; i++) {
+				ds[0][i] = (uint32_t)(i * 2654435761u + 1);
+				ds[1][i] = (uint32_t)(i * 2246822519u + 7);
+				ds[2][i] = (uint32_t)(i * 3266489917u + 3);
+			}
+			ds[0][0] |= 1;
+
+			bignat_mont_ctx ctx;
+			bignat mod, x, y, prod, q, expected;
+			bignat mx = bignat_new_zero();
+			bignat my = bignat_new_zero();
+			bignat out = bignat_new_zero();
+			test_assert(bignat_init(&mod, ds[0], n) == 0);
+			test_assert(bignat_init(&x, ds[1], n - 1) == 0);
+			test_assert(bignat_init(&y, ds[2], n - 1) == 0);
+			test_assert(bignat_mont_init(&ctx, mod) == 0);
+			test_assert(bignat_mont_to(&mx, x, &ctx) == 0);
+			test_assert(bignat_mont_to(&my, y, &ctx) == 0);
+
+			/* 結果の領域を確保しておく */
+			test_assert(bignat_mont_mul(&out, mx, my, &ctx) == 0);
+			size_t nallocs = st.nallocs;
+			for (int i = 0; i < 4; i++) {
+				test_assert(bignat_mont_mul(&out, out, my,
+							    &ctx) == 0);
+				test_assert(bignat_mont_sqr(&out, out,
+							    &ctx) == 0);
+			}
+			test_assert(st.nallocs == nallocs);
+
+			/* 同じ値を通常の演算で求めて比べる */
+			test_assert(bignat_mul(&prod, x, y) == 0);
+			for (int i = 0; i < 4; i++) {
+				test_assert(bignat_mul_into(&prod, prod,
+							    y) == 0);
+				test_assert(bignat_divmod(&q, &expected, prod,
+							  mod) == 0);
+				bignat_del(q);
+				bignat_del(prod);
+				test_assert(bignat_sqr(&prod, expected) == 0);
+				bignat_del(expected);
+			}
+			test_assert(bignat_divmod(&q, &expected, prod,
+						  mod) == 0);
+			test_assert(bignat_mont_from(&out, out, &ctx) == 0);
+			test_assert(bignat_eq(out, expected));
+
+			bignat_del(mod);
+			bignat_del(x);
+			bignat_del(y);
+			bignat_del(prod);
+			bignat_del(q);
+			bignat_del(expected);
+			bignat_del(mx);
+			bignat_del(my);
+			bignat_del(out);
+			bignat_mont_del(ctx);
+		}
+
+		dgtvec_flush_cache();
+		bignum_set_allocator(NULL);
+		test_assert(st.live == 0);
+		test_assert(st.nmismatches == 0);
 	}
+}
+
+void
+test_bignat_barrett(void)
+{
 	{
-		bignat x, y, gcd, expected;
-		test_assert(bignat_from_digit(&x, 5) == 0);
-		test_assert(bignat_from_digit(&y, 1) == 0);
-		test_assert(bignat_from_digit(&expected, 1) == 0);
+		bignat_barrett_ctx ctx;
+		bignat mod = bignat_new_zero();
+
+		test_assert(bignat_barrett_init(&ctx, mod) == EDOM);
+	}
+	{
+		bignat_barrett_ctx ctx;
+		bignat mod, x, y, big, expected;
+		bignat rem = bignat_new_zero();
+		uint32_t mds[] = {
+				0x5c8cc1aa, 0x781ef86f, 0x7b00c7f4, 0xc8f165d5
+			},
+			xds[] = {
+				0x6abd685a, 0x3a0562d5, 0x725ed09d
+			},
+			yds[] = {
+				0x68d605d4, 0xdaa8b2a6, 0xa85f68b6, 0xb6043106,
+				0x424458b6, 0x3ce44e27, 0xa28f17d8, 0x00e3c4b6
+			},
+			bds[] = {
+				0x0297c5e5, 0x4bedce03, 0x4d52bc61, 0xd09e0492,
+				0x55c6b62b, 0xaaadd6b8, 0x2456de76, 0xf3a16071,
+				0xbe506564, 0x9a23bef7, 0x4f634127, 0x05adb3fc,
+				0xca0bc36c, 0x3868e6d9, 0xf4c9da65, 0x0009a508
+			},
+			eyds[] = {
+				0xb3ea1506, 0xa80ec322, 0x2e6cfa9e, 0x57119b8d
+			},
+			ebds[] = {
+				0x4de6503b, 0x9590fad4, 0xe2b4c5fd, 0x80648328
+			};
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&x, xds, countof(xds)) == 0);
+		test_assert(bignat_init(&y, yds, countof(yds)) == 0);
+		test_assert(bignat_init(&big, bds, countof(bds)) == 0);
+		test_assert(bignat_barrett_init(&ctx, mod) == 0);
 
-		test_assert(bignat_gcd(&gcd, x, y) == 0);
-		test_assert(bignat_eq(gcd, expected));
+		/* 法未満の値はそのまま */
+		test_assert(bignat_barrett_reduce(&rem, x, &ctx) == 0);
+		test_assert(bignat_eq(rem, x));
+
+		test_assert(bignat_barrett_reduce(&rem, mod, &ctx) == 0);
+		test_assert(rem.ndigits == 0);
+
+		test_assert(bignat_barrett_reduce(&rem, y, &ctx) == 0);
+		test_assert(bignat_init(&expected, eyds, countof(eyds)) == 0);
+		test_assert(bignat_eq(rem, expected));
+		bignat_del(expected);
+
+		/* 法の2倍の桁数を超える値 */
+		test_assert(bignat_barrett_reduce(&rem, big, &ctx) == 0);
+		test_assert(bignat_init(&expected, ebds, countof(ebds)) == 0);
+		test_assert(bignat_eq(rem, expected));
+		bignat_del(expected);
 
+		bignat_del(mod);
 		bignat_del(x);
 		bignat_del(y);
-		bignat_del(gcd);
+		bignat_del(big);
+		bignat_del(rem);
+		bignat_barrett_del(ctx);
+	}
+	{
+		/* 結果の領域を再利用し、入力と同じ書き込み先も許す */
+		bignat_barrett_ctx ctx;
+		bignat mod, x, expected;
+		uint32_t *digits;
+		uint32_t mds[] = {
+				0x5c8cc1aa, 0x781ef86f, 0x7b00c7f4, 0xc8f165d5
+			},
+			bds[] = {
+				0x0297c5e5, 0x4bedce03, 0x4d52bc61, 0xd09e0492,
+				0x55c6b62b, 0xaaadd6b8, 0x2456de76, 0xf3a16071,
+				0xbe506564, 0x9a23bef7, 0x4f634127, 0x05adb3fc,
+				0xca0bc36c, 0x3868e6d9, 0xf4c9da65, 0x0009a508
+			},
+			eds[] = {
+				0x4de6503b, 0x9590fad4, 0xe2b4c5fd, 0x80648328
+			};
+		test_assert(bignat_init(&mod, mds, countof(mds)) == 0);
+		test_assert(bignat_init(&x, bds, countof(bds)) == 0);
+		test_assert(bignat_init(&expected, eds, countof(eds)) == 0);
+		test_assert(bignat_barrett_init(&ctx, mod) == 0);
+		digits = x.digits;
+
+		test_assert(bignat_barrett_reduce(&x, x, &ctx) == 0);
+		test_assert(bignat_eq(x, expected));
+		test_assert(x.digits == digits);
+
+		test_assert(bignat_barrett_reduce(&x, x, &ctx) == 0);
+		test_assert(bignat_eq(x, expected));
+		test_assert(x.digits == digits);
+
+		bignat_del(mod);
+		bignat_del(x);
 		bignat_del(expected);
+		bignat_barrett_del(ctx);
+	}
+	{
+		/* Karatsuba法以上の桁数でも剰余で領域を確保しない */
+		static const size_t ns[] = {32, 64, 128};
+		struct alloc_stat st = {0};
+		bignum_allocator a = {
+			.alloc=tracking_alloc,
+			.realloc=tracking_realloc,
+			.free=tracking_free,
+			.ctx=&st
+		};
+		bignum_set_allocator(&a);
+
+		for (size_t k = 0; k < countof(ns); k++) {
+			size_t n = ns[k];
+			uint32_t mds[128], xds[256];
+			for (size_t i = 0; i < n; i++) {
+				mds[i] = (uint32_t)(i * 2654435761u + 2);
+			}
+			for (size_t i = 0; i < 2 * n; i++) {
+				xds[i] = (uint32_t)(i * 2246822519u + 7);
+			}
+			mds[0] &= ~(uint32_t)1;
+
+			bignat_barrett_ctx ctx;
+			bignat mod, x, q, expected;
+			bignat rem = bignat_new_zero();
+			test_assert(bignat_init(&mod, mds, n) == 0);
+			test_assert(bignat_init(&x, xds, 2 * n) == 0);
+			test_assert(bignat_barrett_init(&ctx, mod) == 0);
+			test_assert(bignat_divmod(&q, &expected, x, mod) == 0);
+
+			test_assert(bignat_barrett_reduce(&rem, x, &ctx) == 0);
+			size_t nallocs = st.nallocs;
+			for (int i = 0; i < 4; i++) {
+				test_assert(bignat_barrett_reduce(&rem, x,
+								  &ctx) == 0);
+			}
+			test_assert(st.nallocs == nallocs);
+			test_assert(bignat_eq(rem, expected));
+
+			bignat_del(mod);
+			bignat_del(x);
+			bignat_del(q);
+			bignat_del(expected);
+			bignat_del(rem);
+			bignat_barrett_del(ctx);
+		}
+
+		dgtvec_flush_cache();
+		bignum_set_allocator(NULL);
+		test_assert(st.live == 0);
+		test_assert(st.nmismatches == 0);
 	}
 }
 
@@ -1459,6 +4779,153 @@ test_bigint_copy(void)
 	}
 }
 
+void
+test_bigint_from_str(void)
+{
+	{
+		bigint n;
+		test_assert(bigint_from_str(&n, "-123", 10) == 0);
+		test_assert(n.sign == -1);
+		test_assert(n.abs.ndigits == 1);
+		test_assert(n.abs.digits[0] == 123);
+		bigint_del(n);
+	}
+	{
+		bigint n;
+		test_assert(bigint_from_str(&n, "+ff", 16) == 0);
+		test_assert(n.sign == 1);
+		test_assert(n.abs.ndigits == 1);
+		test_assert(n.abs.digits[0] == 255);
+		bigint_del(n);
+	}
+	{
+		bigint n;
+		test_assert(bigint_from_str(&n, "-4294967296", 10) == 0);
+		test_assert(n.sign == -1);
+		test_assert(n.abs.ndigits == 2);
+		test_assert(n.abs.digits[0] == 0);
+		test_assert(n.abs.digits[1] == 1);
+		bigint_del(n);
+	}
+	{
+		bigint n;
+		test_assert(bigint_from_str(&n, "-0", 10) == 0);
+		test_assert(n.sign == 0);
+		test_assert(n.abs.ndigits == 0);
+		bigint_del(n);
+	}
+	{
+		bigint n;
+		test_assert(bigint_from_strn(&n, "-12-", 3, 10) == 0);
+		test_assert(n.sign == -1);
+		test_assert(n.abs.ndigits == 1);
+		test_assert(n.abs.digits[0] == 12);
+		bigint_del(n);
+	}
+	{
+		bigint n;
+		test_assert(bigint_from_str(&n, "", 10) == EINVAL);
+		test_assert(bigint_from_str(&n, "-", 10) == EINVAL);
+		test_assert(bigint_from_str(&n, "--1", 10) == EINVAL);
+		test_assert(bigint_from_str(&n, "+-1", 10) == EINVAL);
+		test_assert(bigint_from_str(&n, "1-", 10) == EINVAL);
+	}
+}
+
+void
+test_bigint_to_str(void)
+{
+	{
+		bigint n = bigint_new_zero();
+		char str[2];
+		test_assert(bigint_str_size(n, 10) == 2);
+		test_assert(bigint_to_str(str, sizeof(str), n, 10) == 0);
+		test_assert(strcmp(str, "0") == 0);
+	}
+	{
+		bigint n;
+		char str[40];
+		test_assert(bigint_from_str(&n, "-4294967296", 10) == 0);
+		test_assert(bigint_to_str(str, sizeof(str), n, 10) == 0);
+		test_assert(strcmp(str, "-4294967296") == 0);
+		test_assert(bigint_to_str(str, sizeof(str), n, 16) == 0);
+		test_assert(strcmp(str, "-100000000") == 0);
+		test_assert(bigint_to_str(str, bigint_str_size(n, 10) - 1, n,
+					  10) == ERANGE);
+		test_assert(bigint_to_str(str, sizeof(str), n, 0) == EINVAL);
+		bigint_del(n);
+	}
+	{
+		bigint n;
+		char str[40];
+		test_assert(bigint_from_digit(&n, 123) == 0);
+		test_assert(bigint_to_str(str, sizeof(str), n, 10) == 0);
+		test_assert(strcmp(str, "123") == 0);
+		bigint_del(n);
+	}
+}
+
+void
+test_bigint_export(void)
+{
+	{
+		bigint x, y, v;
+		uint32_t buf[4];
+		size_t len;
+		test_assert(bigint_init(&x, -1, (uint32_t[]){5, 6}, 2) == 0);
+		test_assert(bigint_export_size(x) == 12);
+		test_assert(bigint_export(buf, sizeof(buf), x) == 0);
+		test_assert(((uint8_t *)buf)[0] == 0x03);
+
+		test_assert(bigint_import(&y, &len, buf, sizeof(buf)) == 0);
+		test_assert(len == 12);
+		test_assert(bigint_eq(x, y));
+		bigint_del(y);
+
+		test_assert(bigint_import_view(&v, &len, buf, sizeof(buf)) == 0);
+		test_assert(len == 12);
+		test_assert(v.abs.digits == buf + 1);
+		test_assert(bigint_eq(x, v));
+
+		/* bignatとしては読めない */
+		test_assert(bignat_import(&v.abs, &len, buf, sizeof(buf)) ==
+			    EINVAL);
+
+		bigint_del(x);
+	}
+	{
+		bigint x, y;
+		uint32_t buf[2];
+		size_t len;
+		test_assert(bigint_from_digit(&x, 9) == 0);
+		test_assert(bigint_export(buf, sizeof(buf), x) == 0);
+		test_assert(bigint_import(&y, &len, buf, sizeof(buf)) == 0);
+		test_assert(y.sign == 1);
+		test_assert(bigint_eq(x, y));
+		bigint_del(x);
+		bigint_del(y);
+	}
+	{
+		bigint x = bigint_new_zero(), y;
+		uint32_t buf[1];
+		size_t len;
+		test_assert(bigint_export(buf, sizeof(buf), x) == 0);
+		test_assert(bigint_import(&y, &len, buf, sizeof(buf)) == 0);
+		test_assert(y.sign == 0);
+		bigint_del(y);
+
+		/* 負の0 */
+		memcpy(buf, "\x03\x00\x00\x00", 4);
+		test_assert(bigint_import(&y, &len, buf, sizeof(buf)) == EINVAL);
+
+		/* 最短でない桁数の符号 */
+		memcpy(buf, "\x03\x80\x00\x00", 4);
+		test_assert(bigint_import(&y, &len, buf, sizeof(buf)) == EINVAL);
+		test_assert(bigint_import_view(&y, &len, buf, sizeof(buf)) ==
+			    EINVAL);
+	}
+}
+
 void
 test_bigint_del(void)
 {
@@ -2136,81 +5603,158 @@ test_bigint_add(void)
 		test_assert(bigint_from_digit(&y, -3) == 0);
 		test_assert(bigint_from_digit(&expected, -2) == 0);
 
-		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_eq(sum, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(sum);
+		bigint_del(expected);
+	}
+	{
+		bigint x, y, sum, expected;
+		test_assert(bigint_from_digit(&x, -3) == 0);
+		test_assert(bigint_from_digit(&y, 1) == 0);
+		test_assert(bigint_from_digit(&expected, -2) == 0);
+
+		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_eq(sum, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(sum);
+		bigint_del(expected);
+	}
+	{
+		bigint x, y, sum, expected;
+		test_assert(bigint_from_digit(&x, -1) == 0);
+		test_assert(bigint_from_digit(&y, 3) == 0);
+		test_assert(bigint_from_digit(&expected, 2) == 0);
+
+		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_eq(sum, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(sum);
+		bigint_del(expected);
+	}
+	{
+		bigint x, y, sum, expected;
+		test_assert(bigint_from_digit(&x, 3) == 0);
+		test_assert(bigint_from_digit(&y, -1) == 0);
+		test_assert(bigint_from_digit(&expected, 2) == 0);
+
+		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_eq(sum, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(sum);
+		bigint_del(expected);
+	}
+	{
+		bigint x, y, sum, expected;
+		test_assert(bigint_from_digit(&x, -1) == 0);
+		test_assert(bigint_from_digit(&y, 1) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_eq(sum, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(sum);
+		bigint_del(expected);
+	}
+	{
+		bigint x, y, sum, expected;
+		test_assert(bigint_from_digit(&x, 1) == 0);
+		test_assert(bigint_from_digit(&y, -1) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_eq(sum, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(sum);
+		bigint_del(expected);
+	}
+}
+
+void
+test_bigint_add_digit(void)
+{
+	{
+		bigint x, sum, expected;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_add_digit(&sum, x, 0) == 0);
 		test_assert(bigint_eq(sum, expected));
 
 		bigint_del(x);
-		bigint_del(y);
 		bigint_del(sum);
 		bigint_del(expected);
 	}
 	{
-		bigint x, y, sum, expected;
-		test_assert(bigint_from_digit(&x, -3) == 0);
-		test_assert(bigint_from_digit(&y, 1) == 0);
-		test_assert(bigint_from_digit(&expected, -2) == 0);
+		bigint x, sum, expected;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&expected, 5) == 0);
 
-		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_add_digit(&sum, x, 3) == 0);
 		test_assert(bigint_eq(sum, expected));
 
 		bigint_del(x);
-		bigint_del(y);
 		bigint_del(sum);
 		bigint_del(expected);
 	}
 	{
-		bigint x, y, sum, expected;
-		test_assert(bigint_from_digit(&x, -1) == 0);
-		test_assert(bigint_from_digit(&y, 3) == 0);
-		test_assert(bigint_from_digit(&expected, 2) == 0);
+		bigint x, sum, expected;
+		test_assert(bigint_from_digit(&x, -2) == 0);
+		test_assert(bigint_from_digit(&expected, 1) == 0);
 
-		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_add_digit(&sum, x, 3) == 0);
 		test_assert(bigint_eq(sum, expected));
 
 		bigint_del(x);
-		bigint_del(y);
 		bigint_del(sum);
 		bigint_del(expected);
 	}
 	{
-		bigint x, y, sum, expected;
-		test_assert(bigint_from_digit(&x, 3) == 0);
-		test_assert(bigint_from_digit(&y, -1) == 0);
-		test_assert(bigint_from_digit(&expected, 2) == 0);
+		bigint x, sum, expected;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&expected, -1) == 0);
 
-		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_add_digit(&sum, x, -3) == 0);
 		test_assert(bigint_eq(sum, expected));
 
 		bigint_del(x);
-		bigint_del(y);
 		bigint_del(sum);
 		bigint_del(expected);
 	}
 	{
-		bigint x, y, sum, expected;
-		test_assert(bigint_from_digit(&x, -1) == 0);
-		test_assert(bigint_from_digit(&y, 1) == 0);
-		test_assert(bigint_from_digit(&expected, 0) == 0);
+		bigint x, sum, expected;
+		test_assert(bigint_from_digit(&x, -2) == 0);
+		test_assert(bigint_from_digit(&expected, -5) == 0);
 
-		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_add_digit(&sum, x, -3) == 0);
 		test_assert(bigint_eq(sum, expected));
 
 		bigint_del(x);
-		bigint_del(y);
 		bigint_del(sum);
 		bigint_del(expected);
 	}
 	{
-		bigint x, y, sum, expected;
-		test_assert(bigint_from_digit(&x, 1) == 0);
-		test_assert(bigint_from_digit(&y, -1) == 0);
+		bigint x, sum, expected;
+		test_assert(bigint_from_digit(&x, 5) == 0);
 		test_assert(bigint_from_digit(&expected, 0) == 0);
 
-		test_assert(bigint_add(&sum, x, y) == 0);
+		test_assert(bigint_add_digit(&sum, x, -5) == 0);
 		test_assert(bigint_eq(sum, expected));
 
 		bigint_del(x);
-		bigint_del(y);
 		bigint_del(sum);
 		bigint_del(expected);
 	}
@@ -2403,6 +5947,83 @@ test_bigint_sub(void)
 	}
 }
 
+void
+test_bigint_sub_digit(void)
+{
+	{
+		bigint x, diff, expected;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_sub_digit(&diff, x, 0) == 0);
+		test_assert(bigint_eq(diff, expected));
+
+		bigint_del(x);
+		bigint_del(diff);
+		bigint_del(expected);
+	}
+	{
+		bigint x, diff, expected;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&expected, -1) == 0);
+
+		test_assert(bigint_sub_digit(&diff, x, 3) == 0);
+		test_assert(bigint_eq(diff, expected));
+
+		bigint_del(x);
+		bigint_del(diff);
+		bigint_del(expected);
+	}
+	{
+		bigint x, diff, expected;
+		test_assert(bigint_from_digit(&x, -2) == 0);
+		test_assert(bigint_from_digit(&expected, -5) == 0);
+
+		test_assert(bigint_sub_digit(&diff, x, 3) == 0);
+		test_assert(bigint_eq(diff, expected));
+
+		bigint_del(x);
+		bigint_del(diff);
+		bigint_del(expected);
+	}
+	{
+		bigint x, diff, expected;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&expected, 5) == 0);
+
+		test_assert(bigint_sub_digit(&diff, x, -3) == 0);
+		test_assert(bigint_eq(diff, expected));
+
+		bigint_del(x);
+		bigint_del(diff);
+		bigint_del(expected);
+	}
+	{
+		bigint x, diff, expected;
+		test_assert(bigint_from_digit(&x, -2) == 0);
+		test_assert(bigint_from_digit(&expected, 1) == 0);
+
+		test_assert(bigint_sub_digit(&diff, x, -3) == 0);
+		test_assert(bigint_eq(diff, expected));
+
+		bigint_del(x);
+		bigint_del(diff);
+		bigint_del(expected);
+	}
+	{
+		bigint x, diff, expected;
+		test_assert(bigint_from_digit(&x, 5) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_sub_digit(&diff, x, 5) == 0);
+		test_assert(bigint_eq(diff, expected));
+
+		bigint_del(x);
+		bigint_del(diff);
+		bigint_del(expected);
+	}
+}
+
 void
 test_bigint_mul(void)
 {
@@ -2561,31 +6182,262 @@ test_bigint_mul(void)
 		bigint_del(expected);
 	}
 	{
-		bigint x, y, prod, expected;
-		test_assert(bigint_from_digit(&x, -2) == 0);
-		test_assert(bigint_from_digit(&y, 3) == 0);
-		test_assert(bigint_from_digit(&expected, -6) == 0);
+		bigint x, y, prod, expected;
+		test_assert(bigint_from_digit(&x, -2) == 0);
+		test_assert(bigint_from_digit(&y, 3) == 0);
+		test_assert(bigint_from_digit(&expected, -6) == 0);
+
+		test_assert(bigint_mul(&prod, x, y) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+	{
+		bigint x, y, prod, expected;
+		test_assert(bigint_from_digit(&x, 3) == 0);
+		test_assert(bigint_from_digit(&y, -2) == 0);
+		test_assert(bigint_from_digit(&expected, -6) == 0);
+
+		test_assert(bigint_mul(&prod, x, y) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+}
+
+void
+test_bigint_mul_digit(void)
+{
+	{
+		bigint x, prod, expected;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_mul_digit(&prod, x, -3) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+	{
+		bigint x, prod, expected;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_mul_digit(&prod, x, 0) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+	{
+		bigint x, prod, expected;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&expected, 6) == 0);
+
+		test_assert(bigint_mul_digit(&prod, x, 3) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+	{
+		bigint x, prod, expected;
+		test_assert(bigint_from_digit(&x, -2) == 0);
+		test_assert(bigint_from_digit(&expected, -6) == 0);
+
+		test_assert(bigint_mul_digit(&prod, x, 3) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+	{
+		bigint x, prod, expected;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&expected, -6) == 0);
+
+		test_assert(bigint_mul_digit(&prod, x, -3) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+	{
+		bigint x, prod, expected;
+		test_assert(bigint_from_digit(&x, -2) == 0);
+		test_assert(bigint_from_digit(&expected, 6) == 0);
+
+		test_assert(bigint_mul_digit(&prod, x, -3) == 0);
+		test_assert(bigint_eq(prod, expected));
+
+		bigint_del(x);
+		bigint_del(prod);
+		bigint_del(expected);
+	}
+}
+
+void
+test_bigint_inplace(void)
+{
+	{
+		bigint acc, x, expected;
+		test_assert(bigint_from_digit(&acc, 5) == 0);
+		test_assert(bigint_from_digit(&x, -3) == 0);
+
+		test_assert(bigint_add_inplace(&acc, x) == 0);
+		test_assert(bigint_from_digit(&expected, 2) == 0);
+		test_assert(bigint_eq(acc, expected));
+		bigint_del(expected);
+
+		test_assert(bigint_add_inplace(&acc, x) == 0);
+		test_assert(bigint_from_digit(&expected, -1) == 0);
+		test_assert(bigint_eq(acc, expected));
+		bigint_del(expected);
+
+		test_assert(bigint_sub_inplace(&acc, x) == 0);
+		test_assert(bigint_from_digit(&expected, 2) == 0);
+		test_assert(bigint_eq(acc, expected));
+		bigint_del(expected);
+
+		test_assert(bigint_mul_inplace(&acc, x) == 0);
+		test_assert(bigint_from_digit(&expected, -6) == 0);
+		test_assert(bigint_eq(acc, expected));
+		bigint_del(expected);
+
+		test_assert(bigint_mul_inplace(&acc, acc) == 0);
+		test_assert(bigint_from_digit(&expected, 36) == 0);
+		test_assert(bigint_eq(acc, expected));
+		bigint_del(expected);
+
+		test_assert(bigint_sub_inplace(&acc, acc) == 0);
+		test_assert(acc.sign == 0 && acc.abs.ndigits == 0);
+
+		test_assert(bigint_add_inplace(&acc, x) == 0);
+		test_assert(bigint_eq(acc, x));
+
+		bigint_del(acc);
+		bigint_del(x);
+	}
+	{
+		bigint x, y, out, expected;
+		test_assert(bigint_from_digit(&x, 3) == 0);
+		test_assert(bigint_from_digit(&y, -5) == 0);
+		test_assert(bigint_from_digit(&out, 7) == 0);
+
+		test_assert(bigint_add_into(&out, x, y) == 0);
+		test_assert(bigint_from_digit(&expected, -2) == 0);
+		test_assert(bigint_eq(out, expected));
+		bigint_del(expected);
+
+		test_assert(bigint_sub_into(&y, x, y) == 0);
+		test_assert(bigint_from_digit(&expected, 8) == 0);
+		test_assert(bigint_eq(y, expected));
+		bigint_del(expected);
+
+		test_assert(bigint_mul_into(&out, out, y) == 0);
+		test_assert(bigint_from_digit(&expected, -16) == 0);
+		test_assert(bigint_eq(out, expected));
+		bigint_del(expected);
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(out);
+	}
+	{
+		/* 符号の組ごとにbigint_divtrnと比べる */
+		static const int32_t xs[] = {
+			17, -17, 5, -5, 0, INT32_MAX, INT32_MIN
+		};
+		static const int32_t ys[] = {5, -5, 17, -17, 1, -1};
+		bigint quot, rem;
+		test_assert(bigint_from_digit(&quot, 1) == 0);
+		test_assert(bigint_from_digit(&rem, 1) == 0);
+
+		for (size_t i = 0; i < countof(xs); i++) {
+			for (size_t j = 0; j < countof(ys); j++) {
+				bigint x, y, eq, er;
+				test_assert(bigint_from_digit(&x, xs[i]) == 0);
+				test_assert(bigint_from_digit(&y, ys[j]) == 0);
+				test_assert(bigint_divtrn(&eq, &er, x, y) == 0);
+
+				test_assert(bigint_divtrn_into(&quot, &rem, x,
+							       y) == 0);
+				test_assert(bigint_eq(quot, eq));
+				test_assert(bigint_eq(rem, er));
+
+				/* 書き込み先が入力と同じ場合 */
+				test_assert(bigint_divtrn_into(&x, &y, x, y) ==
+					    0);
+				test_assert(bigint_eq(x, eq));
+				test_assert(bigint_eq(y, er));
+
+				bigint_del(x);
+				bigint_del(y);
+				bigint_del(eq);
+				bigint_del(er);
+			}
+		}
+
+		bigint zero = bigint_new_zero();
+		test_assert(bigint_divtrn_into(&quot, &rem, quot, zero) ==
+			    EDOM);
+		test_assert(bigint_divtrn_into(&quot, &quot, rem, quot) ==
+			    EINVAL);
+
+		bigint_del(quot);
+		bigint_del(rem);
+	}
+}
+
+void
+test_bigint_sqr(void)
+{
+	{
+		bigint x, sq, expected;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_sqr(&sq, x) == 0);
+		test_assert(bigint_eq(sq, expected));
+
+		bigint_del(x);
+		bigint_del(sq);
+		bigint_del(expected);
+	}
+	{
+		bigint x, sq, expected;
+		test_assert(bigint_from_digit(&x, 5) == 0);
+		test_assert(bigint_from_digit(&expected, 25) == 0);
 
-		test_assert(bigint_mul(&prod, x, y) == 0);
-		test_assert(bigint_eq(prod, expected));
+		test_assert(bigint_sqr(&sq, x) == 0);
+		test_assert(bigint_eq(sq, expected));
 
 		bigint_del(x);
-		bigint_del(y);
-		bigint_del(prod);
+		bigint_del(sq);
 		bigint_del(expected);
 	}
 	{
-		bigint x, y, prod, expected;
-		test_assert(bigint_from_digit(&x, 3) == 0);
-		test_assert(bigint_from_digit(&y, -2) == 0);
-		test_assert(bigint_from_digit(&expected, -6) == 0);
+		bigint x, sq, expected;
+		test_assert(bigint_from_digit(&x, -5) == 0);
+		test_assert(bigint_from_digit(&expected, 25) == 0);
 
-		test_assert(bigint_mul(&prod, x, y) == 0);
-		test_assert(bigint_eq(prod, expected));
+		test_assert(bigint_sqr(&sq, x) == 0);
+		test_assert(bigint_eq(sq, expected));
 
 		bigint_del(x);
-		bigint_del(y);
-		bigint_del(prod);
+		bigint_del(sq);
 		bigint_del(expected);
 	}
 }
@@ -2849,6 +6701,118 @@ test_bigint_divtrn(void)
 	}
 }
 
+void
+test_bigint_divtrn_digit(void)
+{
+	{
+		bigint x, quot;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, 1) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, 0) == EDOM);
+
+		bigint_del(x);
+	}
+	{
+		bigint x, quot, expected;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, 1) == 0);
+		test_assert(bigint_eq(quot, expected));
+		test_assert(rem == 0);
+
+		bigint_del(x);
+		bigint_del(quot);
+		bigint_del(expected);
+	}
+	{
+		bigint x, quot, expected;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, 7) == 0);
+		test_assert(bigint_from_digit(&expected, 3) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, 2) == 0);
+		test_assert(bigint_eq(quot, expected));
+		test_assert(rem == 1);
+
+		bigint_del(x);
+		bigint_del(quot);
+		bigint_del(expected);
+	}
+	{
+		bigint x, quot, expected;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, -7) == 0);
+		test_assert(bigint_from_digit(&expected, -3) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, 2) == 0);
+		test_assert(bigint_eq(quot, expected));
+		test_assert(rem == -1);
+
+		bigint_del(x);
+		bigint_del(quot);
+		bigint_del(expected);
+	}
+	{
+		bigint x, quot, expected;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, 7) == 0);
+		test_assert(bigint_from_digit(&expected, -3) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, -2) == 0);
+		test_assert(bigint_eq(quot, expected));
+		test_assert(rem == 1);
+
+		bigint_del(x);
+		bigint_del(quot);
+		bigint_del(expected);
+	}
+	{
+		bigint x, quot, expected;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, -7) == 0);
+		test_assert(bigint_from_digit(&expected, 3) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, -2) == 0);
+		test_assert(bigint_eq(quot, expected));
+		test_assert(rem == -1);
+
+		bigint_del(x);
+		bigint_del(quot);
+		bigint_del(expected);
+	}
+	{
+		bigint x, quot, expected;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, 1) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, 2) == 0);
+		test_assert(bigint_eq(quot, expected));
+		test_assert(rem == 1);
+
+		bigint_del(x);
+		bigint_del(quot);
+		bigint_del(expected);
+	}
+	{
+		bigint x, quot, expected;
+		int32_t rem;
+		test_assert(bigint_from_digit(&x, -2147483647) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_divtrn_digit(&quot, &rem, x, INT32_MIN) == 0);
+		test_assert(bigint_eq(quot, expected));
+		test_assert(rem == -2147483647);
+
+		bigint_del(x);
+		bigint_del(quot);
+		bigint_del(expected);
+	}
+}
+
 void
 test_bigint_divflr(void)
 {
@@ -3367,6 +7331,373 @@ test_bigint_diveuc(void)
 	}
 }
 
+void
+test_bigint_gcdext(void)
+{
+	{
+		bigint x, y, gcd, s, t, expected_gcd, expected_s, expected_t;
+		test_assert(bigint_from_digit(&x, -12) == 0);
+		test_assert(bigint_from_digit(&y, 30) == 0);
+		test_assert(bigint_from_digit(&expected_gcd, 6) == 0);
+		test_assert(bigint_from_digit(&expected_s, -3) == 0);
+		test_assert(bigint_from_digit(&expected_t, -1) == 0);
+
+		test_assert(bigint_gcdext(&gcd, &s, &t, x, y) == 0);
+		test_assert(bigint_eq(gcd, expected_gcd));
+		test_assert(bigint_eq(s, expected_s));
+		test_assert(bigint_eq(t, expected_t));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(gcd);
+		bigint_del(s);
+		bigint_del(t);
+		bigint_del(expected_gcd);
+		bigint_del(expected_s);
+		bigint_del(expected_t);
+	}
+	{
+		bigint x, y, gcd, s, t, expected_gcd, expected_s, expected_t;
+		test_assert(bigint_from_digit(&x, 12) == 0);
+		test_assert(bigint_from_digit(&y, -30) == 0);
+		test_assert(bigint_from_digit(&expected_gcd, 6) == 0);
+		test_assert(bigint_from_digit(&expected_s, 3) == 0);
+		test_assert(bigint_from_digit(&expected_t, 1) == 0);
+
+		test_assert(bigint_gcdext(&gcd, &s, &t, x, y) == 0);
+		test_assert(bigint_eq(gcd, expected_gcd));
+		test_assert(bigint_eq(s, expected_s));
+		test_assert(bigint_eq(t, expected_t));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(gcd);
+		bigint_del(s);
+		bigint_del(t);
+		bigint_del(expected_gcd);
+		bigint_del(expected_s);
+		bigint_del(expected_t);
+	}
+	{
+		bigint x, y, gcd, s, t, expected_gcd, expected_s, expected_t;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&y, -7) == 0);
+		test_assert(bigint_from_digit(&expected_gcd, 7) == 0);
+		test_assert(bigint_from_digit(&expected_s, 0) == 0);
+		test_assert(bigint_from_digit(&expected_t, -1) == 0);
+
+		test_assert(bigint_gcdext(&gcd, &s, &t, x, y) == 0);
+		test_assert(bigint_eq(gcd, expected_gcd));
+		test_assert(bigint_eq(s, expected_s));
+		test_assert(bigint_eq(t, expected_t));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(gcd);
+		bigint_del(s);
+		bigint_del(t);
+		bigint_del(expected_gcd);
+		bigint_del(expected_s);
+		bigint_del(expected_t);
+	}
+	{
+		bigint x, y, gcd, s, t, expected_gcd, expected_s, expected_t;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&y, 0) == 0);
+		test_assert(bigint_from_digit(&expected_gcd, 0) == 0);
+		test_assert(bigint_from_digit(&expected_s, 0) == 0);
+		test_assert(bigint_from_digit(&expected_t, 0) == 0);
+
+		test_assert(bigint_gcdext(&gcd, &s, &t, x, y) == 0);
+		test_assert(bigint_eq(gcd, expected_gcd));
+		test_assert(bigint_eq(s, expected_s));
+		test_assert(bigint_eq(t, expected_t));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(gcd);
+		bigint_del(s);
+		bigint_del(t);
+		bigint_del(expected_gcd);
+		bigint_del(expected_s);
+		bigint_del(expected_t);
+	}
+	{
+		bigint x, y, gcd, s, t, expected_gcd, expected_s, expected_t;
+		test_assert(bigint_from_digit(&x, -5) == 0);
+		test_assert(bigint_from_digit(&y, 0) == 0);
+		test_assert(bigint_from_digit(&expected_gcd, 5) == 0);
+		test_assert(bigint_from_digit(&expected_s, -1) == 0);
+		test_assert(bigint_from_digit(&expected_t, 0) == 0);
+
+		test_assert(bigint_gcdext(&gcd, &s, &t, x, y) == 0);
+		test_assert(bigint_eq(gcd, expected_gcd));
+		test_assert(bigint_eq(s, expected_s));
+		test_assert(bigint_eq(t, expected_t));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(gcd);
+		bigint_del(s);
+		bigint_del(t);
+		bigint_del(expected_gcd);
+		bigint_del(expected_s);
+		bigint_del(expected_t);
+	}
+	{
+		bigint x, y, gcd, s, t, expected_gcd, expected_s, expected_t;
+		test_assert(bigint_from_digit(&x, 240) == 0);
+		test_assert(bigint_from_digit(&y, 46) == 0);
+		test_assert(bigint_from_digit(&expected_gcd, 2) == 0);
+		test_assert(bigint_from_digit(&expected_s, 14) == 0);
+		test_assert(bigint_from_digit(&expected_t, -73) == 0);
+
+		test_assert(bigint_gcdext(&gcd, &s, &t, x, y) == 0);
+		test_assert(bigint_eq(gcd, expected_gcd));
+		test_assert(bigint_eq(s, expected_s));
+		test_assert(bigint_eq(t, expected_t));
+
+		bigint_del(x);
+		bigint_del(y);
+		bigint_del(gcd);
+		bigint_del(s);
+		bigint_del(t);
+		bigint_del(expected_gcd);
+		bigint_del(expected_s);
+		bigint_del(expected_t);
+	}
+}
+
+void
+test_bigint_invmod(void)
+{
+	{
+		bigint x, m, inv, expected;
+		test_assert(bigint_from_digit(&x, 3) == 0);
+		test_assert(bigint_from_digit(&m, 7) == 0);
+		test_assert(bigint_from_digit(&expected, 5) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == 0);
+		test_assert(bigint_eq(inv, expected));
+
+		bigint_del(x);
+		bigint_del(m);
+		bigint_del(inv);
+		bigint_del(expected);
+	}
+	{
+		bigint x, m, inv, expected;
+		test_assert(bigint_from_digit(&x, -3) == 0);
+		test_assert(bigint_from_digit(&m, 7) == 0);
+		test_assert(bigint_from_digit(&expected, 2) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == 0);
+		test_assert(bigint_eq(inv, expected));
+
+		bigint_del(x);
+		bigint_del(m);
+		bigint_del(inv);
+		bigint_del(expected);
+	}
+	{
+		bigint x, m, inv, expected;
+		test_assert(bigint_from_digit(&x, 3) == 0);
+		test_assert(bigint_from_digit(&m, -7) == 0);
+		test_assert(bigint_from_digit(&expected, 5) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == 0);
+		test_assert(bigint_eq(inv, expected));
+
+		bigint_del(x);
+		bigint_del(m);
+		bigint_del(inv);
+		bigint_del(expected);
+	}
+	{
+		bigint x, m, inv, expected;
+		test_assert(bigint_from_digit(&x, 10) == 0);
+		test_assert(bigint_from_digit(&m, 7) == 0);
+		test_assert(bigint_from_digit(&expected, 5) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == 0);
+		test_assert(bigint_eq(inv, expected));
+
+		bigint_del(x);
+		bigint_del(m);
+		bigint_del(inv);
+		bigint_del(expected);
+	}
+	{
+		bigint x, m, inv, expected;
+		test_assert(bigint_from_digit(&x, 5) == 0);
+		test_assert(bigint_from_digit(&m, 1) == 0);
+		test_assert(bigint_from_digit(&expected, 0) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == 0);
+		test_assert(bigint_eq(inv, expected));
+
+		bigint_del(x);
+		bigint_del(m);
+		bigint_del(inv);
+		bigint_del(expected);
+	}
+	{
+		bigint x, m, inv;
+		test_assert(bigint_from_digit(&x, 2) == 0);
+		test_assert(bigint_from_digit(&m, 4) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == EDOM);
+
+		bigint_del(x);
+		bigint_del(m);
+	}
+	{
+		bigint x, m, inv;
+		test_assert(bigint_from_digit(&x, 3) == 0);
+		test_assert(bigint_from_digit(&m, 0) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == EDOM);
+
+		bigint_del(x);
+		bigint_del(m);
+	}
+	{
+		bigint x, m, inv;
+		test_assert(bigint_from_digit(&x, 0) == 0);
+		test_assert(bigint_from_digit(&m, 5) == 0);
+
+		test_assert(bigint_invmod(&inv, x, m) == EDOM);
+
+		bigint_del(x);
+		bigint_del(m);
+	}
+}
+
+void
+test_bigint_powm(void)
+{
+	{
+		bigint base, exp, mod, powm, expected;
+		test_assert(bigint_from_digit(&base, -2) == 0);
+		test_assert(bigint_from_digit(&exp, 3) == 0);
+		test_assert(bigint_from_digit(&mod, 5) == 0);
+		test_assert(bigint_from_digit(&expected, 2) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == 0);
+		test_assert(bigint_eq(powm, expected));
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+		bigint_del(powm);
+		bigint_del(expected);
+	}
+	{
+		bigint base, exp, mod, powm, expected;
+		test_assert(bigint_from_digit(&base, -2) == 0);
+		test_assert(bigint_from_digit(&exp, 2) == 0);
+		test_assert(bigint_from_digit(&mod, -5) == 0);
+		test_assert(bigint_from_digit(&expected, 4) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == 0);
+		test_assert(bigint_eq(powm, expected));
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+		bigint_del(powm);
+		bigint_del(expected);
+	}
+	{
+		bigint base, exp, mod, powm, expected;
+		test_assert(bigint_from_digit(&base, 3) == 0);
+		test_assert(bigint_from_digit(&exp, -1) == 0);
+		test_assert(bigint_from_digit(&mod, 7) == 0);
+		test_assert(bigint_from_digit(&expected, 5) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == 0);
+		test_assert(bigint_eq(powm, expected));
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+		bigint_del(powm);
+		bigint_del(expected);
+	}
+	{
+		bigint base, exp, mod, powm, expected;
+		test_assert(bigint_from_digit(&base, -3) == 0);
+		test_assert(bigint_from_digit(&exp, -1) == 0);
+		test_assert(bigint_from_digit(&mod, 7) == 0);
+		test_assert(bigint_from_digit(&expected, 2) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == 0);
+		test_assert(bigint_eq(powm, expected));
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+		bigint_del(powm);
+		bigint_del(expected);
+	}
+	{
+		bigint base, exp, mod, powm, expected;
+		test_assert(bigint_from_digit(&base, 3) == 0);
+		test_assert(bigint_from_digit(&exp, -2) == 0);
+		test_assert(bigint_from_digit(&mod, -7) == 0);
+		test_assert(bigint_from_digit(&expected, 4) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == 0);
+		test_assert(bigint_eq(powm, expected));
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+		bigint_del(powm);
+		bigint_del(expected);
+	}
+	{
+		bigint base, exp, mod, powm, expected;
+		test_assert(bigint_from_digit(&base, -4) == 0);
+		test_assert(bigint_from_digit(&exp, 0) == 0);
+		test_assert(bigint_from_digit(&mod, 7) == 0);
+		test_assert(bigint_from_digit(&expected, 1) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == 0);
+		test_assert(bigint_eq(powm, expected));
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+		bigint_del(powm);
+		bigint_del(expected);
+	}
+	{
+		bigint base, exp, mod, powm;
+		test_assert(bigint_from_digit(&base, 2) == 0);
+		test_assert(bigint_from_digit(&exp, -1) == 0);
+		test_assert(bigint_from_digit(&mod, 4) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == EDOM);
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+	}
+	{
+		bigint base, exp, mod, powm;
+		test_assert(bigint_from_digit(&base, 3) == 0);
+		test_assert(bigint_from_digit(&exp, 2) == 0);
+		test_assert(bigint_from_digit(&mod, 0) == 0);
+
+		test_assert(bigint_powm(&powm, base, exp, mod) == EDOM);
+
+		bigint_del(base);
+		bigint_del(exp);
+		bigint_del(mod);
+	}
+}
+
 void
 test_bigrat_init(void)
 {
@@ -3708,6 +8039,147 @@ test_bigrat_copy(void)
 	}
 }
 
+void
+test_bigrat_from_str(void)
+{
+	{
+		bigrat r;
+		test_assert(bigrat_from_str(&r, "-6/4", 10) == 0);
+		test_assert(r.nume.sign == -1);
+		test_assert(r.nume.abs.ndigits == 1);
+		test_assert(r.nume.abs.digits[0] == 3);
+		test_assert(r.deno.sign == 1);
+		test_assert(r.deno.abs.ndigits == 1);
+		test_assert(r.deno.abs.digits[0] == 2);
+		bigrat_del(r);
+	}
+	{
+		bigrat r;
+		test_assert(bigrat_from_str(&r, "5", 10) == 0);
+		test_assert(r.nume.sign == 1);
+		test_assert(r.nume.abs.ndigits == 1);
+		test_assert(r.nume.abs.digits[0] == 5);
+		test_assert(r.deno.sign == 1);
+		test_assert(r.deno.abs.ndigits == 1);
+		test_assert(r.deno.abs.digits[0] == 1);
+		bigrat_del(r);
+	}
+	{
+		bigrat r;
+		test_assert(bigrat_from_str(&r, "0/7", 10) == 0);
+		test_assert(r.nume.sign == 0);
+		test_assert(r.deno.sign == 1);
+		test_assert(r.deno.abs.ndigits == 1);
+		test_assert(r.deno.abs.digits[0] == 1);
+		bigrat_del(r);
+	}
+	{
+		bigrat r;
+		test_assert(bigrat_from_str(&r, "FF/3", 16) == 0);
+		test_assert(r.nume.sign == 1);
+		test_assert(r.nume.abs.ndigits == 1);
+		test_assert(r.nume.abs.digits[0] == 85);
+		test_assert(r.deno.sign == 1);
+		test_assert(r.deno.abs.ndigits == 1);
+		test_assert(r.deno.abs.digits[0] == 1);
+		bigrat_del(r);
+	}
+	{
+		bigrat r;
+		test_assert(bigrat_from_str(&r, "1/0", 10) == EINVAL);
+		test_assert(bigrat_from_str(&r, "1/-2", 10) == EINVAL);
+		test_assert(bigrat_from_str(&r, "1/", 10) == EINVAL);
+		test_assert(bigrat_from_str(&r, "/2", 10) == EINVAL);
+		test_assert(bigrat_from_str(&r, "1/2/3", 10) == EINVAL);
+		test_assert(bigrat_from_str(&r, "1/2", 40) == EINVAL);
+	}
+}
+
+void
+test_bigrat_to_str(void)
+{
+	{
+		bigrat r;
+		char str[40];
+		test_assert(bigrat_from_digit(&r, -6, 4) == 0);
+		test_assert(bigrat_to_str(str, sizeof(str), r, 10) == 0);
+		test_assert(strcmp(str, "-3/2") == 0);
+		test_assert(bigrat_to_str(str, bigrat_str_size(r, 10) - 1, r,
+					  10) == ERANGE);
+		test_assert(bigrat_to_str(str, sizeof(str), r, 37) == EINVAL);
+		bigrat_del(r);
+	}
+	{
+		bigrat r;
+		char str[40];
+		test_assert(bigrat_from_digit(&r, 0, -5) == 0);
+		test_assert(bigrat_to_str(str, sizeof(str), r, 10) == 0);
+		test_assert(strcmp(str, "0/1") == 0);
+		bigrat_del(r);
+	}
+	{
+		bigrat r;
+		char str[40];
+		test_assert(bigrat_from_str(&r, "ff/2", 16) == 0);
+		test_assert(bigrat_to_str(str, sizeof(str), r, 16) == 0);
+		test_assert(strcmp(str, "ff/2") == 0);
+		test_assert(bigrat_to_str(str, sizeof(str), r, 10) == 0);
+		test_assert(strcmp(str, "255/2") == 0);
+		bigrat_del(r);
+	}
+}
+
+void
+test_bigrat_export(void)
+{
+	{
+		/* 複数の記録を続けて並べる */
+		bigrat x, y, z, v;
+		uint32_t buf[8];
+		size_t len, off;
+		test_assert(bigrat_from_digit(&x, -3, 4) == 0);
+		test_assert(bigrat_from_digit(&y, 5, 1) == 0);
+		test_assert(bigrat_export_size(x) == 16);
+		test_assert(bigrat_export(buf, 15, x) == ERANGE);
+		test_assert(bigrat_export(buf, sizeof(buf), x) == 0);
+		test_assert(bigrat_export(buf + 4, sizeof(buf) - 16, y) == 0);
+
+		test_assert(bigrat_import(&z, &len, buf, sizeof(buf)) == 0);
+		test_assert(len == 16);
+		test_assert(z.nume.sign == -1);
+		test_assert(z.nume.abs.digits[0] == 3);
+		test_assert(z.deno.sign == 1);
+		test_assert(z.deno.abs.digits[0] == 4);
+		bigrat_del(z);
+
+		off = 0;
+		test_assert(bigrat_import_view(&v, &len, buf, sizeof(buf)) == 0);
+		test_assert(v.nume.abs.digits == buf + 1);
+		test_assert(v.deno.abs.digits == buf + 3);
+		off += len;
+		test_assert(bigrat_import_view(&v, &len, (uint8_t *)buf + off,
+					       sizeof(buf) - off) == 0);
+		test_assert(len == 16);
+		test_assert(v.nume.sign == 1);
+		test_assert(v.nume.abs.digits[0] == 5);
+		test_assert(v.deno.abs.digits[0] == 1);
+
+		bigrat_del(x);
+		bigrat_del(y);
+	}
+	{
+		/* 分母が0 */
+		bigrat z;
+		uint32_t buf[3];
+		size_t len;
+		memcpy(buf, "\x02\x01\x00\x00\x01\x00\x00\x00\x02\x00\x00\x00",
+		       12);
+		test_assert(bigrat_import(&z, &len, buf, sizeof(buf)) == EINVAL);
+		test_assert(bigrat_import_view(&z, &len, buf, sizeof(buf)) ==
+			    EINVAL);
+	}
+}
+
 void
 test_bigrat_del(void)
 {
@@ -6431,6 +10903,10 @@ main(int argc, char **argv)
 	test_dgtvec_del();
 	test_dgtvec_push();
 	test_dgtvec_pop();
+	test_dgtvec_resize();
+	test_dgtvec_flush_cache();
+	test_bignum_set_allocator();
+	test_bignum_arena();
 
 	/* bignat */
 	test_bignat_view();
@@ -6438,6 +10914,9 @@ main(int argc, char **argv)
 	test_bignat_new_zero();
 	test_bignat_from_digit();
 	test_bignat_copy();
+	test_bignat_from_str();
+	test_bignat_to_str();
+	test_bignat_export();
 	test_bignat_del();
 	test_bignat_cmp();
 	test_bignat_eq();
@@ -6447,10 +10926,23 @@ main(int argc, char **argv)
 	test_bignat_le();
 	test_bignat_ge();
 	test_bignat_add();
+	test_bignat_add_digit();
 	test_bignat_sub();
+	test_bignat_sub_digit();
 	test_bignat_mul();
+	test_bignat_mul_digit();
+	test_bignat_inplace();
+	test_bignat_into();
+	test_bignat_sqr();
 	test_bignat_divmod();
+	test_bignat_divmod_digit();
+	test_bignat_invert();
 	test_bignat_gcd();
+	test_bignat_gcdext();
+	test_bignat_powm();
+	test_bignat_powm_sec();
+	test_bignat_mont();
+	test_bignat_barrett();
 
 	/* bigint */
 	test_bigint_view();
@@ -6458,6 +10950,9 @@ main(int argc, char **argv)
 	test_bigint_new_zero();
 	test_bigint_from_digit();
 	test_bigint_copy();
+	test_bigint_from_str();
+	test_bigint_to_str();
+	test_bigint_export();
 	test_bigint_del();
 	test_bigint_cmp();
 	test_bigint_eq();
@@ -6467,16 +10962,28 @@ main(int argc, char **argv)
 	test_bigint_le();
 	test_bigint_ge();
 	test_bigint_add();
+	test_bigint_add_digit();
 	test_bigint_sub();
+	test_bigint_sub_digit();
 	test_bigint_mul();
+	test_bigint_mul_digit();
+	test_bigint_inplace();
+	test_bigint_sqr();
 	test_bigint_divtrn();
+	test_bigint_divtrn_digit();
 	test_bigint_divflr();
 	test_bigint_diveuc();
+	test_bigint_gcdext();
+	test_bigint_invmod();
+	test_bigint_powm();
 
 	/* bigrat */
 	test_bigrat_init();
 	test_bigrat_from_digit();
 	test_bigrat_copy();
+	test_bigrat_from_str();
+	test_bigrat_to_str();
+	test_bigrat_export();
 	test_bigrat_del();
 	test_bigrat_cmp();
 	test_bigrat_eq();